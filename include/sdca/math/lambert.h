@@ -1,9 +1,27 @@
 #ifndef SDCA_MATH_LAMBERT_H
 #define SDCA_MATH_LAMBERT_H
 
+#include <algorithm>
 #include <cmath>
 #include <limits>
 
+#include "sdca/utility/types.h"
+
+/*
+ * The array versions of lambert_w_exp are compiled for AVX-512, AVX2 and
+ * the baseline instruction set, and the best one is selected at run time
+ * (GCC function multiversioning on x86-64 Linux), so that the loops are
+ * vectorized with the wide glibc exp/log even in a generic release build.
+ * Define SDCA_NO_TARGET_CLONES to compile the baseline version only.
+ */
+#if !defined(SDCA_NO_TARGET_CLONES) && defined(__GNUC__) && \
+    !defined(__clang__) && defined(__x86_64__) && defined(__linux__)
+#define SDCA_TARGET_CLONES \
+  __attribute__((target_clones("avx512f", "avx2", "default")))
+#else
+#define SDCA_TARGET_CLONES
+#endif
+
 namespace sdca {
 
 /**
@@ -202,6 +220,76 @@ lambert_w_exp(
   return lambert_w_iter_5(w, std::exp(x - w));
 }
 
+/**
+ * Lambert W function of exp(x) for the n values X,
+ *    W[k] = W(exp(X[k])),
+ * with the same intervals and error bounds as lambert_w_exp(float).
+ * The intervals are selected per value (not branched on), so that every
+ * value takes one log, one exp and the Householder iterations and the loop
+ * can be vectorized by the compiler (std::exp and std::log have vector
+ * variants in glibc with -ffast-math). X and W may be the same array.
+ **/
+SDCA_TARGET_CLONES
+inline void
+lambert_w_exp(
+    const size_type n,
+    const float* X,
+    float* W
+  ) {
+  for (size_type k = 0; k < n; ++k) {
+    const float x = X[k];
+    const float log_x = std::log(std::max(x, 1.0f));
+    const float w0 = (x > 8) ? x - log_x : (x > -1) ? x : exp_approx(x);
+    const float y0 = (x > 8) ? x : 1.0f;
+    const float w1 = (x > -1) ? lambert_w_iter_5(w0, y0) : w0;
+    const float e = std::exp(x - ((x > -18) ? w1 : 0.0f));
+    const float w2 = lambert_w_iter_5(w1, e);
+    const float e0 = (x > -104) ? e : 0.0f;
+    W[k] = (x > 536870912) ? x : (x > 8) ? w1 : (x > -18) ? w2 : e0;
+  }
+}
+
+/**
+ * Lambert W function of exp(x) for the n values X,
+ *    W[k] = W(exp(X[k])),
+ * with the same intervals and error bounds as lambert_w_exp(double);
+ * see lambert_w_exp(n, X, W) for float.
+ **/
+SDCA_TARGET_CLONES
+inline void
+lambert_w_exp(
+    const size_type n,
+    const double* X,
+    double* W
+  ) {
+  for (size_type k = 0; k < n; ++k) {
+    const double x = X[k];
+    const double log_x = std::log(std::max(x, 1.0));
+    const double w0 = (x > 4) ? x - log_x : (x > 0) ? x : exp_approx(x);
+    const double y0 = (x > 4) ? x : (x > 0) ? 1.0 : exp_approx(x - w0);
+    const double w1 = (x > -20) ? lambert_w_iter_5(w0, y0) : w0;
+    const double e = std::exp(x - ((x > -36) ? w1 : 0.0));
+    const double w2 = lambert_w_iter_5(w1, e);
+    const double e0 = (x > -746) ? e : 0.0;
+    W[k] = (x > 576460752303423488.0) ? x : (x > -36) ? w2 : e0;
+  }
+}
+
+/**
+ * Lambert W function of exp(x) for the n values X (generic version).
+ **/
+template <typename Type>
+inline void
+lambert_w_exp(
+    const size_type n,
+    const Type* X,
+    Type* W
+  ) {
+  for (size_type k = 0; k < n; ++k) {
+    W[k] = lambert_w_exp(X[k]);
+  }
+}
+
 /**
  * Inverse of the Lambert W function of exp(x).
  * Computes
@@ -214,6 +302,33 @@ lambert_w_exp_inverse(const Type w) {
 }
 
 
+/**
+ * Computes v_i = W(exp(a_i + t)) in blocks with the array version of
+ * lambert_w_exp and calls f(n, v) for each block of n values.
+ **/
+template <typename Type,
+          typename Iterator,
+          typename Function>
+inline void
+lambert_w_exp_blocks(
+    Iterator first,
+    const Iterator last,
+    const Type t,
+    Function f
+  ) {
+  const size_type block_size = 64;
+  Type v[block_size];
+  while (first != last) {
+    size_type n = 0;
+    for (; n < block_size && first != last; ++n, ++first) {
+      v[n] = static_cast<Type>(*first) + t;
+    }
+    lambert_w_exp(n, v, v);
+    f(n, v);
+  }
+}
+
+
 /**
  * Evaluates the function
  *    f0 = f(t) = sum_i W(exp(a_i + t))
@@ -230,9 +345,14 @@ sum_lambert_w_exp(
     const Type t,
     Type& f0
   ) {
-  for (auto a = first; a != last; ++a) {
-    f0 += lambert_w_exp(static_cast<Type>(*a) + t);
-  }
+  lambert_w_exp_blocks(first, last, t,
+    [&](const size_type n, const Type* v) {
+      Type s0(0);
+      for (size_type k = 0; k < n; ++k) {
+        s0 += v[k];
+      }
+      f0 += s0;
+    });
 }
 
 
@@ -257,11 +377,16 @@ sum_lambert_w_exp_derivatives(
     Type& f0,
     Type& f1
   ) {
-  for (auto a = first; a != last; ++a) {
-    Type v = lambert_w_exp(static_cast<Type>(*a) + t);
-    f0 += v;
-    f1 += v / (1 + v);
-  }
+  lambert_w_exp_blocks(first, last, t,
+    [&](const size_type n, const Type* v) {
+      Type s0(0), s1(0);
+      for (size_type k = 0; k < n; ++k) {
+        s0 += v[k];
+        s1 += v[k] / (1 + v[k]);
+      }
+      f0 += s0;
+      f1 += s1;
+    });
 }
 
 
@@ -287,13 +412,19 @@ sum_lambert_w_exp_derivatives(
     Type& f1,
     Type& f2
   ) {
-  for (auto a = first; a != last; ++a) {
-    Type v = lambert_w_exp(static_cast<Type>(*a) + t);
-    Type d = 1 + v;
-    f0 += v;
-    f1 += v / d;
-    f2 += v / (d * d * d);
-  }
+  lambert_w_exp_blocks(first, last, t,
+    [&](const size_type n, const Type* v) {
+      Type s0(0), s1(0), s2(0);
+      for (size_type k = 0; k < n; ++k) {
+        Type d = 1 + v[k];
+        s0 += v[k];
+        s1 += v[k] / d;
+        s2 += v[k] / (d * d * d);
+      }
+      f0 += s0;
+      f1 += s1;
+      f2 += s2;
+    });
 }
 
 
@@ -320,15 +451,22 @@ sum_lambert_w_exp_derivatives(
     Type& f2,
     Type& f3
   ) {
-  for (auto a = first; a != last; ++a) {
-    Type v = lambert_w_exp(static_cast<Type>(*a) + t);
-    Type d = 1 + v;
-    Type d3 = d * d * d;
-    f0 += v;
-    f1 += v / d;
-    f2 += v / d3;
-    f3 += v * (1 - 2 * v) / (d3 * d * d);
-  }
+  lambert_w_exp_blocks(first, last, t,
+    [&](const size_type n, const Type* v) {
+      Type s0(0), s1(0), s2(0), s3(0);
+      for (size_type k = 0; k < n; ++k) {
+        Type d = 1 + v[k];
+        Type d3 = d * d * d;
+        s0 += v[k];
+        s1 += v[k] / d;
+        s2 += v[k] / d3;
+        s3 += v[k] * (1 - 2 * v[k]) / (d3 * d * d);
+      }
+      f0 += s0;
+      f1 += s1;
+      f2 += s2;
+      f3 += s3;
+    });
 }
 
 }
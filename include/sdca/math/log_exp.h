@@ -3,8 +3,11 @@
 
 #include <algorithm>
 #include <cmath>
+#include <limits>
 #include <numeric>
 
+#include "sdca/math/vector_math.h"
+
 namespace sdca {
 
 template <typename Type>
@@ -79,6 +82,47 @@ x_log_x(const Type x) {
   return (x > 0) ? x * std::log(x) : 0;
 }
 
+/**
+ * Computes
+ *    sum_i exp(a_i - m)
+ * where a_i are elements in the range [first, last).
+ **/
+template <typename Result,
+          typename Iterator>
+inline Result
+sum_exp(
+    Iterator first,
+    const Iterator last,
+    const Result m
+  ) {
+  Result s(0);
+  for (; first != last; ++first) {
+    s += vector_exp(static_cast<Result>(*first) - m);
+  }
+  return s;
+}
+
+/**
+ * Computes
+ *    sum_i x_log_x(a + b * x_i)
+ * where x_i are elements in the range [first, last).
+ **/
+template <typename Result,
+          typename Iterator>
+inline Result
+sum_x_log_x(
+    Iterator first,
+    const Iterator last,
+    const Result a,
+    const Result b
+  ) {
+  Result s(0);
+  for (; first != last; ++first) {
+    s += vector_x_log_x(a + b * static_cast<Result>(*first));
+  }
+  return s;
+}
+
 /**
  * Computes
  *    log(sum_i exp(a_i))
@@ -93,13 +137,8 @@ log_sum_exp(
     Iterator last,
     Iterator max
   ) {
-  Result s(0), m(static_cast<Result>(*max));
-  for (; first != max; ++first) {
-    s += std::exp(static_cast<Result>(*first) - m);
-  }
-  for (first = max + 1; first != last; ++first) {
-    s += std::exp(static_cast<Result>(*first) - m);
-  }
+  Result m(static_cast<Result>(*max));
+  Result s = sum_exp(first, max, m) + sum_exp(max + 1, last, m);
   return m + std::log1p(s);
 }
 
@@ -140,14 +179,8 @@ log_sum_exp(
     Iterator max,
     Result& s
   ) {
-  s = 0;
   Result m(static_cast<Result>(*max));
-  for (; first != max; ++first) {
-    s += std::exp(static_cast<Result>(*first) - m);
-  }
-  for (first = max + 1; first != last; ++first) {
-    s += std::exp(static_cast<Result>(*first) - m);
-  }
+  s = sum_exp(first, max, m) + sum_exp(max + 1, last, m);
   return m + std::log1p(s);
 }
 
@@ -189,14 +222,9 @@ log_1_sum_exp(
     Iterator max
   ) {
   Result m(static_cast<Result>(*max));
-  Result s(std::exp(-m));
-  if (!std::isfinite(s)) return 0;
-  for (; first != max; ++first) {
-    s += std::exp(static_cast<Result>(*first) - m);
-  }
-  for (first = max + 1; first != last; ++first) {
-    s += std::exp(static_cast<Result>(*first) - m);
-  }
+  if (-m > exp_traits<Result>::max_arg()) return 0; // exp(-m) overflows
+  Result s = std::exp(-m)
+    + sum_exp(first, max, m) + sum_exp(max + 1, last, m);
   return m + std::log1p(s);
 }
 
@@ -238,14 +266,8 @@ log_1_sum_exp(
     Result& s
   ) {
   Result m(static_cast<Result>(*max));
-  s = std::exp(-m);
-  if (!std::isfinite(s)) return 0;
-  for (; first != max; ++first) {
-    s += std::exp(static_cast<Result>(*first) - m);
-  }
-  for (first = max + 1; first != last; ++first) {
-    s += std::exp(static_cast<Result>(*first) - m);
-  }
+  if (-m > exp_traits<Result>::max_arg()) return 0; // exp(-m) overflows
+  s = std::exp(-m) + sum_exp(first, max, m) + sum_exp(max + 1, last, m);
   return m + std::log1p(s);
 }
 
@@ -294,16 +316,11 @@ log_sum_exp(
     Result& lse,
     Result& lse1
   ) {
-  Result s(0), m(static_cast<Result>(*max));
-  for (; first != max; ++first) {
-    s += std::exp(static_cast<Result>(*first) - m);
-  }
-  for (first = max + 1; first != last; ++first) {
-    s += std::exp(static_cast<Result>(*first) - m);
-  }
+  Result m(static_cast<Result>(*max));
+  Result s = sum_exp(first, max, m) + sum_exp(max + 1, last, m);
   lse = m + std::log1p(s);
-  lse1 = std::exp(-m);
-  lse1 = std::isfinite(lse1) ? m + std::log1p(s + lse1) : 0;
+  lse1 = (-m > exp_traits<Result>::max_arg())
+    ? 0 : m + std::log1p(s + std::exp(-m));
   return s;
 }
 
@@ -0,0 +1,108 @@
+#ifndef SDCA_MATH_PACKED_H
+#define SDCA_MATH_PACKED_H
+
+#include <algorithm>
+
+#include "sdca/math/blas.h"
+#include "sdca/utility/types.h"
+
+namespace sdca {
+
+/*
+ * Symmetric n-by-n matrices K in a blocked lower triangular storage.
+ * The columns are split into blocks of b = sdca_packed_block columns
+ * (the last one may be narrower); the panel J is the lower part
+ *    K(J b : n, J b : J b + b)
+ * of its block column in column-major order (leading dimension n - J b).
+ * The panels are stored one after another, starting at
+ * sdca_packed_panel(n, J), i.e. about n * (n + b) / 2 elements in total.
+ * The diagonal blocks are stored in full (both of their halves),
+ * hence the rows [J b, n) of every column of K are contiguous.
+ */
+static constexpr size_type sdca_packed_block = 64;
+
+
+// Returns the position of the panel J
+inline size_type
+sdca_packed_panel(
+    const size_type n,
+    const size_type J
+  ) {
+  const size_type b = sdca_packed_block;
+  return J * b * n - b * b * J * (J - 1) / 2;
+}
+
+
+// Returns the position of K(j, j)
+inline size_type
+sdca_packed_offset(
+    const size_type n,
+    const size_type j
+  ) {
+  const size_type J = j / sdca_packed_block, r = j % sdca_packed_block;
+  return sdca_packed_panel(n, J) + r * (n - J * sdca_packed_block + 1);
+}
+
+
+inline size_type
+sdca_packed_size(
+    const size_type n
+  ) {
+  const size_type J = n / sdca_packed_block, b = n % sdca_packed_block;
+  return sdca_packed_panel(n, J) + b * b;
+}
+
+
+// Let P = the lower panels of K, where K is n-by-n in column-major order
+template <typename Data>
+inline void
+sdca_pack_lower(
+    const size_type n,
+    const Data* K,
+    Data* P
+  ) {
+  for (size_type first = 0; first < n; first += sdca_packed_block) {
+    const size_type last = std::min(first + sdca_packed_block, n);
+    for (size_type j = first; j < last; ++j) {
+      P = std::copy(K + n * j + first, K + n * (j + 1), P);
+    }
+  }
+}
+
+
+// Let y = A * K(:, i), where A is m-by-n and K is symmetric packed (see above)
+template <typename Data>
+inline void
+sdca_packed_gemv(
+    const size_type m,
+    const size_type n,
+    const Data* A,
+    const Data* P,
+    const size_type i,
+    Data* Y
+  ) {
+  // The rows [J b, n) of K(:, i) are contiguous in the panel J of i
+  const size_type b = sdca_packed_block, J = i / b;
+  const blas_int M = static_cast<blas_int>(m);
+  sdca_blas_gemv(M, static_cast<blas_int>(n - J * b), A + m * J * b,
+    P + sdca_packed_panel(n, J) + (i - J * b) * (n - J * b), Y);
+
+  // The rows [I b, I b + b) for I < J are the row i of the panel I,
+  // gathered into a buffer for one gemv per panel.
+  // NOTE: the gather touches one cache line per element, hence the packed
+  // storage halves the memory of K, but not the memory traffic of a column.
+  Data x[sdca_packed_block];
+  for (size_type I = 0; I < J; ++I, A += m * b) {
+    const size_type ld = n - I * b;
+    const Data* row = P + sdca_packed_panel(n, I) + i - I * b;
+    for (size_type k = 0; k < b; ++k) {
+      x[k] = row[ld * k];
+    }
+    sdca_blas_gemv(M, static_cast<blas_int>(b), A, x, Y, CblasNoTrans,
+                   static_cast<Data>(1), static_cast<Data>(1));
+  }
+}
+
+}
+
+#endif
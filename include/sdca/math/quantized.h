@@ -0,0 +1,186 @@
+#ifndef SDCA_MATH_QUANTIZED_H
+#define SDCA_MATH_QUANTIZED_H
+
+#include <cstdint>
+#include <cstring>
+
+#include "sdca/utility/types.h"
+
+namespace sdca {
+
+/*
+ * Compressed storage of real values with on-the-fly dequantization:
+ *    int8:  x = scale * q, q in [-127, 127] (see quantized_features.h),
+ *    fp16:  IEEE 754 half precision (binary16),
+ *    bf16:  bfloat16, i.e. the upper 16 bits of a float.
+ * The 16-bit types are distinct structs so that the kernels below can be
+ * instantiated for each of them.
+ */
+struct sdca_half {
+  std::uint16_t bits;
+};
+
+
+struct sdca_bfloat16 {
+  std::uint16_t bits;
+};
+
+
+inline float
+sdca_bits_to_float(
+    const std::uint32_t bits
+  ) {
+  float x;
+  std::memcpy(&x, &bits, sizeof(x));
+  return x;
+}
+
+
+inline std::uint32_t
+sdca_float_to_bits(
+    const float x
+  ) {
+  std::uint32_t bits;
+  std::memcpy(&bits, &x, sizeof(bits));
+  return bits;
+}
+
+
+inline float
+sdca_dequantize(
+    const std::int8_t q
+  ) {
+  return static_cast<float>(q);
+}
+
+
+// Branch-free except for subnormals, inf and nan
+inline float
+sdca_dequantize(
+    const sdca_half h
+  ) {
+  const std::uint32_t shifted_exponent = 0x7C00u << 13;
+  std::uint32_t bits = (h.bits & 0x7FFFu) << 13;
+  const std::uint32_t exponent = bits & shifted_exponent;
+  bits += (127u - 15u) << 23;
+  if (exponent == shifted_exponent) {
+    bits += (128u - 16u) << 23; // inf, nan
+  } else if (exponent == 0) {
+    bits += 1u << 23; // zero, subnormal (renormalized by the subtraction)
+    bits = sdca_float_to_bits(sdca_bits_to_float(bits) -
+                              sdca_bits_to_float(113u << 23));
+  }
+  return sdca_bits_to_float(bits | ((h.bits & 0x8000u) << 16));
+}
+
+
+inline float
+sdca_dequantize(
+    const sdca_bfloat16 h
+  ) {
+  return sdca_bits_to_float(static_cast<std::uint32_t>(h.bits) << 16);
+}
+
+
+// Rounds to the nearest half, ties to even; overflows to inf
+inline sdca_half
+sdca_float_to_half(
+    const float x
+  ) {
+  std::uint32_t bits = sdca_float_to_bits(x);
+  const std::uint32_t sign = bits & 0x80000000u;
+  bits ^= sign;
+  std::uint32_t h;
+  if (bits >= 0x47800000u) {
+    h = (bits > 0x7F800000u) ? 0x7E00u : 0x7C00u; // nan, inf
+  } else if (bits < 0x38800000u) {
+    // Subnormal: the float addition does the rounding
+    const float magic = sdca_bits_to_float(((127u - 15u) + (23u - 10u) + 1u)
+                                           << 23);
+    h = sdca_float_to_bits(sdca_bits_to_float(bits) + magic) -
+        sdca_float_to_bits(magic);
+  } else {
+    const std::uint32_t odd = (bits >> 13) & 1u;
+    bits -= (127u - 15u) << 23;
+    bits += 0xFFFu + odd;
+    h = bits >> 13;
+  }
+  sdca_half result;
+  result.bits = static_cast<std::uint16_t>(h | (sign >> 16));
+  return result;
+}
+
+
+// Rounds to the nearest bfloat16, ties to even
+inline sdca_bfloat16
+sdca_float_to_bfloat16(
+    const float x
+  ) {
+  std::uint32_t bits = sdca_float_to_bits(x);
+  sdca_bfloat16 result;
+  if ((bits & 0x7FFFFFFFu) > 0x7F800000u) {
+    result.bits = static_cast<std::uint16_t>((bits >> 16) | 0x40u); // nan
+  } else {
+    bits += 0x7FFFu + ((bits >> 16) & 1u);
+    result.bits = static_cast<std::uint16_t>(bits >> 16);
+  }
+  return result;
+}
+
+
+/*
+ * The kernels dequantize a vector of n values Q with the optional
+ * per-dimension scales (nullptr if none) while they are read,
+ * i.e. x_k = scales[k] * Q[k]. A per-vector scale is left to the caller.
+ */
+
+// Let X = alpha * x
+template <typename Quantized,
+          typename Data>
+inline void
+sdca_quantized_copy(
+    const size_type n,
+    const Data alpha,
+    const Quantized* Q,
+    const Data* scales,
+    Data* X
+  ) {
+  if (scales == nullptr) {
+    for (size_type k = 0; k < n; ++k) {
+      X[k] = alpha * static_cast<Data>(sdca_dequantize(Q[k]));
+    }
+  } else {
+    for (size_type k = 0; k < n; ++k) {
+      X[k] = alpha * scales[k] * static_cast<Data>(sdca_dequantize(Q[k]));
+    }
+  }
+}
+
+
+// Returns x' * x
+template <typename Quantized,
+          typename Data>
+inline Data
+sdca_quantized_norm2(
+    const size_type n,
+    const Quantized* Q,
+    const Data* scales
+  ) {
+  Data sum(0);
+  if (scales == nullptr) {
+    for (size_type k = 0; k < n; ++k) {
+      const Data x = static_cast<Data>(sdca_dequantize(Q[k]));
+      sum += x * x;
+    }
+  } else {
+    for (size_type k = 0; k < n; ++k) {
+      const Data x = scales[k] * static_cast<Data>(sdca_dequantize(Q[k]));
+      sum += x * x;
+    }
+  }
+  return sum;
+}
+
+}
+
+#endif
@@ -0,0 +1,88 @@
+#ifndef SDCA_MATH_SPARSE_H
+#define SDCA_MATH_SPARSE_H
+
+#include "sdca/utility/types.h"
+
+namespace sdca {
+
+/*
+ * Sparse counterparts of the BLAS routines in blas.h, where x is a sparse
+ * vector with the nnz non-zero values in the positions given by indices.
+ * There is no portable sparse BLAS interface, the loops are simple enough
+ * for the compiler to vectorize the gathers/scatters where possible.
+ */
+
+// Returns x' * y
+template <typename Data>
+inline Data
+sdca_sparse_dot(
+    const size_type nnz,
+    const Data* values,
+    const size_type* indices,
+    const Data* Y
+  ) {
+  Data sum(0);
+  for (size_type k = 0; k < nnz; ++k) {
+    sum += values[k] * Y[indices[k]];
+  }
+  return sum;
+}
+
+
+// Let y = alpha * x + y
+template <typename Data>
+inline void
+sdca_sparse_axpy(
+    const size_type nnz,
+    const Data alpha,
+    const Data* values,
+    const size_type* indices,
+    Data* Y
+  ) {
+  for (size_type k = 0; k < nnz; ++k) {
+    Y[indices[k]] += alpha * values[k];
+  }
+}
+
+
+// Let y = A' * x, where A is an n-by-m matrix in column-major order
+template <typename Data>
+inline void
+sdca_sparse_gemv(
+    const size_type n,
+    const size_type m,
+    const Data* A,
+    const size_type nnz,
+    const Data* values,
+    const size_type* indices,
+    Data* Y
+  ) {
+  for (size_type j = 0; j < m; ++j, A += n) {
+    Y[j] = sdca_sparse_dot(nnz, values, indices, A);
+  }
+}
+
+
+// Let A = alpha * x * y' + A, where A is an n-by-m matrix in column-major order
+template <typename Data>
+inline void
+sdca_sparse_ger(
+    const size_type n,
+    const size_type m,
+    const Data alpha,
+    const size_type nnz,
+    const Data* values,
+    const size_type* indices,
+    const Data* Y,
+    Data* A
+  ) {
+  for (size_type j = 0; j < m; ++j, A += n) {
+    if (Y[j] != 0) {
+      sdca_sparse_axpy(nnz, alpha * Y[j], values, indices, A);
+    }
+  }
+}
+
+}
+
+#endif
@@ -0,0 +1,329 @@
+#ifndef SDCA_MATH_VECTOR_MATH_H
+#define SDCA_MATH_VECTOR_MATH_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+
+namespace sdca {
+
+/*
+ * Branch-free exp, log and log1p for float and double that the compiler
+ * can inline and vectorize in the loops of the reductions (log_sum_exp,
+ * sum of x * log(x), etc.), so that they cost a few cycles per element.
+ *
+ * The kernels are accurate to about 2 ulp (also with -ffast-math) where
+ * the results are normal; see vector_exp etc. below for when they are used.
+ *
+ * [1] W. J. Cody, W. Waite. Software manual for the elementary functions.
+ *     Prentice-Hall, 1980.
+ * [2] fdlibm, e_log.c and s_log1p.c (Sun Microsystems, 1993).
+ */
+
+// Returns 2^n for the exponents n of normal numbers
+template <typename Type>
+inline Type
+vector_math_pow2(const int n);
+
+
+template <>
+inline double
+vector_math_pow2(
+    const int n
+  ) {
+  const std::uint64_t bits = static_cast<std::uint64_t>(n + 1023) << 52;
+  double x;
+  std::memcpy(&x, &bits, sizeof(x));
+  return x;
+}
+
+
+template <>
+inline float
+vector_math_pow2(
+    const int n
+  ) {
+  const std::uint32_t bits = static_cast<std::uint32_t>(n + 127) << 23;
+  float x;
+  std::memcpy(&x, &bits, sizeof(x));
+  return x;
+}
+
+
+// Returns x * 2^n by adding n to the exponent of a normal x;
+// the result must be normal as well
+inline double
+vector_math_scale(
+    const double x,
+    const int n
+  ) {
+  std::uint64_t bits;
+  std::memcpy(&bits, &x, sizeof(bits));
+  bits += static_cast<std::uint64_t>(static_cast<std::int64_t>(n)) << 52;
+  double y;
+  std::memcpy(&y, &bits, sizeof(y));
+  return y;
+}
+
+
+inline float
+vector_math_scale(
+    const float x,
+    const int n
+  ) {
+  std::uint32_t bits;
+  std::memcpy(&bits, &x, sizeof(bits));
+  bits += static_cast<std::uint32_t>(n) << 23;
+  float y;
+  std::memcpy(&y, &bits, sizeof(y));
+  return y;
+}
+
+
+/**
+ * Computes exp(x); overflows to +Inf and underflows to 0 like std::exp.
+ **/
+inline double
+vector_math_exp(
+    const double x
+  ) {
+  // Beyond these, the result is 0 or +Inf anyway
+  const double t = std::min(std::max(x, -746.0), 710.0);
+
+  // x = n * ln(2) + r - c, |r| <= ln(2) / 2, where r is exact (ln(2)_hi
+  // has 32 bits); c is applied as exp(-c) = 1 - c + c^2 / 2 at the end
+  // instead of being subtracted from r, since -ffast-math would merge
+  // the two parts of ln(2) and lose the exactness of r
+  const int n = static_cast<int>(t * 1.44269504088896338700e+00
+                                 + ((t < 0) ? -0.5 : 0.5));
+  const double dn = static_cast<double>(n);
+  const double r = t - dn * 6.93147180369123816490e-01;
+  const double c = dn * 1.90821492927058770002e-10;
+
+  // Taylor polynomial of degree 13, the error is below 1e-17 for |r| <= 0.35
+  // (Estrin's scheme, which is shorter than Horner's in latency)
+  const double r2 = r * r, r4 = r2 * r2, r8 = r4 * r4;
+  const double p01 = (1 + r) + r2 * (1.0 / 2 + r * (1.0 / 6));
+  const double p23 = (1.0 / 24 + r * (1.0 / 120)) +
+                r2 * (1.0 / 720 + r * (1.0 / 5040));
+  const double p45 = (1.0 / 40320 + r * (1.0 / 362880)) +
+                r2 * (1.0 / 3628800 + r * (1.0 / 39916800));
+  const double p6 = 1.0 / 479001600 + r * (1.0 / 6227020800);
+  double p = (p01 + r4 * p23) + r8 * (p45 + r4 * p6);
+  p *= 1 - c + 0.5 * c * c;
+
+  // Scale by 2^n in two steps, since 2^n may not be normal; the product
+  // rounds to a subnormal, 0 or +Inf on its own (no selects are needed,
+  // which would keep the sums of exp from being vectorized)
+  const int n1 = n / 2;
+  return vector_math_scale(p, n1) * vector_math_pow2<double>(n - n1);
+}
+
+
+inline float
+vector_math_exp(
+    const float x
+  ) {
+  const float t = std::min(std::max(x, -104.0f), 89.0f);
+
+  // See vector_math_exp(double); ln(2)_hi has 16 bits
+  const int n = static_cast<int>(t * 1.4426950216e+00f
+                                 + ((t < 0) ? -0.5f : 0.5f));
+  const float dn = static_cast<float>(n);
+  const float r = t - dn * 6.9314575195e-01f;
+  const float c = dn * 1.4286067653e-06f;
+
+  // Taylor polynomial of degree 7, the error is below 1e-8 for |r| <= 0.35
+  const float r2 = r * r, r4 = r2 * r2;
+  const float p01 = (1 + r) + r2 * (1.0f / 2 + r * (1.0f / 6));
+  const float p23 = (1.0f / 24 + r * (1.0f / 120)) +
+               r2 * (1.0f / 720 + r * (1.0f / 5040));
+  float p = p01 + r4 * p23;
+  p *= 1 - c + 0.5f * c * c;
+
+  const int n1 = n / 2;
+  return vector_math_scale(p, n1) * vector_math_pow2<float>(n - n1);
+}
+
+
+/**
+ * Computes log(2^k * (1 + f)) for f in [sqrt(1/2) - 1, sqrt(2) - 1]
+ * as in [2], i.e., with s = f / (2 + f),
+ *    log(1 + f) = f - f^2 / 2 + s * (f^2 / 2 + R(s)).
+ **/
+inline double
+vector_math_log_kernel(
+    const double f,
+    const double k
+  ) {
+  const double s = f / (2 + f), z = s * s, w = z * z;
+  const double t1 = w * (3.999999999940941908e-01 +
+                    w * (2.222219843214978396e-01 +
+                    w * 1.531383769920937332e-01));
+  const double t2 = z * (6.666666666666735130e-01 +
+                    w * (2.857142874366239149e-01 +
+                    w * (1.818357216161805012e-01 +
+                    w * 1.479819860511658591e-01)));
+  const double hfsq = 0.5 * f * f;
+  return k * 6.93147180369123816490e-01
+    - ((hfsq - (s * (hfsq + t1 + t2) + k * 1.90821492927058770002e-10)) - f);
+}
+
+
+inline float
+vector_math_log_kernel(
+    const float f,
+    const float k
+  ) {
+  const float s = f / (2 + f), z = s * s, w = z * z;
+  const float t1 = w * (4.0000972152e-01f + w * 2.4279078841e-01f);
+  const float t2 = z * (6.6666662693e-01f + w * 2.8498786688e-01f);
+  const float hfsq = 0.5f * f * f;
+  return k * 6.9313812256e-01f
+    - ((hfsq - (s * (hfsq + t1 + t2) + k * 9.0580006145e-06f)) - f);
+}
+
+
+/**
+ * Splits a positive normal x into x = 2^k * (1 + f)
+ * with 1 + f in [sqrt(1/2), sqrt(2)).
+ **/
+inline void
+vector_math_log_split(
+    const double x,
+    double& f,
+    double& k
+  ) {
+  std::uint64_t bits;
+  std::memcpy(&bits, &x, sizeof(bits));
+  const int e = static_cast<int>(bits >> 52) - 1023;
+  bits = (bits & 0x000FFFFFFFFFFFFFull) | 0x3FF0000000000000ull;
+  double m;
+  std::memcpy(&m, &bits, sizeof(m));
+  const bool above = m > 1.41421356237309504880;
+  f = (above ? 0.5 * m : m) - 1;
+  k = static_cast<double>(above ? e + 1 : e);
+}
+
+
+inline void
+vector_math_log_split(
+    const float x,
+    float& f,
+    float& k
+  ) {
+  std::uint32_t bits;
+  std::memcpy(&bits, &x, sizeof(bits));
+  const int e = static_cast<int>(bits >> 23) - 127;
+  bits = (bits & 0x007FFFFFu) | 0x3F800000u;
+  float m;
+  std::memcpy(&m, &bits, sizeof(m));
+  const bool above = m > 1.41421356f;
+  f = (above ? 0.5f * m : m) - 1;
+  k = static_cast<float>(above ? e + 1 : e);
+}
+
+
+/**
+ * Computes log(x) for positive x; arguments below the smallest normal
+ * number are rounded up to it.
+ **/
+template <typename Type>
+inline Type
+vector_math_log(
+    const Type x
+  ) {
+  Type f, k;
+  vector_math_log_split(std::max(x, std::numeric_limits<Type>::min()), f, k);
+  return vector_math_log_kernel(f, k);
+}
+
+
+/**
+ * Computes log(1 + x) for x > -1.
+ * Around 0, f = x is used directly; otherwise 1 + x is split as for log,
+ * which loses the rounding error of 1 + x, but that is below one ulp
+ * of the result there.
+ **/
+template <typename Type>
+inline Type
+vector_math_log1p(
+    const Type x
+  ) {
+  Type f, k;
+  vector_math_log_split(
+    std::max(1 + x, std::numeric_limits<Type>::min()), f, k);
+  const bool around_0 = (x > static_cast<Type>(-0.29289321881345247560)) &&
+                        (x < static_cast<Type>(0.41421356237309504880));
+  return vector_math_log_kernel(around_0 ? x : f,
+                                around_0 ? static_cast<Type>(0) : k);
+}
+
+
+/**
+ * The functions used by the reductions. In fast-math builds, these are
+ * the kernels above, unless glibc declares vector variants (libmvec) of
+ * the standard functions, which GCC then uses in vectorized loops.
+ * Otherwise (and for long double), these are the standard functions.
+ **/
+template <typename Type>
+inline Type
+vector_exp(const Type x) {
+  return std::exp(x);
+}
+
+template <typename Type>
+inline Type
+vector_log(const Type x) {
+  return std::log(x);
+}
+
+template <typename Type>
+inline Type
+vector_log1p(const Type x) {
+  return std::log1p(x);
+}
+
+#if !defined(SDCA_ACCURATE_MATH) && !defined(__DECL_SIMD_x86_64)
+template <>
+inline float
+vector_exp(const float x) { return vector_math_exp(x); }
+
+template <>
+inline double
+vector_exp(const double x) { return vector_math_exp(x); }
+
+template <>
+inline float
+vector_log(const float x) { return vector_math_log(x); }
+
+template <>
+inline double
+vector_log(const double x) { return vector_math_log(x); }
+
+template <>
+inline float
+vector_log1p(const float x) { return vector_math_log1p(x); }
+
+template <>
+inline double
+vector_log1p(const double x) { return vector_math_log1p(x); }
+#endif
+
+/**
+ * Computes
+ *    x * log(x)
+ * (0 for x <= 0) without branching.
+ **/
+template <typename Type>
+inline Type
+vector_x_log_x(const Type x) {
+  const Type y = x * vector_log(std::max(x, std::numeric_limits<Type>::min()));
+  return (x > 0) ? y : static_cast<Type>(0);
+}
+
+}
+
+#endif
@@ -17,6 +17,7 @@
 #include "sdca/prox/topk_simplex_biased.h"
 #include "sdca/prox/two_entropy.h"
 #include "sdca/prox/two_simplex.h"
+#include "sdca/prox/two_simplex_pivot.h"
 #include "sdca/prox/two_simplex_sort.h"
 
 #endif
@@ -7,10 +7,15 @@
 
 namespace sdca {
 
+/*
+ * Reference implementation of thresholds_knapsack_le_biased_search below:
+ * sorts the data and tries all candidate sets U and M in O(m^2) worst case,
+ * O(m log m) when the solution is found early.
+ */
 template <typename Result,
           typename Iterator>
 inline thresholds<Result, Iterator>
-thresholds_knapsack_le_biased_search(
+thresholds_knapsack_le_biased_search_sort(
     Iterator first,
     Iterator last,
     const Result lo,
@@ -90,6 +95,112 @@ thresholds_knapsack_le_biased_search(
 }
 
 
+/**
+ * Solves the biased problem (see thresholds_knapsack_le_biased) for the case
+ * when the inequality constraint is inactive, i.e., finds t such that
+ *    t = rho * <1, x(t)>,   x(t) = max(lo, min(a - t, hi)),
+ * and checks that t <= rho * rhs.
+ *
+ * The equation is solved by variable fixing as in thresholds_knapsack_eq:
+ * t is computed as if all the free variables were in (lo, hi), and then
+ * the variables above hi (if the sum of violations is positive) or below lo
+ * (if it is negative) are fixed, which are at the bounds in the solution,
+ * since t / rho - <1, x(t)> is increasing in t. This takes O(m) per
+ * iteration and few iterations in practice, and no sorting.
+ **/
+template <typename Result,
+          typename Iterator>
+inline thresholds<Result, Iterator>
+thresholds_knapsack_le_biased_search(
+    Iterator first,
+    Iterator last,
+    const Result lo,
+    const Result hi,
+    const Result rhs,
+    const Result rho
+    ) {
+  // At this point, rho must be positive
+  assert(rho > 0);
+  Result eps = std::numeric_limits<Result>::epsilon()
+    * std::max(static_cast<Result>(1), std::abs(rhs));
+
+  // Initialization: all variables are free
+  Result rho_inverse = static_cast<Result>(1) / rho;
+  Result sum_fixed = 0; // hi * num_U + lo * num_L
+  Result sum_M = std::accumulate(first, last, static_cast<Result>(0));
+  auto m = std::distance(first, last);
+  Result t = sum_M / (rho_inverse + static_cast<Result>(m));
+
+  Iterator m_first(first), m_last(last);
+  for (;;) {
+    // Re-partition and compute sums
+    Result tt = lo + t;
+    auto it_lo = std::partition(m_first, m_last,
+                                [=](const Result x){ return x > tt; });
+    auto sum_lo = std::accumulate(it_lo, m_last, static_cast<Result>(0));
+    auto n_lo = std::distance(it_lo, m_last);
+
+    tt = hi + t;
+    auto it_hi = std::partition(m_first, it_lo,
+                                [=](const Result x){ return x > tt; });
+    auto sum_hi = std::accumulate(m_first, it_hi, static_cast<Result>(0));
+    auto n_hi = std::distance(m_first, it_hi);
+
+    // Check feasibility and fix variables
+    Result s_hi = static_cast<Result>(n_hi) * hi;
+    Result s_lo = static_cast<Result>(n_lo) * lo;
+    Result infeas = sum_hi + sum_lo - (s_hi + s_lo)
+                  - static_cast<Result>(n_hi + n_lo) * t;
+    if (n_hi > 0 && infeas > eps) {
+      m_first = it_hi;
+      sum_M -= sum_hi;
+      sum_fixed += s_hi;
+      m -= n_hi;
+    } else if (n_lo > 0 && infeas < -eps) {
+      m_last = it_lo;
+      sum_M -= sum_lo;
+      sum_fixed += s_lo;
+      m -= n_lo;
+    } else {
+      m_first = it_hi;
+      m_last = it_lo;
+      break;
+    }
+
+    // Update t (1 / rho > 0, so this is defined even if m = 0)
+    t = (sum_fixed + sum_M) / (rho_inverse + static_cast<Result>(m));
+  }
+
+  // Recompute t from the final sets, since the sum of M above accumulates
+  // round-off errors, which matter if t is close to rho * rhs
+  t = (std::accumulate(m_first, m_last, static_cast<Result>(0))
+      + hi * static_cast<Result>(std::distance(first, m_first))
+      + lo * static_cast<Result>(std::distance(m_last, last))
+      ) / (rho_inverse + static_cast<Result>(std::distance(m_first, m_last)));
+
+#ifdef SDCA_ACCURATE_MATH
+  // (Optional) Clip t to the interval that is consistent with the sets
+  Result t_lo(std::numeric_limits<Result>::lowest());
+  Result t_hi(std::numeric_limits<Result>::max());
+  if (m_last != last) {
+    t_lo = static_cast<Result>(*std::max_element(m_last, last)) - lo;
+  }
+  if (first != m_first) {
+    t_hi = static_cast<Result>(*std::min_element(first, m_first)) - hi;
+  }
+  t = std::max(t_lo, std::min(t, t_hi));
+#endif
+
+  // The inequality constraint must be inactive
+  if (t <= rho * rhs + eps) {
+    return make_thresholds(t, lo, hi, m_first, m_last);
+  }
+
+  // Default to 0
+  return thresholds<Result, Iterator>(0, 0, 0, first, first);
+}
+
+
 /**
  * Solve
  *    min_x 0.5 * (<x, x> + rho * <1, x>^2) - <a, x>
@@ -1,7 +1,9 @@
 #ifndef SDCA_PROX_TOPK_CONE_H
 #define SDCA_PROX_TOPK_CONE_H
 
+#include <algorithm>
 #include <functional>
+#include <numeric>
 
 #include "sdca/prox/proxdef.h"
 
@@ -55,10 +57,14 @@ topk_cone_special_cases(
 }
 
 
+/*
+ * The search on the fully sorted data; it is kept as the reference for
+ * thresholds_topk_cone_search below.
+ */
 template <typename Result = double,
           typename Iterator>
 inline thresholds<Result, Iterator>
-thresholds_topk_cone_search(
+thresholds_topk_cone_search_sort(
     Iterator first,
     Iterator last,
     const typename std::iterator_traits<Iterator>::difference_type k
@@ -133,6 +139,140 @@ thresholds_topk_cone_search(
 }
 
 
+/*
+ * The search of the general case of the (biased, rho > 0) top-k cone
+ * without sorting all of the data.
+ *
+ * Only the k largest elements can be in U, so these are selected and sorted
+ * in O(m + k log k). For a given U (the num_U largest elements), M is the
+ * longest run in descending order whose next element is above t, where
+ *    t = ((num_U + rho * k^2) * sum_M - (k - num_U) * sum_U) / D
+ * (see thresholds_topk_cone_search_sort). Adding an element a to M moves t
+ * to a weighted mean of t and a, hence 'the next element is not above t'
+ * is monotone along the descending order and the boundary of M can be found
+ * by bisection on unsorted data: the sorted k largest are scanned, and the
+ * rest is partitioned around pivots as in quickselect in expected O(m).
+ * This makes the conditions (1) and (2) hold by construction; (3) and (4)
+ * are checked for each U as before.
+ */
+template <typename Result,
+          typename Iterator>
+inline thresholds<Result, Iterator>
+thresholds_topk_cone_select(
+    Iterator first,
+    Iterator last,
+    const typename std::iterator_traits<Iterator>::difference_type k,
+    const Result rho
+    ) {
+  // Select and sort the k largest elements
+  typedef typename std::iterator_traits<Iterator>::value_type Data;
+  auto k_last = std::next(first, k);
+  std::nth_element(first, k_last - 1, last, std::greater<Data>());
+  std::sort(first, k_last, std::greater<Data>());
+
+  // Precompute some constants
+  Result k_minus_num_U = static_cast<Result>(k);
+  Result num_U_plus_rho_k_2 =
+    rho * static_cast<Result>(k) * static_cast<Result>(k);
+  Result sum_U = 0;
+  Result eps = 16 * std::numeric_limits<Result>::epsilon();
+
+  // Grow U starting with empty
+  for (auto m_first = first;;) {
+    const Result w = num_U_plus_rho_k_2;
+    const Result D_0 = k_minus_num_U * k_minus_num_U;
+    const Result k_minus_num_U_sum_U = k_minus_num_U * sum_U;
+
+    // Whether an element x that follows M (num_M, sum_M) is in M as well;
+    // D = 0 only if num_U = k and M is empty
+    auto is_above_t = [=](const Result x, const Result num_M,
+                          const Result sum_M) {
+      Result D = D_0 + w * num_M;
+      return !(D > 0) || x > (w * sum_M - k_minus_num_U_sum_U) / D + eps;
+    };
+
+    // Grow M over the sorted k largest
+    Result num_M = 0, sum_M = 0;
+    auto m_last = m_first;
+    for (; m_last != k_last &&
+           is_above_t(static_cast<Result>(*m_last), num_M, sum_M); ++m_last) {
+      num_M += 1;
+      sum_M += static_cast<Result>(*m_last);
+    }
+
+    // Continue in the rest by bisection; [k_last, lo) is in M,
+    // [hi, last) is not, and [lo, hi) is undecided
+    if (m_last == k_last) {
+      auto lo = k_last, hi = last;
+      while (lo != hi) {
+        const Data pivot = *std::next(lo, std::distance(lo, hi) / 2);
+        auto gt_last = std::partition(lo, hi,
+          [=](const Data x) { return x > pivot; });
+        Result num_gt = static_cast<Result>(std::distance(lo, gt_last));
+        Result sum_gt = std::accumulate(lo, gt_last, static_cast<Result>(0));
+        if (!is_above_t(static_cast<Result>(pivot), num_M + num_gt,
+                        sum_M + sum_gt)) {
+          hi = gt_last;
+          continue;
+        }
+        num_M += num_gt;
+        sum_M += sum_gt;
+        auto eq_last = std::partition(gt_last, hi,
+          [=](const Data x) { return !(x < pivot); });
+        for (lo = gt_last; lo != eq_last &&
+             is_above_t(static_cast<Result>(pivot), num_M, sum_M); ++lo) {
+          num_M += 1;
+          sum_M += static_cast<Result>(pivot);
+        }
+        if (lo != eq_last) {
+          break;
+        }
+      }
+      m_last = lo;
+    }
+
+    // Compute t and hi and check (3) and (4)
+    Result D = D_0 + w * num_M;
+    if (D > 0) {
+      Result t  = (w * sum_M - k_minus_num_U_sum_U) / D;
+      Result hi = (num_M * sum_U + k_minus_num_U * sum_M) / D;
+      Result tt = hi + t;
+      Result max_M = (m_first == m_last) ? tt
+        : static_cast<Result>((m_first != k_last) ? *m_first
+                              : *std::max_element(m_first, m_last));
+      if (max_M - eps <= tt && (m_first == first ||
+          tt <= static_cast<Result>(*(m_first - 1)) + eps)) {
+        return thresholds<Result, Iterator>(t, 0, hi, m_first, m_last);
+      }
+    }
+
+    // Increment the set U
+    if (m_first == k_last) {
+      break;
+    }
+    sum_U += static_cast<Result>(*m_first);
+    --k_minus_num_U;
+    ++num_U_plus_rho_k_2;
+    ++m_first;
+  }
+
+  // Default to 0
+  return thresholds<Result, Iterator>(0, 0, 0, first, first);
+}
+
+
+template <typename Result = double,
+          typename Iterator>
+inline thresholds<Result, Iterator>
+thresholds_topk_cone_search(
+    Iterator first,
+    Iterator last,
+    const typename std::iterator_traits<Iterator>::difference_type k
+    ) {
+  return thresholds_topk_cone_select(first, last, k, static_cast<Result>(0));
+}
+
+
 /**
  * Solve
  *    min_x 0.5 * <x, x> - <a, x>
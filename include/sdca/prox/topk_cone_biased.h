@@ -5,10 +5,14 @@
 
 namespace sdca {
 
+/*
+ * The search on the fully sorted data; it is kept as the reference for
+ * thresholds_topk_cone_biased_search below.
+ */
 template <typename Result,
           typename Iterator>
 inline thresholds<Result, Iterator>
-thresholds_topk_cone_biased_search(
+thresholds_topk_cone_biased_search_sort(
     Iterator first,
     Iterator last,
     const typename std::iterator_traits<Iterator>::difference_type k,
@@ -86,6 +90,19 @@ thresholds_topk_cone_biased_search(
 }
 
 
+template <typename Result,
+          typename Iterator>
+inline thresholds<Result, Iterator>
+thresholds_topk_cone_biased_search(
+    Iterator first,
+    Iterator last,
+    const typename std::iterator_traits<Iterator>::difference_type k,
+    const Result rho
+    ) {
+  return thresholds_topk_cone_select(first, last, k, rho);
+}
+
+
 /**
  * Solve
  *    min_x 0.5 * (<x, x> + rho * <1, x>^2) - <a, x>
@@ -2,6 +2,8 @@
 #define SDCA_PROX_TWO_SIMPLEX_H
 
 #include "sdca/prox/proxdef.h"
+#include "sdca/prox/two_simplex_pivot.h"
+#include "sdca/prox/two_simplex_sort.h"
 
 namespace sdca {
 
@@ -14,11 +16,14 @@ namespace sdca {
  * The solution is
  *    x = max(0, a - t)
  *    y = max(0, b - s)
+ *
+ * Each phase fixes the variables that violate the constraints until there
+ * are none; this is fast in practice, but not linear in the worst case.
  **/
 template <typename Result = double,
           typename Iterator>
 inline std::pair<thresholds<Result, Iterator>, thresholds<Result, Iterator>>
-thresholds_two_simplex(
+thresholds_two_simplex_fix(
     Iterator a_first,
     Iterator a_last,
     Iterator b_first,
@@ -119,6 +124,71 @@ thresholds_two_simplex(
 }
 
 
+enum class two_simplex_method {
+  automatic = 0,
+  sort,
+  fix,
+  pivot
+};
+
+
+inline two_simplex_method&
+two_simplex_method_storage() {
+  static two_simplex_method method = two_simplex_method::automatic;
+  return method;
+}
+
+// The method used by thresholds_two_simplex; not synchronized, so it should
+// only be changed (e.g., by benchmarks) while no solver is running
+inline two_simplex_method
+get_two_simplex_method() { return two_simplex_method_storage(); }
+
+inline void
+set_two_simplex_method(two_simplex_method method) {
+  two_simplex_method_storage() = method;
+}
+
+
+/**
+ * Solve
+ *    min_{x,y} ||x - a||^2 + ||y - b||^2
+ *              <1, x> = <1, y> <= rhs
+ *              0 <= x_i,  0 <= y_j
+ *
+ * with the method set by set_two_simplex_method. The automatic choice
+ * depends on the total size m: sorting is the fastest for m <= 16,
+ * fixing the variables for m < 1024, and the pivot search for larger m.
+ **/
+template <typename Result = double,
+          typename Iterator>
+inline std::pair<thresholds<Result, Iterator>, thresholds<Result, Iterator>>
+thresholds_two_simplex(
+    Iterator a_first,
+    Iterator a_last,
+    Iterator b_first,
+    Iterator b_last,
+    const Result rhs = 1
+    ) {
+  two_simplex_method method = get_two_simplex_method();
+  if (method == two_simplex_method::automatic) {
+    auto m = std::distance(a_first, a_last) + std::distance(b_first, b_last);
+    method = (m <= 16) ? two_simplex_method::sort
+           : (m < 1024) ? two_simplex_method::fix
+           : two_simplex_method::pivot;
+  }
+  switch (method) {
+    case two_simplex_method::sort:
+      return thresholds_two_simplex_sort(a_first, a_last, b_first, b_last, rhs);
+    case two_simplex_method::pivot:
+      return thresholds_two_simplex_pivot(a_first, a_last, b_first, b_last, rhs);
+    case two_simplex_method::automatic:
+    case two_simplex_method::fix:
+      break;
+  }
+  return thresholds_two_simplex_fix(a_first, a_last, b_first, b_last, rhs);
+}
+
+
 template <typename Result = double,
           typename Iterator>
 inline void
@@ -0,0 +1,235 @@
+#ifndef SDCA_PROX_TWO_SIMPLEX_PIVOT_H
+#define SDCA_PROX_TWO_SIMPLEX_PIVOT_H
+
+#include "sdca/prox/proxdef.h"
+
+namespace sdca {
+
+/*
+ * The search for the threshold of the projection onto the simplex
+ *    <1, x> = rhs, 0 <= x_i
+ * by bisection on pivots as in quickselect (expected O(m), see [1]).
+ * Partitions [first, last) such that the elements in [first, last_t)
+ * are above the threshold t, and returns t.
+ *
+ * [1] Duchi J, Shalev-Shwartz S, Singer Y, Chandra T.
+ *     Efficient projections onto the l1-ball for learning in high dimensions.
+ *     ICML 2008.
+ */
+template <typename Result,
+          typename Iterator>
+inline Result
+two_simplex_pivot_search(
+    Iterator first,
+    Iterator last,
+    Iterator& last_t,
+    const Result rhs
+    ) {
+  // [first, lo) is above t, [hi, last) is not, [lo, hi) is undecided
+  typedef typename std::iterator_traits<Iterator>::value_type Data;
+  Result num = 0, sum = 0;
+  Iterator lo(first), hi(last);
+  while (lo != hi) {
+    // The pivot p is above t iff p > t for all elements >= p above t
+    const Data p = *std::next(lo, std::distance(lo, hi) / 2);
+    auto gt_last = std::partition(lo, hi,
+                                  [=](const Data x){ return x > p; });
+    Result num_gt = static_cast<Result>(std::distance(lo, gt_last));
+    Result sum_gt = std::accumulate(lo, gt_last, static_cast<Result>(0));
+    if (sum + sum_gt - rhs < (num + num_gt) * static_cast<Result>(p)) {
+      auto eq_last = std::partition(gt_last, hi,
+                                    [=](const Data x){ return !(x < p); });
+      Result num_eq = static_cast<Result>(std::distance(gt_last, eq_last));
+      num += num_gt + num_eq;
+      sum += sum_gt + num_eq * static_cast<Result>(p);
+      lo = eq_last;
+    } else {
+      hi = gt_last;
+    }
+  }
+
+  // The largest element is always above t if rhs > 0
+  last_t = lo;
+  return (sum - rhs) / num;
+}
+
+
+/**
+ * Solve
+ *    min_{x,y} ||x - a||^2 + ||y - b||^2
+ *              <1, x> = <1, y> <= rhs
+ *              0 <= x_i,  0 <= y_j
+ *
+ * The solution is
+ *    x = max(0, a - t)
+ *    y = max(0, b - s)
+ *
+ * The same two phases as in thresholds_two_simplex_fix, but each one is
+ * a bisection on pivots in expected O(m) instead of fixing the variables
+ * until there are no violations, which is not linear in the worst case.
+ **/
+template <typename Result = double,
+          typename Iterator>
+inline std::pair<thresholds<Result, Iterator>, thresholds<Result, Iterator>>
+thresholds_two_simplex_pivot(
+    Iterator a_first,
+    Iterator a_last,
+    Iterator b_first,
+    Iterator b_last,
+    const Result rhs = 1
+    ) {
+  assert(rhs > 0); // otherwise just set x = y = 0
+  assert(std::distance(a_first, a_last) > 0);
+  assert(std::distance(b_first, b_last) > 0);
+
+  // Initialize
+  typedef typename std::iterator_traits<Iterator>::value_type Data;
+  Result lo(0), hi(rhs), eps = std::numeric_limits<Result>::epsilon()
+    * std::max(static_cast<Result>(1), rhs);
+
+  // Phase 1: <1, x> = <1, y> = rhs
+  Iterator x_last, y_last;
+  Result t = two_simplex_pivot_search(a_first, a_last, x_last, rhs);
+  Result s = two_simplex_pivot_search(b_first, b_last, y_last, rhs);
+
+  // Check if (t,s) is a feasible solution
+  if (t + s >= - eps) {
+    return std::make_pair(
+      make_thresholds(t, lo, hi, a_first, x_last),
+      make_thresholds(s, lo, hi, b_first, y_last));
+  }
+
+  // Phase 2: <1, x> = <1, y> = r < rhs, s = -t.
+  // The breakpoints are a_i and -b_j, and
+  //    f(t) = <1, max(0, a - t)> - <1, max(0, b + t)>
+  // is decreasing; t is only larger than in Phase 1, so the elements
+  // that are not above the Phase 1 thresholds stay out.
+  // [x_first, x_lo) and [y_first, y_lo) are in (num, sum = sum_x - sum_y),
+  // [x_hi, x_last) and [y_hi, y_last) are out, the rest is undecided.
+  Result num = 0, sum = 0;
+  Iterator x_lo(a_first), x_hi(x_last), y_lo(b_first), y_hi(y_last);
+  while (x_lo != x_hi || y_lo != y_hi) {
+    // The pivot tau is taken from the larger undecided range
+    auto x_size = std::distance(x_lo, x_hi), y_size = std::distance(y_lo, y_hi);
+    const Result tau = (x_size >= y_size)
+      ? + static_cast<Result>(*std::next(x_lo, x_size / 2))
+      : - static_cast<Result>(*std::next(y_lo, y_size / 2));
+
+    // Compute f(tau)
+    auto x_gt = std::partition(x_lo, x_hi, [=](const Data x){
+      return static_cast<Result>(x) > tau; });
+    auto y_ge = std::partition(y_lo, y_hi, [=](const Data y){
+      return static_cast<Result>(y) >= -tau; });
+    Result num_x = static_cast<Result>(std::distance(x_lo, x_gt));
+    Result sum_x = std::accumulate(x_lo, x_gt, static_cast<Result>(0));
+    Result num_y = static_cast<Result>(std::distance(y_lo, y_ge));
+    Result sum_y = std::accumulate(y_lo, y_ge, static_cast<Result>(0));
+
+    if (sum + sum_x - sum_y > (num + num_x + num_y) * tau) {
+      // f(tau) > 0, so t > tau: a <= tau are out, b >= -tau are in
+      x_hi = x_gt;
+      y_lo = y_ge;
+      num += num_y;
+      sum -= sum_y;
+    } else {
+      // t <= tau: a >= tau are in, b <= -tau are out
+      auto x_ge = std::partition(x_gt, x_hi, [=](const Data x){
+        return !(static_cast<Result>(x) < tau); });
+      Result num_eq = static_cast<Result>(std::distance(x_gt, x_ge));
+      x_lo = x_ge;
+      y_hi = std::partition(y_lo, y_ge, [=](const Data y){
+        return static_cast<Result>(y) > -tau; });
+      num += num_x + num_eq;
+      sum += sum_x + num_eq * tau;
+    }
+  }
+
+  // Degenerates to x = y = 0 only if max(a) + max(b) <= 0
+  t = (num > 0) ? sum / num
+    : static_cast<Result>(*std::max_element(a_first, a_last));
+
+  return std::make_pair(
+    make_thresholds(t, lo, hi, a_first, x_lo),
+    make_thresholds(-t, lo, hi, b_first, y_lo));
+}
+
+
+template <typename Result = double,
+          typename Iterator>
+inline void
+prox_two_simplex_pivot(
+    Iterator a_first,
+    Iterator a_last,
+    Iterator b_first,
+    Iterator b_last,
+    const Result rhs = 1
+    ) {
+  prox(a_first, a_last, b_first, b_last,
+       thresholds_two_simplex_pivot<Result, Iterator>, rhs);
+}
+
+
+template <typename Result = double,
+          typename Iterator>
+inline void
+prox_two_simplex_pivot(
+    Iterator a_first,
+    Iterator a_last,
+    Iterator b_first,
+    Iterator b_last,
+    Iterator a_aux,
+    Iterator b_aux,
+    const Result rhs = 1
+    ) {
+  prox(a_first, a_last, b_first, b_last, a_aux, b_aux,
+       thresholds_two_simplex_pivot<Result, Iterator>, rhs);
+}
+
+
+template <typename Result = double,
+          typename Iterator>
+inline void
+prox_two_simplex_pivot(
+    Iterator first,
+    Iterator middle,
+    Iterator last,
+    const Result rhs = 1
+    ) {
+  prox(first, middle, middle, last,
+       thresholds_two_simplex_pivot<Result, Iterator>, rhs);
+}
+
+
+template <typename Result = double,
+          typename Iterator>
+inline void
+prox_two_simplex_pivot(
+    const typename std::iterator_traits<Iterator>::difference_type p,
+    Iterator first,
+    Iterator last,
+    Iterator aux,
+    const Result rhs = 1
+    ) {
+  prox(first, first + p, first + p, last, aux, aux + p,
+       thresholds_two_simplex_pivot<Result, Iterator>, rhs);
+}
+
+
+template <typename Result = double,
+          typename Iterator>
+inline void
+prox_two_simplex_pivot(
+    const typename std::iterator_traits<Iterator>::difference_type dim,
+    const typename std::iterator_traits<Iterator>::difference_type p,
+    Iterator first,
+    Iterator last,
+    Iterator aux,
+    const Result rhs = 1
+    ) {
+  prox(dim, p, first, last, aux,
+       thresholds_two_simplex_pivot<Result, Iterator>, rhs);
+}
+
+}
+
+#endif
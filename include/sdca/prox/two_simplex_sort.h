@@ -70,9 +70,11 @@ thresholds_two_simplex_sort(
     // The right point of the interval cannot exceed C
     Result next_c = std::min(std::min(next_cr, next_cs), C);
 
-    // If the optimal value indeed falls in [c,next_c) we are done
-    if (c <= copt && copt < next_c) {
-      best_c = copt;
+    // If the optimal value indeed falls in [c,next_c) we are done;
+    // if it is below c, the (convex) objective is minimized at c,
+    // which happens for c = 0 if x = y = 0 is the solution
+    if (copt < next_c) {
+      best_c = std::max(c, copt);
       break;
     }
 
@@ -1,13 +1,22 @@
 #ifndef SDCA_SOLVER_H
 #define SDCA_SOLVER_H
 
+#include <algorithm>
 #include <cassert>
+#include <cmath>
+#include <limits>
+#include <memory>
 #include <numeric>
 #include <random>
+#include <sstream>
+#include <stdexcept>
 
+#include "sdca/solver/checkpoint.h"
 #include "sdca/solver/context.h"
 #include "sdca/solver/eval.h"
+#include "sdca/solver/sampling.h"
 #include "sdca/solver/update.h"
+#include "sdca/utility/parallel.h"
 
 namespace sdca {
 
@@ -32,22 +41,130 @@ public:
       context_type& __context
     ) :
       ctx_(__context),
-      is_evaluated_(false)
+      is_evaluated_(false),
+      is_sequential_(false),
+      num_active_(0),
+      order_(nullptr),
+      is_resumed_(false),
+      checkpoint_mark_(0)
   {}
 
 
   void solve() {
+    if (is_resumed_ && (ctx_.status == solver_status::solved ||
+                        ctx_.status == solver_status::no_progress)) {
+      // The checkpoint of a converged run, there is nothing left to do
+      is_resumed_ = false;
+      return;
+    }
+
     begin_solve();
     while (ctx_.status == solver_status::solving) {
 
       begin_epoch();
-      for (auto& example : examples_) {
-        update_variables(example, ctx_, scratch_);
+      if (workers_.empty()) {
+        update_variables_range(0, num_active_, scratch_);
+      } else {
+        update_variables_async();
       }
+      ctx_.num_updates += num_active_;
 
       end_epoch();
+      if (is_checkpoint_due()) {
+        write_checkpoint();
+      }
     }
     end_solve();
+    if (!ctx_.options.checkpoint_path.empty()) {
+      write_checkpoint();
+      wait_checkpoint();
+    }
+  }
+
+
+  /**
+   * Restores the state of the solver from a checkpoint written by solve()
+   * (see checkpoint.h), i.e. the variables, the evaluations, the timings,
+   * the random generator and the order of the examples. The next solve()
+   * then continues exactly where the checkpoint was taken and produces
+   * the same variables as an uninterrupted run.
+   * The final checkpoint records the status of the run: if it has converged
+   * (solved or no_progress), the status is restored and solve() returns
+   * without solving; a run stopped by a limit (e.g. max_epoch) continues
+   * with the limits of the context.
+   * The context must be created for the same problem.
+   **/
+  void resume(
+      const std::string& path
+    ) {
+    checkpoint_reader reader(path);
+    const size_type d = checkpoint_dimensions(ctx_.train.in);
+    const size_type n = ctx_.train.num_examples();
+    const size_type m = ctx_.train.num_classes();
+    reader.check_sizes<Data, Result>(ctx_.is_dual() ? 0 : d, n, m);
+
+    std::vector<char> bytes;
+    reader.read(checkpoint_section::state, bytes);
+    checkpoint_istream state(bytes);
+    std::uint8_t is_evaluated;
+    std::uint32_t status;
+    ctx_.epoch = state.get_size();
+    ctx_.num_updates = state.get_size();
+    const size_type num_active = state.get_size();
+    state.get(is_evaluated);
+    state.get(status);
+    state.get(ctx_.solve_time.cpu.elapsed);
+    state.get(ctx_.solve_time.wall.elapsed);
+    state.get(ctx_.eval_time.cpu.elapsed);
+    state.get(ctx_.eval_time.wall.elapsed);
+    if (state.get_size() != ctx_.test.size()) {
+      throw std::runtime_error("Checkpoint has a different number of "
+                               "test sets.");
+    }
+    is_evaluated_ = is_evaluated != 0;
+    ctx_.status = static_cast<solver_status>(status);
+
+    reader.read(checkpoint_section::dual_variables, ctx_.dual_variables,
+                m * n * sizeof(Data));
+    if (!ctx_.is_dual()) {
+      reader.read(checkpoint_section::primal_variables, ctx_.primal_variables,
+                  d * m * sizeof(Data));
+    }
+
+    reader.read(checkpoint_section::generator, bytes);
+    std::istringstream generator(std::string(bytes.begin(), bytes.end()));
+    generator >> generator_;
+
+    reader.read(checkpoint_section::examples, examples_);
+    reader.read(checkpoint_section::idle, idle_);
+    reader.read(checkpoint_section::changes, changes_);
+    if (examples_.size() != n || num_active > n) {
+      throw std::runtime_error("Checkpoint has an invalid active set.");
+    }
+    num_active_ = num_active;
+
+    reader.read(checkpoint_section::train_evals, bytes);
+    checkpoint_istream train_evals(bytes);
+    get_evals(train_evals, ctx_.train.evals);
+    reader.read(checkpoint_section::test_evals, bytes);
+    checkpoint_istream test_evals(bytes);
+    for (auto& test_set : ctx_.test) {
+      get_evals(test_evals, test_set.evals);
+    }
+
+    is_resumed_ = true;
+    reporting::resume(ctx_, path);
+  }
+
+
+  /**
+   * Exchanges the scratch space with the given one, so that its allocation
+   * can be reused by the solvers of the same training set.
+   **/
+  void swap_scratch(
+      scratch_type& scratch
+    ) {
+    std::swap(scratch_, scratch);
   }
 
 
@@ -59,6 +176,32 @@ protected:
   std::minstd_rand generator_;
   std::vector<size_type> examples_;
 
+  // The worker scratch spaces of the asynchronous updates (none if the
+  // updates are driven one at a time by another solver, see multi_solver)
+  bool is_sequential_;
+  std::vector<scratch_type> workers_;
+
+  // Active set: the examples [0, num_active_) in examples_ are updated,
+  // idle_[i] counts consecutive negligible updates of the example i
+  size_type num_active_;
+  std::vector<size_type> idle_;
+
+  // The order of the updates in an epoch (examples_ or schedule_),
+  // changes_[i] is the change of the dual variables in the last update of i
+  const size_type* order_;
+  std::vector<size_type> schedule_;
+  std::vector<Data> changes_;
+  std::vector<size_type> visited_;
+  std::vector<double> weights_;
+  alias_table table_;
+  sampling_stats sampling_stats_;
+
+  // Checkpoints: resume() restores the state that begin_solve() would reset,
+  // checkpoint_mark_ is the wall time of the last checkpoint
+  bool is_resumed_;
+  double checkpoint_mark_;
+  std::unique_ptr<checkpoint_writer> checkpoint_;
+
 
   void begin_solve() {
     reporting::begin_solve(ctx_);
@@ -67,19 +210,30 @@ protected:
                   ? solver_status::solving
                   : solver_status::max_epoch;
 
-    scratch_.init(ctx_.train);
-    if (ctx_.criteria.eval_on_start) {
+    scratch_.init(ctx_.train, ctx_.options.eval_block_size);
+    init_workers();
+    if (ctx_.criteria.eval_on_start && !is_resumed_) {
       evaluate_solution();
       check_stopping_criteria<Data, Result>(ctx_);
     }
 
     if (ctx_.status == solver_status::solving) {
-      generator_.seed();
-      examples_.resize(ctx_.train.num_examples());
-      std::iota(examples_.begin(), examples_.end(), 0);
+      if (is_resumed_) {
+        // The generator, the order and the active set are restored
+        schedule_.clear();
+        visited_.assign(examples_.size(), 0);
+      } else {
+        generator_.seed();
+        examples_.resize(ctx_.train.num_examples());
+        std::iota(examples_.begin(), examples_.end(), 0);
+        reactivate_examples();
+        init_sampling();
+      }
 
+      checkpoint_mark_ = ctx_.wall_time_now();
       ctx_.solve_time.resume();
     }
+    is_resumed_ = false;
   }
 
 
@@ -95,8 +249,15 @@ protected:
 
   void begin_epoch() {
     is_evaluated_ = false;
-    if (need_shuffle<input_type>::value)
-      std::shuffle(examples_.begin(), examples_.end(), generator_);
+    order_ = examples_.data();
+    if (!need_shuffle<input_type>::value) return;
+
+    if (ctx_.options.sampling == sampling_type::uniform) {
+      std::shuffle(examples_.begin(), examples_.begin() + num_active_,
+                   generator_);
+    } else {
+      sample_epoch();
+    }
   }
 
 
@@ -104,33 +265,329 @@ protected:
     ctx_.solve_time.stop();
 
     ++ctx_.epoch;
-    if ((ctx_.criteria.eval_epoch > 0) &&
-        (ctx_.epoch % ctx_.criteria.eval_epoch == 0)) {
+    shrink_examples();
+    const bool is_eval_epoch = (ctx_.criteria.eval_epoch > 0) &&
+      (ctx_.epoch % ctx_.criteria.eval_epoch == 0);
+    if (is_eval_epoch || num_active_ == 0 ||
+        ctx_.epoch >= ctx_.criteria.max_epoch) {
+      // The stopping criteria are checked with all examples active;
+      // an empty active set is refilled (e.g. without evaluations)
+      reactivate_examples();
+    }
+    if (is_eval_epoch) {
       evaluate_solution();
     }
 
     check_stopping_criteria<Data, Result>(ctx_);
 
+    if (order_ == schedule_.data()) {
+      reporting::sample_examples(ctx_, sampling_stats_);
+    }
     reporting::end_epoch(ctx_, is_evaluated_);
 
     ctx_.solve_time.resume();
   }
 
 
+  bool is_checkpoint_due() const {
+    const solver_options& opts = ctx_.options;
+    if (opts.checkpoint_path.empty() ||
+        ctx_.status != solver_status::solving) return false;
+    return (opts.checkpoint_epoch > 0 &&
+            ctx_.epoch % opts.checkpoint_epoch == 0) ||
+           (opts.checkpoint_wall_time > 0 &&
+            ctx_.wall_time_now() - checkpoint_mark_ >=
+              opts.checkpoint_wall_time);
+  }
+
+
+  /*
+   * Copies the state into the free buffer of the writer and writes it
+   * to disk in the background while the solver continues (see checkpoint.h).
+   * The copy is not accounted in the solve time.
+   */
+  void write_checkpoint() {
+    const bool is_running = ctx_.solve_time.wall.is_running;
+    ctx_.solve_time.stop();
+    if (!checkpoint_) {
+      checkpoint_.reset(new checkpoint_writer());
+    }
+
+    const size_type d = checkpoint_dimensions(ctx_.train.in);
+    const size_type n = ctx_.train.num_examples();
+    const size_type m = ctx_.train.num_classes();
+    checkpoint_builder builder(ctx_.options.checkpoint_page_aligned);
+    builder.set_sizes<Data, Result>(ctx_.is_dual() ? 0 : d, n, m);
+
+    checkpoint_ostream state;
+    state.put_size(ctx_.epoch);
+    state.put_size(ctx_.num_updates);
+    state.put_size(num_active_);
+    state.put(static_cast<std::uint8_t>(is_evaluated_));
+    state.put(static_cast<std::uint32_t>(ctx_.status));
+    state.put(ctx_.solve_time.cpu.elapsed);
+    state.put(ctx_.solve_time.wall.elapsed);
+    state.put(ctx_.eval_time.cpu.elapsed);
+    state.put(ctx_.eval_time.wall.elapsed);
+    state.put_size(ctx_.test.size());
+    builder.add(checkpoint_section::state, state);
+
+    builder.add(checkpoint_section::dual_variables, ctx_.dual_variables,
+                m * n * sizeof(Data));
+    if (!ctx_.is_dual()) {
+      builder.add(checkpoint_section::primal_variables,
+                  ctx_.primal_variables, d * m * sizeof(Data));
+    }
+
+    std::ostringstream generator;
+    generator << generator_;
+    const std::string str = generator.str();
+    builder.add(checkpoint_section::generator, str.data(), str.size());
+
+    builder.add(checkpoint_section::examples, examples_);
+    builder.add(checkpoint_section::idle, idle_);
+    builder.add(checkpoint_section::changes, changes_);
+
+    checkpoint_ostream train_evals;
+    put_evals(train_evals, ctx_.train.evals);
+    builder.add(checkpoint_section::train_evals, train_evals);
+    checkpoint_ostream test_evals;
+    for (const auto& test_set : ctx_.test) {
+      put_evals(test_evals, test_set.evals);
+    }
+    builder.add(checkpoint_section::test_evals, test_evals);
+
+    builder.serialize(checkpoint_->buffer());
+    if (!checkpoint_->write(ctx_.options.checkpoint_path)) {
+      reporting::checkpoint_failed(ctx_);
+    }
+    reporting::checkpoint(ctx_);
+
+    checkpoint_mark_ = ctx_.wall_time_now();
+    if (is_running) {
+      ctx_.solve_time.resume();
+    }
+  }
+
+
+  void wait_checkpoint() {
+    if (checkpoint_ && !checkpoint_->wait()) {
+      reporting::checkpoint_failed(ctx_);
+    }
+  }
+
+
   void evaluate_solution() {
     ctx_.eval_time.resume();
 
+#ifndef SDCA_ACCURATE_MATH
+    // Asynchronous updates may lose some of the primal increments
+    if (!workers_.empty()) {
+      recompute_primal_variables(ctx_.train.num_classes(),
+        ctx_.train.num_examples(), ctx_.train, ctx_);
+    }
+#endif
+
     evaluate_dataset(ctx_, ctx_.train, scratch_);
 
-    size_type id(0);
-    for (auto& test_set : ctx_.test) {
-      evaluate_dataset(ctx_, test_set, scratch_, id++);
+    // The test sets only read the model and are evaluated concurrently,
+    // the remaining threads are split evenly between them
+    size_type num_threads = resolve_num_threads(ctx_.options.num_threads);
+    size_type num_sets = ctx_.test.size();
+    if (num_threads > 1 && num_sets > 1) {
+      size_type num_inner = std::max(static_cast<size_type>(1),
+                                     num_threads / num_sets);
+      parallel_for(num_threads, 0, num_sets,
+        [&](const size_type, const size_type first, const size_type last) {
+          for (size_type id = first; id < last; ++id) {
+            compute_evaluation(ctx_, ctx_.test[id], num_inner);
+          }
+        });
+      for (size_type id = 0; id < num_sets; ++id) {
+        reporting::eval_created(ctx_.test[id].evals.back(), id);
+      }
+    } else {
+      size_type id(0);
+      for (auto& test_set : ctx_.test) {
+        evaluate_dataset(ctx_, test_set, scratch_, id++);
+      }
     }
 
     is_evaluated_ = true;
     ctx_.eval_time.stop();
   }
 
+
+  /*
+   * Shrinking: an example whose updates were negligible for
+   * shrink_visits consecutive visits is removed from the active set,
+   * i.e. moved past num_active_ in examples_ (liblinear style [1]).
+   * All examples are reactivated before the stopping criteria are checked,
+   * in the last epoch and whenever the active set becomes empty.
+   *
+   * [1] Hsieh CJ, Chang KW, Lin CJ, Keerthi SS, Sundararajan S.
+   *     A dual coordinate descent method for large-scale linear SVM.
+   *     ICML 2008.
+   */
+  void shrink_examples() {
+    if (idle_.empty()) return;
+    const size_type visits = ctx_.options.shrink_visits;
+    auto last = std::stable_partition(examples_.begin(),
+      examples_.begin() + num_active_,
+      [this, visits](const size_type i) { return idle_[i] < visits; });
+    num_active_ = static_cast<size_type>(last - examples_.begin());
+    reporting::shrink_examples(ctx_, num_active_);
+  }
+
+
+  void reactivate_examples() {
+    num_active_ = examples_.size();
+    if (ctx_.options.shrink_visits > 0) {
+      idle_.assign(num_active_, 0);
+    } else {
+      idle_.clear();
+    }
+  }
+
+
+  void init_sampling() {
+    const size_type n = examples_.size();
+    if (ctx_.options.shrink_visits > 0 ||
+        ctx_.options.sampling == sampling_type::adaptive) {
+      changes_.assign(n, 0);
+    } else {
+      changes_.clear();
+    }
+    schedule_.clear();
+    visited_.assign(n, 0);
+  }
+
+
+  /*
+   * Draws the examples of the next epoch with replacement from the active
+   * examples (see sample_examples). Every worker draws from its own block
+   * of the examples, so the workers never update the same example.
+   */
+  void sample_epoch() {
+    const size_type n = num_active_;
+    const size_type num_blocks = (workers_.size() > 1 && n > 1)
+      ? std::min(workers_.size(), n) : 1;
+
+    sampling_stats_ = sampling_stats();
+    schedule_.resize(n);
+    for (size_type t = 0; t < num_blocks; ++t) {
+      size_type first = block_begin(0, n, num_blocks, t);
+      size_type last = block_begin(0, n, num_blocks, t + 1);
+      if (ctx_.options.sampling == sampling_type::importance) {
+        sample_examples(first, last, examples_.data(),
+          [this](const size_type i) {
+            return sampling_norm(i, ctx_, scratch_); },
+          generator_, weights_, table_, schedule_.data(), sampling_stats_);
+      } else {
+        sample_examples(first, last, examples_.data(),
+          [this](const size_type i) { return changes_[i]; },
+          generator_, weights_, table_, schedule_.data(), sampling_stats_);
+      }
+    }
+    order_ = schedule_.data();
+
+    // Count the distinct examples (visited_ stores the epoch of the draw)
+    const size_type stamp = ctx_.epoch + 1;
+    for (size_type i : schedule_) {
+      if (visited_[i] != stamp) {
+        visited_[i] = stamp;
+        ++sampling_stats_.num_distinct;
+      }
+    }
+  }
+
+
+  void init_workers() {
+    workers_.clear();
+    if (is_sequential_ || !is_async_update_supported<input_type>::value) {
+      return;
+    }
+
+    // Every worker thread gets its own copy of the scratch space
+    size_type num_threads = resolve_num_threads(ctx_.options.num_threads);
+    if (num_threads > 1) {
+      workers_.assign(num_threads, scratch_);
+    }
+  }
+
+
+  /*
+   * Lock-free asynchronous updates (Hogwild! style).
+   * Each worker processes a disjoint block of the shuffled examples,
+   * hence the dual variables are never shared between the threads,
+   * while the rank-1 updates of the primal variables are not synchronized.
+   *
+   * With kernels, every worker writes only the dual variables of its own
+   * examples, and the scores read the dual variables of the other workers.
+   * Since a worker has at most one update in flight, the scores miss
+   * at most num_threads - 1 updates (bounded staleness), and no primal
+   * variables need to be synchronized.
+   *
+   * [1] Recht B, Re C, Wright S, Niu F.
+   *     Hogwild: A lock-free approach to parallelizing
+   *     stochastic gradient descent.
+   *     NIPS 2011.
+   *
+   * [2] Hsieh CJ, Yu HF, Dhillon IS.
+   *     PASSCoDe: Parallel ASynchronous Stochastic dual Co-ordinate Descent.
+   *     ICML 2015.
+   */
+  void update_variables_async() {
+    parallel_for(workers_.size(), 0, num_active_,
+      [this](const size_type t, const size_type first, const size_type last) {
+        update_variables_range(first, last, workers_[t]);
+      });
+  }
+
+
+  void update_variables_range(
+      size_type first,
+      const size_type last,
+      scratch_type& scratch
+    ) {
+    // Every example belongs to one worker, so changes_ and idle_
+    // are updated without races
+    Data* changes = changes_.empty() ? nullptr : changes_.data();
+    const size_type batch_size = ctx_.options.batch_size;
+    if (batch_size > 1) {
+      const Data beta = static_cast<Data>(ctx_.options.batch_beta);
+      for (; first < last; first += batch_size) {
+        const size_type* batch_last = order_ + std::min(first + batch_size,
+                                                        last);
+        update_variables_batch(order_ + first, batch_last, beta, ctx_,
+          scratch, changes);
+        update_idle(order_ + first, batch_last);
+      }
+    } else {
+      for (; first != last; ++first) {
+        const size_type i = order_[first];
+        Data change = update_variables(i, ctx_, scratch);
+        if (changes != nullptr) {
+          changes[i] = change;
+          update_idle(order_ + first, order_ + first + 1);
+        }
+      }
+    }
+  }
+
+
+  void update_idle(
+      const size_type* first,
+      const size_type* last
+    ) {
+    if (idle_.empty()) return;
+    for (; first != last; ++first) {
+      const size_type i = *first;
+      idle_[i] = (changes_[i] > std::numeric_limits<Data>::epsilon())
+        ? 0 : idle_[i] + 1;
+    }
+  }
+
 };
 
 
@@ -146,6 +603,675 @@ make_solver(
   return solver<Data, Result, Input, Output, Objective>(ctx);
 }
 
+
+/*
+ * Accelerated proximal SDCA [1] in the form of Catalyst [2].
+ * Let F(W) = 1/2 ||W - W0||^2 + c * sum_i L_i(W' x_i) be the objective
+ * (W0 = 0 if there is no proximal term). The outer loop approximately
+ * minimizes F(W) + kappa/2 ||W - Y||^2 for an extrapolated center Y,
+ * which is again a proximal problem of the above form with
+ *    W0' = (W0 + kappa * Y) / (1 + kappa),    c' = c / (1 + kappa),
+ * hence solved by the plain solver with a warm-started A' = A / (1 + kappa).
+ * The inner problems are better conditioned and are solved to a relative
+ * duality gap that decreases geometrically, while the outer loop stops on
+ * the duality gap of the original problem with A = (1 + kappa) * A'.
+ *
+ * [1] Shalev-Shwartz S, Zhang T.
+ *     Accelerated proximal stochastic dual coordinate ascent
+ *     for regularized loss minimization.
+ *     Mathematical Programming. 2016;155(1):105-145.
+ *
+ * [2] Lin H, Mairal J, Harchaoui Z.
+ *     A universal catalyst for first-order optimization.
+ *     NIPS 2015.
+ */
+template <typename Data,
+          typename Result,
+          template <typename> class Input,
+          typename Output,
+          template <typename, typename> class Objective>
+class accelerated_solver
+    : public solver<Data, Result, Input, Output, Objective> {
+public:
+  typedef solver<Data, Result, Input, Output, Objective> base;
+  typedef typename base::input_type input_type;
+  typedef typename base::context_type context_type;
+
+
+  explicit accelerated_solver(
+      context_type& __context
+    ) :
+      base::solver(__context),
+      kappa_(0)
+  {}
+
+
+  void solve() {
+    if (ctx_.options.accelerate) {
+      solve_accelerated(is_acceleration_supported<input_type>());
+    } else {
+      base::solve();
+    }
+  }
+
+
+protected:
+  using base::ctx_;
+  using base::scratch_;
+
+  double kappa_;
+  std::vector<Data> center_; // the prox center W0' of the inner problem
+  std::vector<Data> previous_; // the previous solution of the inner problem
+  std::vector<Data> extrapolated_; // the extrapolated solution Y
+
+
+  void solve_accelerated(std::false_type) {
+    base::solve();
+  }
+
+
+  void solve_accelerated(std::true_type) {
+    scratch_.init(ctx_.train, ctx_.options.eval_block_size);
+    kappa_ = resolve_kappa();
+    if (!(kappa_ > 0)) {
+      // Well-conditioned problem, nothing to accelerate
+      base::solve();
+      return;
+    }
+
+    reporting::begin_solve(ctx_);
+
+    ctx_.status = (ctx_.criteria.max_epoch > ctx_.epoch)
+                  ? solver_status::solving
+                  : solver_status::max_epoch;
+
+    if (ctx_.criteria.eval_on_start) {
+      this->evaluate_solution();
+      check_stopping_criteria<Data, Result>(ctx_);
+    }
+
+    if (ctx_.status == solver_status::solving) {
+      ctx_.solve_time.resume();
+      solve_outer();
+    }
+
+    this->end_solve();
+  }
+
+
+  void solve_outer() {
+    const Data q = static_cast<Data>(1 / (1 + kappa_));
+    const Data sqrt_q = std::sqrt(q);
+    const Data beta = (1 - sqrt_q) / (1 + sqrt_q);
+
+    const blas_int DM = static_cast<blas_int>(
+      ctx_.train.num_dimensions() * ctx_.train.num_classes());
+    Data* W = ctx_.primal_variables;
+    center_.resize(static_cast<size_type>(DM));
+    previous_.assign(W, W + DM);
+    extrapolated_.resize(static_cast<size_type>(DM));
+
+    // The first center is the current solution, Y = W
+    set_center(W, q);
+    to_inner();
+
+    context_type inner(typename context_type::train_set_type(ctx_.train),
+      scale_objective(ctx_.objective, static_cast<Result>(q)),
+      ctx_.dual_variables, W, &center_[0]);
+    inner.train.evals.clear();
+    inner.options = ctx_.options;
+    inner.options.accelerate = false;
+    inner.options.checkpoint_path.clear();
+    inner.epoch = ctx_.epoch;
+    inner.num_updates = ctx_.num_updates;
+
+    // The relative duality gap of the inner problems decreases
+    // at the rate of the outer loop (down to a fraction of epsilon)
+    const double rho = 0.9 * std::sqrt(static_cast<double>(q));
+    double inner_epsilon = 0.1;
+    for (size_type iteration = 1; ; ++iteration) {
+      set_inner_criteria(inner_epsilon, inner);
+      solve_inner(inner);
+      ctx_.solve_time.stop();
+
+      ctx_.epoch = inner.epoch;
+      ctx_.num_updates = inner.num_updates;
+
+      to_original();
+      this->evaluate_solution();
+      // The outer iterates are not monotone in the dual objective,
+      // and only the duality gap of the original problem is decisive
+      check_stopping_criteria<Data, Result>(ctx_, false);
+
+      reporting::accelerate(ctx_, inner, iteration, kappa_);
+      ctx_.solve_time.resume();
+      if (ctx_.status != solver_status::solving) break;
+
+      // Let Y = W + beta * (W - W_prev), where W solves the inner problem
+      to_inner();
+      sdca_blas_copy(DM, &previous_[0], &extrapolated_[0]);
+      sdca_blas_axpby(DM, 1 + beta, W, -beta, &extrapolated_[0]);
+      sdca_blas_copy(DM, W, &previous_[0]);
+
+      // Move the center and keep W = W0' + X * A'
+      sdca_blas_axpy(DM, -1, &center_[0], W);
+      set_center(&extrapolated_[0], q);
+      sdca_blas_axpy(DM, 1, &center_[0], W);
+
+      inner_epsilon = std::max(0.1 * ctx_.criteria.epsilon,
+                               (1 - rho) * inner_epsilon);
+    }
+  }
+
+
+  void solve_inner(
+      context_type& inner
+    ) {
+    // The inner solves are only reported in the debug mode,
+    // their warnings (e.g. on the numerical precision) are not decisive
+    const logging::level level = logging::get_level();
+    if (level < logging::level::debug) {
+      logging::set_level(logging::level::none);
+    }
+    make_solver(inner).solve();
+    logging::set_level(level);
+  }
+
+
+  void set_inner_criteria(
+      const double epsilon,
+      context_type& inner
+    ) const {
+    inner.criteria = ctx_.criteria;
+    inner.criteria.epsilon = epsilon;
+    // The inner problems are well-conditioned and need few epochs
+    inner.criteria.eval_epoch = 2;
+    inner.criteria.eval_on_start = false;
+    if (ctx_.criteria.max_cpu_time > 0) {
+      inner.criteria.max_cpu_time = inner.cpu_time() +
+        std::max(0.0, ctx_.criteria.max_cpu_time - ctx_.cpu_time_now());
+    }
+    if (ctx_.criteria.max_wall_time > 0) {
+      inner.criteria.max_wall_time = inner.wall_time() +
+        std::max(0.0, ctx_.criteria.max_wall_time - ctx_.wall_time_now());
+    }
+    inner.train.evals.clear();
+  }
+
+
+  /**
+   * The condition number of the problem is estimated as
+   *    c_loss * max_i ||x_i||^2,
+   * where c_loss is the coefficient of the primal loss (e.g. c/gamma),
+   * and kappa is chosen such that the inner problems are well-conditioned.
+   **/
+  double resolve_kappa() const {
+    if (ctx_.options.accel_kappa > 0) return ctx_.options.accel_kappa;
+    if (scratch_.norms.empty()) return 0;
+    const double max_norm2 = static_cast<double>(
+      *std::max_element(scratch_.norms.begin(), scratch_.norms.end()));
+    return static_cast<double>(ctx_.objective.coeff_primal_loss)
+      * max_norm2 - 1;
+  }
+
+
+  // Let W0' = q * (W0 + kappa * Y)
+  void set_center(
+      const Data* Y,
+      const Data q
+    ) {
+    const blas_int DM = static_cast<blas_int>(center_.size());
+    sdca_blas_copy(DM, Y, &center_[0]);
+    sdca_blas_scal(DM, static_cast<Data>(kappa_) * q, &center_[0]);
+    if (ctx_.is_prox()) {
+      sdca_blas_axpy(DM, q, ctx_.primal_initial, &center_[0]);
+    }
+  }
+
+
+  // Let A' = q * A and W' = W0' + q * (W - W0), where q = 1 / (1 + kappa)
+  void to_inner() {
+    const Data q = static_cast<Data>(1 / (1 + kappa_));
+    const blas_int DM = static_cast<blas_int>(center_.size());
+    Data* W = ctx_.primal_variables;
+    scale_dual_variables(q);
+    if (ctx_.is_prox()) {
+      sdca_blas_axpy(DM, -1, ctx_.primal_initial, W);
+    }
+    sdca_blas_scal(DM, q, W);
+    sdca_blas_axpy(DM, 1, &center_[0], W);
+  }
+
+
+  // Let A = A' / q and W = W0 + (W' - W0') / q
+  void to_original() {
+    const Data inv_q = static_cast<Data>(1 + kappa_);
+    const blas_int DM = static_cast<blas_int>(center_.size());
+    Data* W = ctx_.primal_variables;
+    scale_dual_variables(inv_q);
+    sdca_blas_axpy(DM, -1, &center_[0], W);
+    sdca_blas_scal(DM, inv_q, W);
+    if (ctx_.is_prox()) {
+      sdca_blas_axpy(DM, 1, ctx_.primal_initial, W);
+    }
+  }
+
+
+  void scale_dual_variables(
+      const Data factor
+    ) {
+    sdca_blas_scal(static_cast<blas_int>(
+      ctx_.train.num_classes() * ctx_.train.num_examples()),
+      factor, ctx_.dual_variables);
+  }
+
+};
+
+
+template <typename Data,
+          typename Result,
+          template <typename> class Input,
+          typename Output,
+          template <typename, typename> class Objective>
+inline accelerated_solver<Data, Result, Input, Output, Objective>
+make_accelerated_solver(
+    solver_context<Data, Result, Input, Output, Objective>& ctx
+  ) {
+  return accelerated_solver<Data, Result, Input, Output, Objective>(ctx);
+}
+
+
+/**
+ * The solution of the problem for one value of c (or gamma) on
+ * a regularization path; gamma is 0 on a path over c.
+ **/
+template <typename Context>
+struct path_point {
+  typedef typename Context::result_type result_type;
+  typedef typename Context::train_eval_type train_eval_type;
+  typedef typename Context::test_eval_type test_eval_type;
+
+  result_type c = result_type();
+  result_type gamma = result_type();
+  solver_status status = solver_status::none;
+  size_type epoch = 0;
+  size_type num_updates = 0;
+  double cpu_time = 0;
+  double wall_time = 0;
+  std::vector<train_eval_type> train_evals;
+  std::vector<std::vector<test_eval_type>> test_evals;
+
+
+  inline std::string to_string() const {
+    std::ostringstream str;
+    str.copyfmt(std::cout);
+    str << "c: " << c << ", ";
+    if (gamma > 0) str << "gamma: " << gamma << ", ";
+    str << "status: " << solver_status_name(status) << ", "
+           "epoch: " << epoch << ", "
+           "cpu_time: " << cpu_time << ", "
+           "wall_time: " << wall_time;
+    return str.str();
+  }
+};
+
+
+/*
+ * Solves the problem of the context for a sequence of values of c
+ * (features and kernels), keeping k and gamma of its objective.
+ * Every solve is warm-started from the previous solution:
+ * the feasible sets of the dual variables scale with c, hence
+ *    A = (c_new / c_old) * A,    W = W0 + (c_new / c_old) * (W - W0)
+ * are feasible and consistent for the next c. An increasing sequence
+ * of c works best, since the solutions for small c are cheap to compute
+ * and the path then follows the increasingly harder problems.
+ * The variables of the context are the solution for the last c on return,
+ * while the evaluations for every c are stored in the path points.
+ *
+ * The objectives with the parameter gamma (see has_param_gamma) can also
+ * follow a path over gamma for the current c (see solve_gamma).
+ * The feasible sets of the dual variables do not depend on gamma,
+ * hence the previous solution is a feasible warm start as is.
+ */
+template <typename Data,
+          typename Result,
+          template <typename> class Input,
+          typename Output,
+          template <typename, typename> class Objective>
+class path_solver {
+public:
+  typedef solver_context<Data, Result, Input, Output, Objective> context_type;
+  typedef typename context_type::objective_type objective_type;
+  typedef solver_scratch<Data, Input> scratch_type;
+  typedef path_point<context_type> point_type;
+
+
+  explicit path_solver(
+      context_type& __context
+    ) :
+      ctx_(__context),
+      c_(ctx_.objective.c)
+  {}
+
+
+  template <typename Iterator>
+  void solve(
+      Iterator first,
+      Iterator last
+    ) {
+    for (; first != last; ++first) {
+      solve_point(static_cast<Result>(*first));
+    }
+  }
+
+
+  // A path over gamma for the current c, e.g. a decreasing gamma
+  // to approach the non-smooth loss
+  template <typename Iterator>
+  void solve_gamma(
+      Iterator first,
+      Iterator last
+    ) {
+    static_assert(has_param_gamma<objective_type>::value,
+                  "The objective has no parameter gamma");
+    for (; first != last; ++first) {
+      const Result gamma = static_cast<Result>(*first);
+      solve_point(objective_with_gamma(
+        scale_objective(ctx_.objective, c_ / ctx_.objective.c), gamma), gamma);
+    }
+  }
+
+
+  const std::vector<point_type>& points() const { return points_; }
+
+
+protected:
+  context_type& ctx_;
+  scratch_type scratch_;
+  std::vector<point_type> points_;
+
+  // The value of c the variables of the context are feasible for
+  Result c_;
+
+
+  void solve_point(
+      const Result c
+    ) {
+    scale_variables(static_cast<Data>(c / c_));
+    c_ = c;
+    solve_point(scale_objective(ctx_.objective, c / ctx_.objective.c), 0);
+  }
+
+
+  void solve_point(
+      objective_type objective,
+      const Result gamma
+    ) {
+    context_type point(typename context_type::train_set_type(ctx_.train),
+      std::move(objective), ctx_.dual_variables, ctx_.primal_variables,
+      ctx_.primal_initial);
+    point.train.evals.clear();
+    for (const auto& test_set : ctx_.test) {
+      point.test.push_back(test_set);
+      point.test.back().evals.clear();
+    }
+    point.criteria = ctx_.criteria;
+    point.options = ctx_.options;
+    point.options.checkpoint_path.clear();
+
+    auto solver = make_accelerated_solver(point);
+    solver.swap_scratch(scratch_);
+    solver.solve();
+    solver.swap_scratch(scratch_);
+
+    points_.emplace_back();
+    point_type& p = points_.back();
+    p.c = c_;
+    p.gamma = gamma;
+    p.status = point.status;
+    p.epoch = point.epoch;
+    p.num_updates = point.num_updates;
+    p.cpu_time = point.cpu_time();
+    p.wall_time = point.wall_time();
+    p.train_evals = std::move(point.train.evals);
+    for (auto& test_set : point.test) {
+      p.test_evals.push_back(std::move(test_set.evals));
+    }
+    reporting::path_point(p);
+  }
+
+
+  void scale_variables(
+      const Data factor
+    ) {
+    if (factor == 1) return;
+    const auto& d = ctx_.train;
+    sdca_blas_scal(static_cast<blas_int>(d.num_classes() * d.num_examples()),
+      factor, ctx_.dual_variables);
+    scale_primal_variables(factor, primal_dimensions(d.in) * d.num_classes());
+  }
+
+
+  // W - W0 = X * A' scales with A (no primal variables with kernels)
+  void scale_primal_variables(
+      const Data factor,
+      const size_type size
+    ) {
+    if (size == 0) return;
+    const blas_int DM = static_cast<blas_int>(size);
+    Data* W = ctx_.primal_variables;
+    if (ctx_.is_prox()) sdca_blas_axpy(DM, -1, ctx_.primal_initial, W);
+    sdca_blas_scal(DM, factor, W);
+    if (ctx_.is_prox()) sdca_blas_axpy(DM, 1, ctx_.primal_initial, W);
+  }
+
+};
+
+
+template <typename Data,
+          typename Result,
+          template <typename> class Input,
+          typename Output,
+          template <typename, typename> class Objective>
+inline path_solver<Data, Result, Input, Output, Objective>
+make_path_solver(
+    solver_context<Data, Result, Input, Output, Objective>& ctx
+  ) {
+  return path_solver<Data, Result, Input, Output, Objective>(ctx);
+}
+
+
+/*
+ * A model trained by multi_solver, i.e. a solver whose epochs are driven
+ * one example at a time in the order given by multi_solver.
+ */
+template <typename Data>
+class multi_solver_model {
+public:
+  virtual ~multi_solver_model() {}
+
+  virtual void begin_solve() = 0;
+
+  virtual void end_solve() = 0;
+
+  virtual void begin_epoch() = 0;
+
+  virtual void end_epoch() = 0;
+
+  virtual void update_variables(const size_type i) = 0;
+
+  virtual bool is_solving() const = 0;
+
+  virtual const Data* features() const = 0;
+
+  virtual size_type num_examples() const = 0;
+
+  virtual size_type num_dimensions() const = 0;
+};
+
+
+template <typename Data,
+          typename Result,
+          typename Output,
+          template <typename, typename> class Objective>
+class multi_solver_model_impl
+    : public solver<Data, Result, feature_input, Output, Objective>,
+      public multi_solver_model<Data> {
+public:
+  typedef solver<Data, Result, feature_input, Output, Objective> base;
+  typedef typename base::context_type context_type;
+
+
+  explicit multi_solver_model_impl(
+      context_type& __context
+    ) :
+      base::solver(__context)
+  {
+    // The updates are sequential, the evaluation may still use threads
+    this->is_sequential_ = true;
+  }
+
+
+  void begin_solve() override { base::begin_solve(); }
+
+
+  void end_solve() override { base::end_solve(); }
+
+
+  void begin_epoch() override {
+    this->is_evaluated_ = false;
+    this->order_ = this->examples_.data();
+  }
+
+
+  void end_epoch() override { base::end_epoch(); }
+
+
+  void update_variables(
+      const size_type i
+    ) override {
+    sdca::update_variables(i, this->ctx_, this->scratch_);
+    ++this->ctx_.num_updates;
+  }
+
+
+  bool is_solving() const override {
+    return this->ctx_.status == solver_status::solving;
+  }
+
+
+  const Data* features() const override {
+    return this->ctx_.train.in.features;
+  }
+
+
+  size_type num_examples() const override {
+    return this->ctx_.train.num_examples();
+  }
+
+
+  size_type num_dimensions() const override {
+    return this->ctx_.train.num_dimensions();
+  }
+};
+
+
+/*
+ * Trains several models on the same feature matrix in one pass per epoch.
+ * Every example is visited once per epoch (in a shared random order),
+ * and all models that are still solving update their variables for it
+ * while its features are in the cache. Every model keeps its own
+ * evaluations and stopping status in its context.
+ * NOTE: the solve_time in the context of a model is the time of the shared
+ * passes, i.e. it includes the updates of the other models; the time of the
+ * whole solve is reported once by solve_time().
+ * The models are updated sequentially, i.e. without the mini-batches,
+ * sampling, shrinking and asynchronous updates of the solver options.
+ * All models use the feature_input<Data> (see add()) of the same matrix.
+ */
+template <typename Data>
+class multi_solver {
+public:
+  typedef Data data_type;
+
+
+  template <typename Result,
+            typename Output,
+            template <typename, typename> class Objective>
+  void add(
+      solver_context<Data, Result, feature_input, Output, Objective>& ctx
+    ) {
+    // The input type and precision are fixed by the signature
+    typedef multi_solver_model_impl<Data, Result, Output, Objective> model;
+    if (!models_.empty() &&
+        (models_[0]->features() != ctx.train.in.features ||
+         models_[0]->num_examples() != ctx.train.num_examples() ||
+         models_[0]->num_dimensions() != ctx.train.num_dimensions())) {
+      throw std::invalid_argument("All models must share the features.");
+    }
+    models_.emplace_back(new model(ctx));
+  }
+
+
+  void solve() {
+    if (models_.empty()) return;
+    solve_time_.start();
+    for (auto& m : models_) {
+      m->begin_solve();
+    }
+
+    generator_.seed();
+    examples_.resize(models_[0]->num_examples());
+    std::iota(examples_.begin(), examples_.end(), 0);
+
+    std::vector<multi_solver_model<Data>*> active;
+    while (collect_active(active)) {
+      std::shuffle(examples_.begin(), examples_.end(), generator_);
+      for (auto m : active) {
+        m->begin_epoch();
+      }
+      for (size_type i : examples_) {
+        for (auto m : active) {
+          m->update_variables(i);
+        }
+      }
+      for (auto m : active) {
+        m->end_epoch();
+      }
+    }
+
+    for (auto& m : models_) {
+      m->end_solve();
+    }
+    solve_time_.stop();
+  }
+
+
+  size_type num_models() const { return models_.size(); }
+
+  // The time of the last solve (all models)
+  const stopwatch& solve_time() const { return solve_time_; }
+
+
+protected:
+  std::vector<std::unique_ptr<multi_solver_model<Data>>> models_;
+  stopwatch solve_time_;
+  std::minstd_rand generator_;
+  std::vector<size_type> examples_;
+
+
+  bool collect_active(
+      std::vector<multi_solver_model<Data>*>& active
+    ) const {
+    active.clear();
+    for (auto& m : models_) {
+      if (m->is_solving()) active.push_back(m.get());
+    }
+    return !active.empty();
+  }
+
+};
+
 }
 
 #endif
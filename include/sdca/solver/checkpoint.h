@@ -0,0 +1,683 @@
+#ifndef SDCA_SOLVER_CHECKPOINT_H
+#define SDCA_SOLVER_CHECKPOINT_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include "sdca/solver/data/input.h"
+#include "sdca/solver/eval/types.h"
+#include "sdca/utility/durable_file.h"
+#include "sdca/utility/types.h"
+
+namespace sdca {
+
+/*
+ * Binary checkpoint format (version 2) in the native byte order:
+ *    checkpoint_header
+ *    checkpoint_entry[num_sections]
+ *    sections, each starting at a multiple of the alignment.
+ * The arrays (e.g. the dual variables) are stored as is, hence can be
+ * memory-mapped directly; with the page alignment, every array also
+ * starts on its own page.
+ * The header (with its checksum set to 0), the entries and every section
+ * are checksummed with the 64-bit FNV-1a hash.
+ */
+static constexpr char checkpoint_magic[8] = {'L', 'I', 'B', 'S', 'D', 'C', 'A',
+                                             'C'};
+static constexpr std::uint32_t checkpoint_version = 2;
+static constexpr std::uint64_t checkpoint_alignment = 64;
+static constexpr std::uint64_t checkpoint_page_alignment = 4096;
+
+
+enum class checkpoint_section : std::uint32_t {
+  state = 1,
+  dual_variables,
+  primal_variables,
+  generator,
+  examples,
+  idle,
+  changes,
+  train_evals,
+  test_evals
+};
+static constexpr std::uint32_t checkpoint_max_sections =
+  static_cast<std::uint32_t>(checkpoint_section::test_evals);
+
+
+struct checkpoint_header {
+  char magic[8];
+  std::uint32_t version;
+  std::uint32_t data_size;
+  std::uint32_t result_size;
+  std::uint32_t num_sections;
+  std::uint64_t alignment;
+  std::uint64_t num_dimensions;
+  std::uint64_t num_examples;
+  std::uint64_t num_classes;
+  std::uint64_t checksum;
+};
+
+
+struct checkpoint_entry {
+  std::uint32_t id;
+  std::uint32_t reserved;
+  std::uint64_t offset;
+  std::uint64_t size;
+  std::uint64_t checksum;
+};
+
+
+inline std::uint64_t
+fnv1a_hash(
+    const void* data,
+    const std::size_t size,
+    std::uint64_t hash = 14695981039346656037ULL
+  ) {
+  const unsigned char* bytes = static_cast<const unsigned char*>(data);
+  for (std::size_t i = 0; i < size; ++i) {
+    hash ^= bytes[i];
+    hash *= 1099511628211ULL;
+  }
+  return hash;
+}
+
+
+// The number of rows of the primal variables (none with kernels)
+template <typename Input>
+inline size_type
+checkpoint_dimensions(const Input& in) { return primal_dimensions(in); }
+
+
+template <typename Data>
+inline size_type
+checkpoint_dimensions(const model_input<Data>& in) {
+  return in.num_dimensions;
+}
+
+
+/**
+ * Appends plain values and vectors to a byte vector
+ * (used for the small sections, e.g. the evaluations).
+ **/
+class checkpoint_ostream {
+public:
+  template <typename Type>
+  void put(const Type& value) {
+    static_assert(std::is_trivially_copyable<Type>::value,
+                  "Only trivially copyable types can be stored.");
+    const char* p = reinterpret_cast<const char*>(&value);
+    bytes_.insert(bytes_.end(), p, p + sizeof(Type));
+  }
+
+
+  // The sizes are stored with 64 bits on all platforms
+  void put_size(const std::uint64_t size) { put(size); }
+
+
+  template <typename Type>
+  void put(const std::vector<Type>& v) {
+    put_size(v.size());
+    for (const auto& x : v) put(x);
+  }
+
+
+  void put(const std::string& s) {
+    put_size(s.size());
+    bytes_.insert(bytes_.end(), s.begin(), s.end());
+  }
+
+
+  const std::vector<char>& bytes() const { return bytes_; }
+
+private:
+  std::vector<char> bytes_;
+};
+
+
+/**
+ * Reads the values written by checkpoint_ostream,
+ * throws std::runtime_error if the data is truncated.
+ **/
+class checkpoint_istream {
+public:
+  explicit checkpoint_istream(
+      const std::vector<char>& __bytes
+    ) :
+      bytes_(__bytes),
+      pos_(0)
+  {}
+
+
+  template <typename Type>
+  void get(Type& value) {
+    static_assert(std::is_trivially_copyable<Type>::value,
+                  "Only trivially copyable types can be loaded.");
+    check(sizeof(Type));
+    std::memcpy(&value, &bytes_[pos_], sizeof(Type));
+    pos_ += sizeof(Type);
+  }
+
+
+  std::uint64_t get_size() {
+    std::uint64_t size;
+    get(size);
+    return size;
+  }
+
+
+  template <typename Type>
+  void get(std::vector<Type>& v) {
+    const std::uint64_t size = get_size();
+    check(size * sizeof(Type));
+    v.resize(size);
+    for (auto& x : v) get(x);
+  }
+
+
+  void get(std::string& s) {
+    const std::size_t size = get_size();
+    check(size);
+    s.assign(&bytes_[0] + pos_, size);
+    pos_ += size;
+  }
+
+private:
+  const std::vector<char>& bytes_;
+  std::size_t pos_;
+
+  void check(const std::uint64_t size) const {
+    if (size > bytes_.size() - pos_) {
+      throw std::runtime_error("Checkpoint section is truncated.");
+    }
+  }
+};
+
+
+template <typename Result>
+inline void
+put_eval_base(
+    checkpoint_ostream& out,
+    const eval_train_base<Result>& e
+  ) {
+  out.put(e.primal);
+  out.put(e.dual);
+  out.put(e.primal_loss);
+  out.put(e.dual_loss);
+  out.put(e.primal_regularizer);
+  out.put(e.dual_regularizer);
+  out.put(e.solve_time_cpu);
+  out.put(e.solve_time_wall);
+  out.put(e.eval_time_cpu);
+  out.put(e.eval_time_wall);
+  out.put_size(e.epoch);
+}
+
+
+template <typename Result>
+inline void
+get_eval_base(
+    checkpoint_istream& in,
+    eval_train_base<Result>& e
+  ) {
+  in.get(e.primal);
+  in.get(e.dual);
+  in.get(e.primal_loss);
+  in.get(e.dual_loss);
+  in.get(e.primal_regularizer);
+  in.get(e.dual_regularizer);
+  in.get(e.solve_time_cpu);
+  in.get(e.solve_time_wall);
+  in.get(e.eval_time_cpu);
+  in.get(e.eval_time_wall);
+  e.epoch = in.get_size();
+}
+
+
+template <typename Result>
+inline void
+put_eval(
+    checkpoint_ostream& out,
+    const eval_train<Result, multiclass_output>& e
+  ) {
+  put_eval_base(out, e);
+  out.put(e.accuracy);
+}
+
+
+template <typename Result>
+inline void
+get_eval(
+    checkpoint_istream& in,
+    eval_train<Result, multiclass_output>& e
+  ) {
+  get_eval_base(in, e);
+  in.get(e.accuracy);
+}
+
+
+template <typename Result>
+inline void
+put_eval(
+    checkpoint_ostream& out,
+    const eval_train<Result, multilabel_output>& e
+  ) {
+  put_eval_base(out, e);
+  out.put(e.rank_loss);
+}
+
+
+template <typename Result>
+inline void
+get_eval(
+    checkpoint_istream& in,
+    eval_train<Result, multilabel_output>& e
+  ) {
+  get_eval_base(in, e);
+  in.get(e.rank_loss);
+}
+
+
+template <typename Result>
+inline void
+put_eval(
+    checkpoint_ostream& out,
+    const eval_test<Result, multiclass_output>& e
+  ) {
+  out.put(e.primal_loss);
+  out.put(e.accuracy);
+}
+
+
+template <typename Result>
+inline void
+get_eval(
+    checkpoint_istream& in,
+    eval_test<Result, multiclass_output>& e
+  ) {
+  in.get(e.primal_loss);
+  in.get(e.accuracy);
+}
+
+
+template <typename Result>
+inline void
+put_eval(
+    checkpoint_ostream& out,
+    const eval_test<Result, multilabel_output>& e
+  ) {
+  out.put(e.primal_loss);
+  out.put(e.rank_loss);
+}
+
+
+template <typename Result>
+inline void
+get_eval(
+    checkpoint_istream& in,
+    eval_test<Result, multilabel_output>& e
+  ) {
+  in.get(e.primal_loss);
+  in.get(e.rank_loss);
+}
+
+
+template <typename Eval>
+inline void
+put_evals(
+    checkpoint_ostream& out,
+    const std::vector<Eval>& evals
+  ) {
+  out.put_size(evals.size());
+  for (const auto& e : evals) put_eval(out, e);
+}
+
+
+template <typename Eval>
+inline void
+get_evals(
+    checkpoint_istream& in,
+    std::vector<Eval>& evals
+  ) {
+  evals.resize(in.get_size());
+  for (auto& e : evals) get_eval(in, e);
+}
+
+
+/**
+ * Lays out a checkpoint in a byte buffer.
+ * The sections only reference their data until serialize() copies them,
+ * so the buffer can be written to disk while the solver continues.
+ **/
+class checkpoint_builder {
+public:
+  explicit checkpoint_builder(
+      const bool is_page_aligned = false
+    ) {
+    std::memset(&header_, 0, sizeof(header_));
+    std::memcpy(header_.magic, checkpoint_magic, sizeof(header_.magic));
+    header_.version = checkpoint_version;
+    header_.alignment = is_page_aligned
+      ? checkpoint_page_alignment : checkpoint_alignment;
+  }
+
+
+  template <typename Data,
+            typename Result>
+  void set_sizes(
+      const size_type num_dimensions,
+      const size_type num_examples,
+      const size_type num_classes
+    ) {
+    header_.data_size = sizeof(Data);
+    header_.result_size = sizeof(Result);
+    header_.num_dimensions = num_dimensions;
+    header_.num_examples = num_examples;
+    header_.num_classes = num_classes;
+  }
+
+
+  void add(
+      const checkpoint_section id,
+      const void* data,
+      const std::size_t size
+    ) {
+    sections_.push_back({id, data, size});
+  }
+
+
+  template <typename Type>
+  void add(
+      const checkpoint_section id,
+      const std::vector<Type>& v
+    ) {
+    add(id, v.data(), v.size() * sizeof(Type));
+  }
+
+
+  void add(
+      const checkpoint_section id,
+      const checkpoint_ostream& out
+    ) {
+    add(id, out.bytes());
+  }
+
+
+  void serialize(
+      std::vector<char>& buffer
+    ) {
+    const std::uint64_t align = header_.alignment;
+    std::vector<checkpoint_entry> entries(sections_.size());
+    std::uint64_t offset = sizeof(checkpoint_header)
+      + entries.size() * sizeof(checkpoint_entry);
+    for (std::size_t s = 0; s < sections_.size(); ++s) {
+      offset = (offset + align - 1) / align * align;
+      entries[s].id = static_cast<std::uint32_t>(sections_[s].id);
+      entries[s].reserved = 0;
+      entries[s].offset = offset;
+      entries[s].size = sections_[s].size;
+      entries[s].checksum = fnv1a_hash(sections_[s].data, sections_[s].size);
+      offset += sections_[s].size;
+    }
+
+    header_.num_sections = static_cast<std::uint32_t>(sections_.size());
+    header_.checksum = 0;
+    std::uint64_t checksum = fnv1a_hash(&header_, sizeof(header_));
+    header_.checksum = fnv1a_hash(entries.data(),
+      entries.size() * sizeof(checkpoint_entry), checksum);
+
+    buffer.assign(offset, 0);
+    std::memcpy(&buffer[0], &header_, sizeof(header_));
+    std::memcpy(&buffer[sizeof(header_)], entries.data(),
+                entries.size() * sizeof(checkpoint_entry));
+    for (std::size_t s = 0; s < sections_.size(); ++s) {
+      if (sections_[s].size > 0) {
+        std::memcpy(&buffer[entries[s].offset],
+                    sections_[s].data, sections_[s].size);
+      }
+    }
+    sections_.clear();
+  }
+
+private:
+  struct section {
+    checkpoint_section id;
+    const void* data;
+    std::size_t size;
+  };
+
+  checkpoint_header header_;
+  std::vector<section> sections_;
+};
+
+
+/**
+ * Writes the checkpoints asynchronously with double buffering:
+ * a new checkpoint is serialized into one buffer while the other one
+ * is still being written, and only then waits for the previous write.
+ * Every file is written to path.tmp first, flushed to the disk and
+ * renamed afterwards (see write_file_durable), so neither a preemption
+ * nor a crash of the machine leaves a partially written checkpoint.
+ **/
+class checkpoint_writer {
+public:
+  checkpoint_writer() :
+      next_(0),
+      is_failed_(false)
+  {}
+
+
+  ~checkpoint_writer() {
+    wait();
+  }
+
+
+  checkpoint_writer(const checkpoint_writer&) = delete;
+  checkpoint_writer& operator=(const checkpoint_writer&) = delete;
+
+
+  // The buffer for the next checkpoint (not being written)
+  std::vector<char>& buffer() { return buffers_[next_]; }
+
+
+  /**
+   * Starts writing the buffer to path,
+   * returns false if the previous write has failed.
+   **/
+  bool write(
+      const std::string& path
+    ) {
+    bool is_ok = wait();
+    std::vector<char>* buffer = &buffers_[next_];
+    thread_ = std::thread([this, buffer, path]() {
+      is_failed_ = !write_file_durable(path, buffer->data(), buffer->size());
+    });
+    next_ = 1 - next_;
+    return is_ok;
+  }
+
+
+  /**
+   * Waits for the pending write to finish,
+   * returns false if it has failed.
+   **/
+  bool wait() {
+    if (thread_.joinable()) {
+      thread_.join();
+    }
+    bool is_ok = !is_failed_;
+    is_failed_ = false;
+    return is_ok;
+  }
+
+
+private:
+  std::vector<char> buffers_[2];
+  std::size_t next_;
+  bool is_failed_;
+  std::thread thread_;
+};
+
+
+/**
+ * Reads and verifies a checkpoint, the sections are then read on demand
+ * directly into their destination.
+ * Throws std::runtime_error if the file is missing, of another version,
+ * or corrupted.
+ **/
+class checkpoint_reader {
+public:
+  explicit checkpoint_reader(
+      const std::string& path
+    ) :
+      file_(path, std::ios::binary)
+  {
+    if (!file_) {
+      throw std::runtime_error("Cannot open checkpoint '" + path + "'.");
+    }
+    if (!file_.read(reinterpret_cast<char*>(&header_), sizeof(header_)) ||
+        std::memcmp(header_.magic, checkpoint_magic, sizeof(header_.magic))) {
+      throw std::runtime_error("Not a checkpoint file '" + path + "'.");
+    }
+    if (header_.version != checkpoint_version) {
+      throw std::runtime_error("Unsupported checkpoint version.");
+    }
+
+    // The number of sections is not checksummed yet, reject a corrupted one
+    // before the entries are allocated
+    file_.seekg(0, std::ios::end);
+    const std::uint64_t file_size = static_cast<std::uint64_t>(file_.tellg());
+    file_.seekg(static_cast<std::streamoff>(sizeof(header_)));
+    if (header_.num_sections > checkpoint_max_sections ||
+        header_.num_sections * sizeof(checkpoint_entry) >
+          file_size - sizeof(header_)) {
+      throw std::runtime_error("Checkpoint header is corrupted.");
+    }
+
+    entries_.resize(header_.num_sections);
+    if (!file_.read(reinterpret_cast<char*>(entries_.data()),
+          static_cast<std::streamsize>(
+            entries_.size() * sizeof(checkpoint_entry)))) {
+      throw std::runtime_error("Checkpoint header is truncated.");
+    }
+
+    checkpoint_header header = header_;
+    header.checksum = 0;
+    std::uint64_t checksum = fnv1a_hash(&header, sizeof(header));
+    checksum = fnv1a_hash(entries_.data(),
+      entries_.size() * sizeof(checkpoint_entry), checksum);
+    if (checksum != header_.checksum) {
+      throw std::runtime_error("Checkpoint header checksum mismatch.");
+    }
+
+    // Verify all sections before anything is restored
+    std::vector<char> chunk(1 << 20);
+    for (const auto& entry : entries_) {
+      file_.seekg(static_cast<std::streamoff>(entry.offset));
+      std::uint64_t hash = fnv1a_hash(nullptr, 0);
+      for (std::uint64_t left = entry.size; left > 0;) {
+        const std::uint64_t chunk_size = chunk.size();
+        const std::size_t size = std::min(left, chunk_size);
+        if (!file_.read(chunk.data(), static_cast<std::streamsize>(size))) {
+          throw std::runtime_error("Checkpoint section is truncated.");
+        }
+        hash = fnv1a_hash(chunk.data(), size, hash);
+        left -= size;
+      }
+      if (hash != entry.checksum) {
+        throw std::runtime_error("Checkpoint section checksum mismatch.");
+      }
+    }
+  }
+
+
+  const checkpoint_header& header() const { return header_; }
+
+
+  // The offsets of the sections, e.g. to memory-map the arrays
+  const std::vector<checkpoint_entry>& entries() const { return entries_; }
+
+
+  template <typename Data,
+            typename Result>
+  void check_sizes(
+      const size_type num_dimensions,
+      const size_type num_examples,
+      const size_type num_classes
+    ) const {
+    if (header_.data_size != sizeof(Data) ||
+        header_.result_size != sizeof(Result) ||
+        header_.num_dimensions != num_dimensions ||
+        header_.num_examples != num_examples ||
+        header_.num_classes != num_classes) {
+      throw std::runtime_error("Checkpoint does not match the problem.");
+    }
+  }
+
+
+  bool has(
+      const checkpoint_section id
+    ) const {
+    return find(id) != nullptr;
+  }
+
+
+  void read(
+      const checkpoint_section id,
+      void* data,
+      const std::size_t size
+    ) {
+    const checkpoint_entry* entry = find(id);
+    if (entry == nullptr || entry->size != size) {
+      throw std::runtime_error("Checkpoint section is missing.");
+    }
+    file_.seekg(static_cast<std::streamoff>(entry->offset));
+    if (size > 0 && !file_.read(static_cast<char*>(data),
+                                static_cast<std::streamsize>(size))) {
+      throw std::runtime_error("Checkpoint section is truncated.");
+    }
+    if (fnv1a_hash(data, size) != entry->checksum) {
+      throw std::runtime_error("Checkpoint section checksum mismatch.");
+    }
+  }
+
+
+  template <typename Type>
+  void read(
+      const checkpoint_section id,
+      std::vector<Type>& v
+    ) {
+    const checkpoint_entry* entry = find(id);
+    if (entry == nullptr) {
+      throw std::runtime_error("Checkpoint section is missing.");
+    }
+    v.resize(entry->size / sizeof(Type));
+    read(id, v.data(), v.size() * sizeof(Type));
+  }
+
+private:
+  std::ifstream file_;
+  checkpoint_header header_;
+  std::vector<checkpoint_entry> entries_;
+
+
+  const checkpoint_entry* find(
+      const checkpoint_section id
+    ) const {
+    for (const auto& entry : entries_) {
+      if (entry.id == static_cast<std::uint32_t>(id)) return &entry;
+    }
+    return nullptr;
+  }
+};
+
+}
+
+#endif
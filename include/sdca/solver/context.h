@@ -31,6 +31,7 @@ struct solver_context {
 
   objective_type objective;
   stopping_criteria criteria;
+  solver_options options;
 
   const data_type* primal_initial = nullptr;
   data_type* primal_variables = nullptr;
@@ -38,6 +39,7 @@ struct solver_context {
 
   solver_status status = solver_status::none;
   size_type epoch = 0;
+  size_type num_updates = 0;
   stopwatch solve_time;
   stopwatch eval_time;
 
@@ -62,6 +64,7 @@ struct solver_context {
     str.copyfmt(std::cout);
     str << objective.to_string() << ", " <<
            "stopping_criteria (" << criteria.to_string() << "), " <<
+           "solver_options (" << options.to_string() << "), " <<
            train.to_string() << ", "
            "is_prox: " << is_prox();
     return str.str();
@@ -80,7 +83,8 @@ struct solver_context {
              ", eval: " << eval_time.cpu.elapsed << ")"
            ", wall_time: " << wall_time() <<
              " (solve: " << solve_time.wall.elapsed <<
-             ", eval: " << eval_time.wall.elapsed << ")";
+             ", eval: " << eval_time.wall.elapsed << ")"
+           ", throughput: " << throughput();
     return str.str();
   }
 
@@ -119,6 +123,13 @@ struct solver_context {
     return solve_time.wall.elapsed_now() + eval_time.wall.elapsed_now();
   }
 
+
+  // The number of examples updated per second of solve (wall) time
+  double throughput() const {
+    return (solve_time.wall.elapsed > 0)
+      ? static_cast<double>(num_updates) / solve_time.wall.elapsed : 0;
+  }
+
 };
 
 
@@ -158,6 +169,41 @@ make_context(
 }
 
 
+template <typename Data,
+          typename Result,
+          typename Output,
+          template <typename, typename> class Objective>
+inline solver_context<Data, Result, packed_kernel_input, Output, Objective>
+make_context(
+    packed_kernel_input<Data>&& in,
+    Output&& out,
+    Objective<Data, Result>&& objective,
+    Data* dual_variables
+  ) {
+  return solver_context<Data, Result, packed_kernel_input, Output, Objective>(
+    make_dataset_train<Result>(std::move(in), std::move(out)),
+    std::move(objective), dual_variables);
+}
+
+
+template <typename Data,
+          typename Result,
+          typename Output,
+          template <typename, typename> class Objective>
+inline solver_context<Data, Result, kernel_function_input, Output, Objective>
+make_context(
+    kernel_function_input<Data>&& in,
+    Output&& out,
+    Objective<Data, Result>&& objective,
+    Data* dual_variables
+  ) {
+  return solver_context<Data, Result, kernel_function_input, Output,
+                        Objective>(
+    make_dataset_train<Result>(std::move(in), std::move(out)),
+    std::move(objective), dual_variables);
+}
+
+
 template <typename Data,
           typename Result,
           typename Output,
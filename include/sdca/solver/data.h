@@ -1,6 +1,7 @@
 #ifndef SDCA_SOLVER_DATA_H
 #define SDCA_SOLVER_DATA_H
 
+#include <memory>
 #include <numeric>
 
 #include "sdca/solver/data/dataset.h"
@@ -18,6 +19,51 @@ template <typename Data>
 struct need_shuffle<model_input<Data>> : std::false_type {};
 
 
+template <typename Input>
+struct is_async_update_supported : std::false_type {};
+
+template <typename Data>
+struct is_async_update_supported<feature_input<Data>> : std::true_type {};
+
+template <typename Data>
+struct is_async_update_supported<sparse_feature_input<Data>>
+    : std::true_type {};
+
+template <typename Data>
+struct is_async_update_supported<quantized_feature_input<Data>>
+    : std::true_type {};
+
+template <typename Data>
+struct is_async_update_supported<fourier_feature_input<Data>>
+    : std::true_type {};
+
+template <typename Data>
+struct is_async_update_supported<kernel_input<Data>> : std::true_type {};
+
+template <typename Data>
+struct is_async_update_supported<packed_kernel_input<Data>>
+    : std::true_type {};
+
+template <typename Data>
+struct is_async_update_supported<kernel_function_input<Data>>
+    : std::true_type {};
+
+
+template <typename Input>
+struct is_acceleration_supported : std::false_type {};
+
+template <typename Data>
+struct is_acceleration_supported<feature_input<Data>> : std::true_type {};
+
+template <typename Data>
+struct is_acceleration_supported<sparse_feature_input<Data>>
+    : std::true_type {};
+
+template <typename Data>
+struct is_acceleration_supported<quantized_feature_input<Data>>
+    : std::true_type {};
+
+
 template <typename Result = double,
           typename Data,
           template <typename> class Input,
@@ -57,6 +103,52 @@ make_input_feature(
 }
 
 
+// The compressed sparse column format, see sparse_feature_input
+template <typename Data>
+inline sparse_feature_input<Data>
+make_input_sparse_feature(
+    const size_type num_dimensions,
+    const size_type num_examples,
+    const Data* values,
+    const size_type* indices,
+    const size_type* offsets
+  ) {
+  return sparse_feature_input<Data>(num_dimensions, num_examples,
+    values, indices, offsets);
+}
+
+
+// Quantized features (see quantized_feature_input), either scale may be
+// nullptr; e.g. from a quantized_features object
+template <typename Data>
+inline quantized_feature_input<Data>
+make_input_quantized_feature(
+    const size_type num_dimensions,
+    const size_type num_examples,
+    const quantization_type type,
+    const void* values,
+    const Data* example_scales = nullptr,
+    const Data* feature_scales = nullptr
+  ) {
+  return quantized_feature_input<Data>(num_dimensions, num_examples, type,
+    values, example_scales, feature_scales);
+}
+
+
+// The random Fourier features of the raw features (see fourier_feature_input),
+// e.g. of the training and the test examples with the same transform
+template <typename Data,
+          typename Transform>
+inline fourier_feature_input<Data>
+make_input_fourier_feature(
+    const size_type num_examples,
+    const Data* features,
+    const std::shared_ptr<Transform>& transform
+  ) {
+  return fourier_feature_input<Data>(num_examples, features, transform);
+}
+
+
 template <typename Data>
 inline kernel_input<Data>
 make_input_kernel(
@@ -78,6 +170,67 @@ make_input_kernel(
 }
 
 
+// The training kernel in the packed lower triangular format
+// (sdca_packed_size(num_examples) elements, see sdca_pack_lower)
+template <typename Data>
+inline packed_kernel_input<Data>
+make_input_kernel_packed(
+    const size_type num_examples,
+    const Data* kernel
+  ) {
+  return packed_kernel_input<Data>(num_examples, num_examples, kernel, true);
+}
+
+
+// The (full) kernel of the new examples, e.g. a test set
+template <typename Data>
+inline packed_kernel_input<Data>
+make_input_kernel_packed(
+    const size_type num_train_examples,
+    const size_type num_examples,
+    const Data* kernel
+  ) {
+  return packed_kernel_input<Data>(num_train_examples, num_examples, kernel,
+                                   false);
+}
+
+
+// The training kernel k(X, X) computed on demand with a cache of cache_size
+// bytes, i.e. the features X must outlive the input and its copies
+template <typename Data>
+inline kernel_function_input<Data>
+make_input_kernel_function(
+    const size_type num_dimensions,
+    const size_type num_examples,
+    const Data* features,
+    const kernel_function<Data>& kernel,
+    const size_type cache_size
+  ) {
+  return kernel_function_input<Data>(num_dimensions, num_examples,
+    num_examples, features, std::make_shared<kernel_cache<Data>>(
+      num_dimensions, num_examples, features, kernel, cache_size));
+}
+
+
+// The kernel k(X_train, X) of the new examples X (e.g. a test set),
+// with its own cache of cache_size bytes
+template <typename Data>
+inline kernel_function_input<Data>
+make_input_kernel_function(
+    const kernel_function_input<Data>& train,
+    const size_type num_examples,
+    const Data* features,
+    const size_type cache_size
+  ) {
+  const kernel_cache<Data>& cache = *train.cache;
+  return kernel_function_input<Data>(train.num_dimensions,
+    train.num_train_examples, num_examples, features,
+    std::make_shared<kernel_cache<Data>>(cache.num_dimensions(),
+      cache.num_train_examples(), cache.train_features(), cache.kernel(),
+      cache_size));
+}
+
+
 template <typename Data>
 inline model_input<Data>
 make_input_model(
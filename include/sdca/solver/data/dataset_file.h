@@ -0,0 +1,477 @@
+#ifndef SDCA_SOLVER_DATA_DATASET_FILE_H
+#define SDCA_SOLVER_DATA_DATASET_FILE_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "sdca/solver/data/input.h"
+#include "sdca/solver/data/output.h"
+#include "sdca/utility/mapped_file.h"
+#include "sdca/utility/types.h"
+
+namespace sdca {
+
+/*
+ * Binary dataset format (version 1) in the native byte order:
+ *    dataset_file_header
+ *    the matrix (features or kernel) in column-major order,
+ *      num_rows-by-num_examples, starting at a page boundary,
+ *    the labels (uint64, 0-based, 8-byte aligned),
+ *    the label offsets (uint64, num_examples + 1, multilabel only).
+ * The file is memory-mapped by dataset_file and the inputs point directly
+ * into the mapping, so nothing is parsed or copied except the labels.
+ */
+static constexpr char dataset_file_magic[8] = {'L', 'I', 'B', 'S', 'D', 'C',
+                                               'A', 'D'};
+static constexpr std::uint32_t dataset_file_version = 1;
+static constexpr std::uint64_t dataset_file_alignment = 4096;
+
+
+enum class dataset_file_input : std::uint32_t {
+  features = 1,
+  kernel
+};
+
+
+enum class dataset_file_output : std::uint32_t {
+  multiclass = 1,
+  multilabel
+};
+
+
+struct dataset_file_header {
+  char magic[8];
+  std::uint32_t version;
+  std::uint32_t input;
+  std::uint32_t output;
+  std::uint32_t data_size;
+  std::uint64_t num_rows;
+  std::uint64_t num_examples;
+  std::uint64_t num_classes;
+  std::uint64_t num_labels;
+  std::uint64_t data_offset;
+  std::uint64_t labels_offset;
+  std::uint64_t offsets_offset;
+};
+
+
+template <typename Data>
+inline void
+write_dataset_file(
+    const std::string& path,
+    const dataset_file_input input,
+    const size_type num_rows,
+    const size_type num_examples,
+    const Data* data,
+    const dataset_file_output output,
+    const size_type num_classes,
+    const std::vector<size_type>& labels,
+    const std::vector<size_type>& offsets
+  ) {
+  dataset_file_header header;
+  std::memset(&header, 0, sizeof(header));
+  std::memcpy(header.magic, dataset_file_magic, sizeof(header.magic));
+  header.version = dataset_file_version;
+  header.input = static_cast<std::uint32_t>(input);
+  header.output = static_cast<std::uint32_t>(output);
+  header.data_size = sizeof(Data);
+  header.num_rows = num_rows;
+  header.num_examples = num_examples;
+  header.num_classes = num_classes;
+  header.num_labels = labels.size();
+
+  const std::uint64_t data_bytes = num_rows * num_examples * sizeof(Data);
+  const std::uint64_t data_padding = (8 - data_bytes % 8) % 8;
+  header.data_offset = dataset_file_alignment;
+  header.labels_offset = header.data_offset + data_bytes + data_padding;
+  header.offsets_offset = header.labels_offset +
+    labels.size() * sizeof(std::uint64_t);
+
+  std::ofstream file(path, std::ios::binary | std::ios::trunc);
+  std::vector<char> padding(dataset_file_alignment - sizeof(header));
+  file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  file.write(padding.data(), static_cast<std::streamsize>(padding.size()));
+  file.write(reinterpret_cast<const char*>(data),
+             static_cast<std::streamsize>(data_bytes));
+  file.write(padding.data(), static_cast<std::streamsize>(data_padding));
+
+  std::vector<std::uint64_t> buffer(labels.begin(), labels.end());
+  file.write(reinterpret_cast<const char*>(buffer.data()),
+             static_cast<std::streamsize>(buffer.size() * sizeof(buffer[0])));
+  buffer.assign(offsets.begin(), offsets.end());
+  file.write(reinterpret_cast<const char*>(buffer.data()),
+             static_cast<std::streamsize>(buffer.size() * sizeof(buffer[0])));
+  if (!file) {
+    throw std::runtime_error("Cannot write dataset file '" + path + "'.");
+  }
+}
+
+
+template <typename Data>
+inline void
+write_dataset_file(
+    const std::string& path,
+    const feature_input<Data>& in,
+    const multiclass_output& out
+  ) {
+  write_dataset_file(path, dataset_file_input::features, in.num_dimensions,
+    in.num_examples, in.features, dataset_file_output::multiclass,
+    out.num_classes, out.labels, std::vector<size_type>());
+}
+
+
+template <typename Data>
+inline void
+write_dataset_file(
+    const std::string& path,
+    const feature_input<Data>& in,
+    const multilabel_output& out
+  ) {
+  write_dataset_file(path, dataset_file_input::features, in.num_dimensions,
+    in.num_examples, in.features, dataset_file_output::multilabel,
+    out.num_classes, out.labels, out.offsets);
+}
+
+
+template <typename Data>
+inline void
+write_dataset_file(
+    const std::string& path,
+    const kernel_input<Data>& in,
+    const multiclass_output& out
+  ) {
+  write_dataset_file(path, dataset_file_input::kernel, in.num_train_examples,
+    in.num_examples, in.kernel, dataset_file_output::multiclass,
+    out.num_classes, out.labels, std::vector<size_type>());
+}
+
+
+template <typename Data>
+inline void
+write_dataset_file(
+    const std::string& path,
+    const kernel_input<Data>& in,
+    const multilabel_output& out
+  ) {
+  write_dataset_file(path, dataset_file_input::kernel, in.num_train_examples,
+    in.num_examples, in.kernel, dataset_file_output::multilabel,
+    out.num_classes, out.labels, out.offsets);
+}
+
+
+/**
+ * A memory-mapped dataset file (see write_dataset_file).
+ * The inputs returned by features() and kernel() point into the mapping,
+ * hence the dataset_file must outlive the solver that uses them.
+ * Throws std::runtime_error if the file is invalid, and
+ * std::invalid_argument if the requested input, output or precision
+ * does not match the file.
+ **/
+class dataset_file {
+public:
+  explicit dataset_file(
+      const std::string& path
+    ) :
+      file_(path)
+  {
+    if (file_.size() < sizeof(header_)) {
+      throw std::runtime_error("Not a dataset file '" + path + "'.");
+    }
+    std::memcpy(&header_, file_.data(), sizeof(header_));
+    if (std::memcmp(header_.magic, dataset_file_magic,
+                    sizeof(header_.magic))) {
+      throw std::runtime_error("Not a dataset file '" + path + "'.");
+    }
+    if (header_.version != dataset_file_version) {
+      throw std::runtime_error("Unsupported dataset file version.");
+    }
+
+    // The sizes are checked for overflow before they are compared
+    const std::uint64_t num_offsets = is_multilabel()
+      ? header_.num_examples + 1 : 0;
+    std::uint64_t data_bytes, labels_bytes, offsets_bytes;
+    if (!multiply(header_.num_rows, header_.num_examples, data_bytes) ||
+        !multiply(data_bytes, header_.data_size, data_bytes) ||
+        !multiply(header_.num_labels, sizeof(std::uint64_t), labels_bytes) ||
+        !multiply(num_offsets, sizeof(std::uint64_t), offsets_bytes) ||
+        header_.data_offset % dataset_file_alignment != 0 ||
+        header_.labels_offset % sizeof(std::uint64_t) != 0 ||
+        header_.labels_offset < header_.data_offset ||
+        header_.labels_offset - header_.data_offset < data_bytes ||
+        header_.offsets_offset < header_.labels_offset ||
+        header_.offsets_offset - header_.labels_offset != labels_bytes ||
+        header_.offsets_offset > file_.size() ||
+        file_.size() - header_.offsets_offset < offsets_bytes) {
+      throw std::runtime_error("Dataset file is truncated.");
+    }
+    if (!is_multilabel() && header_.num_labels != header_.num_examples) {
+      throw std::runtime_error("Dataset file has invalid labels.");
+    }
+    if (std::any_of(labels_begin(), labels_begin() + header_.num_labels,
+          [this](const std::uint64_t y) { return y >= header_.num_classes; })) {
+      throw std::runtime_error("Dataset file has invalid labels.");
+    }
+  }
+
+
+  const dataset_file_header& header() const { return header_; }
+
+  size_type num_examples() const { return header_.num_examples; }
+
+  bool is_kernel() const {
+    return header_.input == static_cast<std::uint32_t>(
+      dataset_file_input::kernel);
+  }
+
+  bool is_multilabel() const {
+    return header_.output == static_cast<std::uint32_t>(
+      dataset_file_output::multilabel);
+  }
+
+
+  template <typename Data>
+  feature_input<Data> features() const {
+    check_input<Data>(dataset_file_input::features);
+    return feature_input<Data>(header_.num_rows, header_.num_examples,
+                               matrix<Data>());
+  }
+
+
+  template <typename Data>
+  kernel_input<Data> kernel() const {
+    check_input<Data>(dataset_file_input::kernel);
+    return kernel_input<Data>(header_.num_rows, header_.num_examples,
+                              matrix<Data>());
+  }
+
+
+  multiclass_output multiclass() const {
+    if (is_multilabel()) {
+      throw std::invalid_argument("Dataset file has multilabel labels.");
+    }
+    std::vector<size_type> labels(labels_begin(),
+                                  labels_begin() + header_.num_labels);
+    return multiclass_output(header_.num_classes, labels);
+  }
+
+
+  multilabel_output multilabel() const {
+    std::vector<size_type> labels(labels_begin(),
+                                  labels_begin() + header_.num_labels);
+    std::vector<size_type> offsets;
+    if (is_multilabel()) {
+      const std::uint64_t* first = reinterpret_cast<const std::uint64_t*>(
+        file_.data() + header_.offsets_offset);
+      offsets.assign(first, first + header_.num_examples + 1);
+    } else {
+      // One label per example
+      offsets.resize(header_.num_examples + 1);
+      std::iota(offsets.begin(), offsets.end(), 0);
+    }
+    validate_labels_and_offsets(header_.num_classes, labels, offsets);
+    return multilabel_output(header_.num_classes, labels, offsets);
+  }
+
+
+  /**
+   * Hints the access pattern of the matrix, e.g. random if the solver
+   * shuffles the examples and sequential for the evaluation only sets.
+   **/
+  void advise(
+      const access_pattern pattern
+    ) const {
+    file_.advise(pattern, header_.data_offset,
+                 header_.labels_offset - header_.data_offset);
+  }
+
+private:
+  mapped_file file_;
+  dataset_file_header header_;
+
+
+  template <typename Data>
+  void check_input(
+      const dataset_file_input input
+    ) const {
+    if (header_.input != static_cast<std::uint32_t>(input)) {
+      throw std::invalid_argument("Dataset file has another input type.");
+    }
+    if (header_.data_size != sizeof(Data)) {
+      throw std::invalid_argument("Dataset file has another precision.");
+    }
+  }
+
+
+  template <typename Data>
+  const Data* matrix() const {
+    return reinterpret_cast<const Data*>(file_.data() + header_.data_offset);
+  }
+
+
+  // Lets c = a * b, returns false if it overflows
+  static bool multiply(
+      const std::uint64_t a,
+      const std::uint64_t b,
+      std::uint64_t& c
+    ) {
+    if (a != 0 && b > std::numeric_limits<std::uint64_t>::max() / a) {
+      return false;
+    }
+    c = a * b;
+    return true;
+  }
+
+
+  const std::uint64_t* labels_begin() const {
+    return reinterpret_cast<const std::uint64_t*>(
+      file_.data() + header_.labels_offset);
+  }
+};
+
+
+/**
+ * Reads the features of a dataset file in chunks of chunk_size examples
+ * with a background thread, i.e. without mapping or loading the whole file.
+ * There are two buffers: while the solver works on the chunk returned by
+ * wait(), the chunk requested by the next read() is loaded into the other
+ * buffer, hence at most two chunks are resident at a time.
+ * Throws std::runtime_error if the file is invalid or cannot be read, and
+ * std::invalid_argument if it does not store features of the precision Data.
+ **/
+template <typename Data>
+class dataset_chunk_reader {
+public:
+  dataset_chunk_reader(
+      const std::string& path,
+      const size_type chunk_size
+    ) :
+      path_(path),
+      fd_(-1),
+      next_(0),
+      chunk_(0),
+      is_failed_(false)
+  {
+    {
+      // Validates the header, the labels are not needed here
+      dataset_file file(path);
+      file.features<Data>();
+      header_ = file.header();
+    }
+    chunk_size_ = std::max(static_cast<size_type>(1),
+                           std::min(chunk_size, num_examples()));
+    fd_ = ::open(path.c_str(), O_RDONLY);
+    if (fd_ < 0) {
+      throw std::runtime_error("Cannot open file '" + path + "'.");
+    }
+    buffers_[0].resize(header_.num_rows * chunk_size_);
+    buffers_[1].resize(header_.num_rows * chunk_size_);
+  }
+
+
+  ~dataset_chunk_reader() {
+    if (thread_.joinable()) thread_.join();
+    if (fd_ >= 0) ::close(fd_);
+  }
+
+
+  dataset_chunk_reader(const dataset_chunk_reader&) = delete;
+  dataset_chunk_reader& operator=(const dataset_chunk_reader&) = delete;
+
+
+  size_type num_dimensions() const { return header_.num_rows; }
+
+  size_type num_examples() const { return header_.num_examples; }
+
+  size_type chunk_size() const { return chunk_size_; }
+
+  size_type num_chunks() const {
+    return (num_examples() + chunk_size_ - 1) / chunk_size_;
+  }
+
+  size_type chunk_begin(const size_type c) const { return c * chunk_size_; }
+
+  size_type chunk_end(const size_type c) const {
+    return std::min((c + 1) * chunk_size_, num_examples());
+  }
+
+
+  /**
+   * Starts reading the chunk c into the free buffer in the background.
+   * Every read() must be followed by a wait() before the next read().
+   **/
+  void read(
+      const size_type c
+    ) {
+    if (thread_.joinable()) thread_.join();
+    chunk_ = c;
+    const size_type dim = num_dimensions();
+    thread_ = std::thread([this, dim, c]() {
+      const std::uint64_t offset = header_.data_offset +
+        chunk_begin(c) * dim * sizeof(Data);
+      is_failed_ = !read_bytes(offset, (chunk_end(c) - chunk_begin(c)) *
+        dim * sizeof(Data), reinterpret_cast<char*>(buffers_[next_].data()));
+    });
+  }
+
+
+  /**
+   * Waits for the last read() and returns the features of its chunk,
+   * which stay valid until the next but one read().
+   **/
+  const Data* wait() {
+    if (thread_.joinable()) thread_.join();
+    if (is_failed_) {
+      throw std::runtime_error("Cannot read chunk " + std::to_string(chunk_) +
+                               " of dataset file '" + path_ + "'.");
+    }
+    const Data* features = buffers_[next_].data();
+    next_ = 1 - next_;
+    return features;
+  }
+
+private:
+  std::string path_;
+  dataset_file_header header_;
+  int fd_;
+  size_type chunk_size_;
+  std::vector<Data> buffers_[2];
+  size_type next_;
+  size_type chunk_;
+  bool is_failed_;
+  std::thread thread_;
+
+
+  bool read_bytes(
+      std::uint64_t offset,
+      size_type size,
+      char* data
+    ) const {
+    while (size > 0) {
+      const ssize_t count = ::pread(fd_, data, size,
+                                    static_cast<off_t>(offset));
+      if (count < 0 && errno == EINTR) continue;
+      if (count <= 0) return false;
+      const size_type bytes = static_cast<size_type>(count);
+      offset += bytes;
+      size -= bytes;
+      data += bytes;
+    }
+    return true;
+  }
+};
+
+}
+
+#endif
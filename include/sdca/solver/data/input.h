@@ -1,8 +1,16 @@
 #ifndef SDCA_SOLVER_DATA_INPUT_H
 #define SDCA_SOLVER_DATA_INPUT_H
 
+#include <cstdint>
+#include <memory>
 #include <sstream>
+#include <type_traits>
+#include <vector>
 
+#include "sdca/math/packed.h"
+#include "sdca/math/quantized.h"
+#include "sdca/solver/data/kernel_cache.h"
+#include "sdca/solver/data/random_features.h"
 #include "sdca/utility/types.h"
 
 namespace sdca {
@@ -29,6 +37,17 @@ struct feature_input {
   {}
 
 
+  // Returns X(:, first:last); the features are stored, buffer is not used
+  inline const data_type*
+  features_block(
+      const size_type first,
+      const size_type,
+      std::vector<data_type>&
+    ) const {
+    return features + num_dimensions * first;
+  }
+
+
   inline std::string
   to_string() const {
     std::ostringstream str;
@@ -41,6 +60,260 @@ struct feature_input {
 };
 
 
+template <typename Data>
+struct sparse_feature_input {
+  typedef Data data_type;
+
+  // The feature matrix is num_dimensions-by-num_examples in the compressed
+  // sparse column format (as in Matlab), i.e. the example i has the values
+  //    values[offsets[i]], ..., values[offsets[i+1] - 1]
+  // in the dimensions given by the same range of indices
+  // (offsets has num_examples + 1 elements, offsets[0] = 0)
+  size_type num_dimensions = 0;
+  size_type num_examples = 0;
+  const data_type* values = nullptr;
+  const size_type* indices = nullptr;
+  const size_type* offsets = nullptr;
+
+
+  sparse_feature_input(
+      const size_type __num_dimensions,
+      const size_type __num_examples,
+      const data_type* __values,
+      const size_type* __indices,
+      const size_type* __offsets
+    ) :
+      num_dimensions(__num_dimensions),
+      num_examples(__num_examples),
+      values(__values),
+      indices(__indices),
+      offsets(__offsets)
+  {}
+
+
+  inline size_type num_nonzeros() const { return offsets[num_examples]; }
+
+
+  inline std::string
+  to_string() const {
+    std::ostringstream str;
+    str << "sparse features (num_dimensions: " << num_dimensions <<
+           ", num_examples: " << num_examples <<
+           ", num_nonzeros: " << num_nonzeros() <<
+           ", precision: " << type_name<Data>() << ")";
+    return str.str();
+  }
+
+};
+
+
+template <typename Data>
+struct fourier_feature_input {
+  typedef Data data_type;
+
+  // The model is linear in the num_dimensions random Fourier features z(x)
+  // of the raw features, which are num_input_dimensions-by-num_examples
+  // in column-major order. The features z(x) are generated on the fly
+  // and never stored (see random_fourier_features).
+  size_type num_dimensions = 0;
+  size_type num_input_dimensions = 0;
+  size_type num_examples = 0;
+  const data_type* features = nullptr;
+  std::shared_ptr<const random_fourier_features<Data>> transform;
+
+
+  fourier_feature_input(
+      const size_type __num_examples,
+      const data_type* __features,
+      std::shared_ptr<const random_fourier_features<Data>> __transform
+    ) :
+      num_dimensions(__transform->num_dimensions()),
+      num_input_dimensions(__transform->num_input_dimensions()),
+      num_examples(__num_examples),
+      features(__features),
+      transform(std::move(__transform))
+  {}
+
+
+  // Let Z = z(X(:, first:last)), num_dimensions-by-(last - first)
+  inline void
+  transform_block(
+      const size_type first,
+      const size_type last,
+      data_type* Z
+    ) const {
+    transform->transform(last - first,
+      features + num_input_dimensions * first, Z);
+  }
+
+
+  // Returns Z = z(X(:, first:last)), which is generated into buffer
+  inline const data_type*
+  features_block(
+      const size_type first,
+      const size_type last,
+      std::vector<data_type>& buffer
+    ) const {
+    buffer.resize(num_dimensions * (last - first));
+    transform_block(first, last, &buffer[0]);
+    return &buffer[0];
+  }
+
+
+  inline std::string
+  to_string() const {
+    std::ostringstream str;
+    str << "fourier features (num_examples: " << num_examples <<
+           ", precision: " << type_name<Data>() << "), " <<
+           transform->to_string();
+    return str.str();
+  }
+
+};
+
+
+enum class quantization_type {
+  int8 = 0,
+  fp16,
+  bf16
+};
+
+
+inline const char*
+quantization_type_name(
+    const quantization_type type
+  ) {
+  switch (type) {
+    case quantization_type::int8:
+      return "int8";
+    case quantization_type::fp16:
+      return "fp16";
+    case quantization_type::bf16:
+      return "bf16";
+  }
+  return "unknown";
+}
+
+
+template <typename Data>
+struct quantized_feature_input {
+  typedef Data data_type;
+
+  // The feature matrix is num_dimensions-by-num_examples in column-major
+  // order, stored as int8, fp16 or bf16 (see math/quantized.h) and
+  // dequantized on the fly as
+  //    x_i = example_scales[i] * (feature_scales .* q_i),
+  // where either scale may be nullptr (i.e. 1).
+  size_type num_dimensions = 0;
+  size_type num_examples = 0;
+  quantization_type type = quantization_type::int8;
+  const void* values = nullptr;
+  const data_type* example_scales = nullptr;
+  const data_type* feature_scales = nullptr;
+
+
+  quantized_feature_input(
+      const size_type __num_dimensions,
+      const size_type __num_examples,
+      const quantization_type __type,
+      const void* __values,
+      const data_type* __example_scales,
+      const data_type* __feature_scales
+    ) :
+      num_dimensions(__num_dimensions),
+      num_examples(__num_examples),
+      type(__type),
+      values(__values),
+      example_scales(__example_scales),
+      feature_scales(__feature_scales)
+  {}
+
+
+  inline data_type
+  example_scale(const size_type i) const {
+    return (example_scales != nullptr) ? example_scales[i]
+                                       : static_cast<data_type>(1);
+  }
+
+
+  // Let X = [x_first, ..., x_{last-1}], num_dimensions-by-(last - first)
+  inline void
+  dequantize(
+      const size_type first,
+      const size_type last,
+      data_type* X
+    ) const {
+    for (size_type i = first; i < last; ++i, X += num_dimensions) {
+      const size_type offset = num_dimensions * i;
+      switch (type) {
+        case quantization_type::int8:
+          sdca_quantized_copy(num_dimensions, example_scale(i),
+            static_cast<const std::int8_t*>(values) + offset,
+            feature_scales, X);
+          break;
+        case quantization_type::fp16:
+          sdca_quantized_copy(num_dimensions, example_scale(i),
+            static_cast<const sdca_half*>(values) + offset,
+            feature_scales, X);
+          break;
+        case quantization_type::bf16:
+          sdca_quantized_copy(num_dimensions, example_scale(i),
+            static_cast<const sdca_bfloat16*>(values) + offset,
+            feature_scales, X);
+          break;
+      }
+    }
+  }
+
+
+  // Returns X = [x_first, ..., x_{last-1}], which is dequantized into buffer
+  inline const data_type*
+  features_block(
+      const size_type first,
+      const size_type last,
+      std::vector<data_type>& buffer
+    ) const {
+    buffer.resize(num_dimensions * (last - first));
+    dequantize(first, last, &buffer[0]);
+    return &buffer[0];
+  }
+
+
+  // Returns ||x_i||^2
+  inline data_type
+  norm2(
+      const size_type i
+    ) const {
+    const size_type offset = num_dimensions * i;
+    const data_type scale = example_scale(i);
+    switch (type) {
+      case quantization_type::int8:
+        return scale * scale * sdca_quantized_norm2(num_dimensions,
+          static_cast<const std::int8_t*>(values) + offset, feature_scales);
+      case quantization_type::fp16:
+        return scale * scale * sdca_quantized_norm2(num_dimensions,
+          static_cast<const sdca_half*>(values) + offset, feature_scales);
+      case quantization_type::bf16:
+        return scale * scale * sdca_quantized_norm2(num_dimensions,
+          static_cast<const sdca_bfloat16*>(values) + offset, feature_scales);
+    }
+    return 0;
+  }
+
+
+  inline std::string
+  to_string() const {
+    std::ostringstream str;
+    str << "quantized features (num_dimensions: " << num_dimensions <<
+           ", num_examples: " << num_examples <<
+           ", storage: " << quantization_type_name(type) <<
+           ", precision: " << type_name<Data>() << ")";
+    return str.str();
+  }
+
+};
+
+
 template <typename Data>
 struct kernel_input {
   typedef Data data_type;
@@ -63,11 +336,65 @@ struct kernel_input {
   {}
 
 
+  inline data_type
+  diagonal(const size_type i) const {
+    return kernel[num_train_examples * i + i];
+  }
+
+
+  inline std::string
+  to_string() const {
+    std::ostringstream str;
+    str << "kernel (num_train_examples: " << num_train_examples <<
+           ", num_examples: " << num_examples <<
+           ", precision: " << type_name<Data>() << ")";
+    return str.str();
+  }
+
+};
+
+
+template <typename Data>
+struct packed_kernel_input {
+  typedef Data data_type;
+
+  // The training kernel matrix is symmetric, only its lower triangle is
+  // stored in the blocked packed format (see sdca/math/packed.h), i.e.
+  // sdca_packed_size(num_examples) elements.
+  // The kernel of other examples (e.g. a test set) is not symmetric and
+  // is stored num_train_examples-by-num_examples as in kernel_input.
+  size_type num_train_examples = 0;
+  size_type num_examples = 0;
+  const data_type* kernel = nullptr;
+  bool is_packed = false;
+
+
+  packed_kernel_input(
+      const size_type __num_train_examples,
+      const size_type __num_examples,
+      const data_type* __kernel,
+      const bool __is_packed
+    ) :
+      num_train_examples(__num_train_examples),
+      num_examples(__num_examples),
+      kernel(__kernel),
+      is_packed(__is_packed)
+  {}
+
+
+  inline data_type
+  diagonal(const size_type i) const {
+    return is_packed ? kernel[sdca_packed_offset(num_train_examples, i)]
+                     : kernel[num_train_examples * i + i];
+  }
+
+
   inline std::string
   to_string() const {
     std::ostringstream str;
     str << "kernel (num_train_examples: " << num_train_examples <<
            ", num_examples: " << num_examples <<
+           ", packed: " << is_packed <<
            ", precision: " << type_name<Data>() << ")";
     return str.str();
   }
@@ -75,6 +402,63 @@ struct kernel_input {
 };
 
 
+template <typename Data>
+struct kernel_function_input {
+  typedef Data data_type;
+
+  // The kernel matrix K(:, i) = k(X_train, x_i) is never materialized,
+  // its columns are computed from the features on demand and cached
+  // (see kernel_cache). The features of the examples must be
+  // num_dimensions-by-num_examples in column-major order; the cache knows
+  // the training features and is shared by the copies of the input.
+  size_type num_dimensions = 0;
+  size_type num_train_examples = 0;
+  size_type num_examples = 0;
+  const data_type* features = nullptr;
+  std::shared_ptr<kernel_cache<Data>> cache;
+
+
+  kernel_function_input(
+      const size_type __num_dimensions,
+      const size_type __num_train_examples,
+      const size_type __num_examples,
+      const data_type* __features,
+      std::shared_ptr<kernel_cache<Data>> __cache
+    ) :
+      num_dimensions(__num_dimensions),
+      num_train_examples(__num_train_examples),
+      num_examples(__num_examples),
+      features(__features),
+      cache(std::move(__cache))
+  {}
+
+
+  inline typename kernel_cache<Data>::column_type
+  column(const size_type i) const {
+    return cache->column(i, features + num_dimensions * i);
+  }
+
+
+  inline data_type
+  diagonal(const size_type i) const {
+    return cache->diagonal(features + num_dimensions * i);
+  }
+
+
+  inline std::string
+  to_string() const {
+    std::ostringstream str;
+    str << "kernel function (num_dimensions: " << num_dimensions <<
+           ", num_train_examples: " << num_train_examples <<
+           ", num_examples: " << num_examples <<
+           ", precision: " << type_name<Data>() << "), " <<
+           cache->kernel().to_string() << ", " << cache->to_string();
+    return str.str();
+  }
+
+};
+
+
 template <typename Data>
 struct model_input {
   typedef Data data_type;
@@ -113,6 +497,48 @@ struct model_input {
 
 };
 
+
+/**
+ * The inputs of the linear models, where the solver maintains the primal
+ * variables W (num_dimensions-by-num_classes) along with the dual ones.
+ **/
+template <typename Input>
+struct is_primal_input : std::false_type {};
+
+template <typename Data>
+struct is_primal_input<feature_input<Data>> : std::true_type {};
+
+template <typename Data>
+struct is_primal_input<sparse_feature_input<Data>> : std::true_type {};
+
+template <typename Data>
+struct is_primal_input<quantized_feature_input<Data>> : std::true_type {};
+
+template <typename Data>
+struct is_primal_input<fourier_feature_input<Data>> : std::true_type {};
+
+
+template <typename Input>
+inline size_type
+primal_dimensions(const Input& in, std::true_type) {
+  return in.num_dimensions;
+}
+
+
+template <typename Input>
+inline size_type
+primal_dimensions(const Input&, std::false_type) {
+  return 0;
+}
+
+
+// The number of rows of the primal variables (none with kernels)
+template <typename Input>
+inline size_type
+primal_dimensions(const Input& in) {
+  return primal_dimensions(in, is_primal_input<Input>());
+}
+
 }
 
 #endif
@@ -0,0 +1,363 @@
+#ifndef SDCA_SOLVER_DATA_KERNEL_CACHE_H
+#define SDCA_SOLVER_DATA_KERNEL_CACHE_H
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "sdca/math/blas.h"
+#include "sdca/utility/types.h"
+
+namespace sdca {
+
+enum class kernel_type {
+  linear = 0,
+  rbf,
+  polynomial,
+  chi_squared
+};
+
+
+inline const char*
+kernel_type_name(
+    const kernel_type type
+  ) {
+  switch (type) {
+    case kernel_type::linear:
+      return "linear";
+    case kernel_type::rbf:
+      return "rbf";
+    case kernel_type::polynomial:
+      return "polynomial";
+    case kernel_type::chi_squared:
+      return "chi_squared";
+  }
+  return "unknown";
+}
+
+
+/**
+ * A kernel function k(x, y) of two feature vectors:
+ *    linear:       x' y,
+ *    rbf:          exp(-gamma ||x - y||^2),
+ *    polynomial:   (gamma x' y + coef0)^degree,
+ *    chi_squared:  sum_k 2 x_k y_k / (x_k + y_k)  (non-negative features).
+ **/
+template <typename Data>
+struct kernel_function {
+  typedef Data data_type;
+
+  kernel_type type = kernel_type::linear;
+  data_type gamma = 1;
+  data_type coef0 = 0;
+  size_type degree = 3;
+
+
+  kernel_function() {}
+
+
+  kernel_function(
+      const kernel_type __type,
+      const data_type __gamma = 1,
+      const data_type __coef0 = 0,
+      const size_type __degree = 3
+    ) :
+      type(__type),
+      gamma(__gamma),
+      coef0(__coef0),
+      degree(__degree)
+  {}
+
+
+  inline data_type
+  operator()(
+      const size_type num_dimensions,
+      const data_type* x,
+      const data_type* y
+    ) const {
+    if (type == kernel_type::chi_squared) {
+      return chi_squared(num_dimensions, x, y);
+    }
+    const blas_int D = static_cast<blas_int>(num_dimensions);
+    return from_dot(sdca_blas_dot(D, x, x), sdca_blas_dot(D, y, y),
+                    sdca_blas_dot(D, x, y));
+  }
+
+
+  // The kernel given the squared norms of x and y and their dot product
+  inline data_type
+  from_dot(
+      const data_type xx,
+      const data_type yy,
+      const data_type xy
+    ) const {
+    switch (type) {
+      case kernel_type::rbf:
+        return std::exp(- gamma * std::max(xx + yy - 2 * xy,
+                                           static_cast<data_type>(0)));
+      case kernel_type::polynomial:
+        return static_cast<data_type>(std::pow(gamma * xy + coef0,
+          static_cast<data_type>(degree)));
+      default:
+        return xy;
+    }
+  }
+
+
+  inline data_type
+  chi_squared(
+      const size_type num_dimensions,
+      const data_type* x,
+      const data_type* y
+    ) const {
+    data_type sum(0);
+    for (size_type k = 0; k < num_dimensions; ++k) {
+      const data_type s = x[k] + y[k];
+      if (s > 0) sum += 2 * x[k] * y[k] / s;
+    }
+    return sum;
+  }
+
+
+  inline std::string
+  to_string() const {
+    std::ostringstream str;
+    str << "kernel_function (type: " << kernel_type_name(type) <<
+           ", gamma: " << gamma <<
+           ", coef0: " << coef0 <<
+           ", degree: " << degree << ")";
+    return str.str();
+  }
+
+};
+
+
+/**
+ * Computes the kernel columns
+ *    K_i = [k(x_1, y_i), ..., k(x_n, y_i)]
+ * between the n training examples x_j and the examples y_i on demand and
+ * keeps the most recently used ones in a cache of at most max_bytes
+ * (at least one column), as the kernel cache in libsvm [1].
+ * The cache is thread-safe; a returned column stays valid while it is
+ * referenced, even if it is evicted from the cache meanwhile.
+ * The columns are split into shards by i % num_shards, each with its own
+ * lock and LRU list, so that the threads rarely wait for each other
+ * (a large cache only, every shard keeps at least min_shard_columns).
+ * The buffer of an evicted column is reused if it is no longer referenced.
+ *
+ * [1] Chang CC, Lin CJ.
+ *     LIBSVM: A library for support vector machines.
+ *     ACM Transactions on Intelligent Systems and Technology. 2011.
+ **/
+template <typename Data>
+class kernel_cache {
+public:
+  typedef Data data_type;
+  typedef std::shared_ptr<const std::vector<Data>> column_type;
+
+
+  kernel_cache(
+      const size_type num_dimensions,
+      const size_type num_train_examples,
+      const Data* train_features,
+      const kernel_function<Data>& kernel,
+      const size_type max_bytes
+    ) :
+      num_dimensions_(num_dimensions),
+      num_train_examples_(num_train_examples),
+      train_features_(train_features),
+      kernel_(kernel),
+      num_hits_(0),
+      num_misses_(0)
+  {
+    const size_type column_bytes = std::max(static_cast<size_type>(1),
+      num_train_examples * sizeof(Data));
+    capacity_ = std::max(static_cast<size_type>(1), max_bytes / column_bytes);
+
+    // Split the capacity evenly, the first shards take the remainder
+    const size_type num_shards = std::max(static_cast<size_type>(1),
+      std::min(max_shards, capacity_ / min_shard_columns));
+    shards_ = std::vector<cache_shard>(num_shards);
+    for (size_type s = 0; s < num_shards; ++s) {
+      shards_[s].capacity = capacity_ / num_shards +
+        (s < capacity_ % num_shards ? 1 : 0);
+    }
+
+    // The squared norms of the training examples (for rbf)
+    norms_.resize(num_train_examples);
+    const blas_int D = static_cast<blas_int>(num_dimensions);
+    for (size_type j = 0; j < num_train_examples; ++j) {
+      const Data* x = train_features + num_dimensions * j;
+      norms_[j] = sdca_blas_dot(D, x, x);
+    }
+  }
+
+
+  kernel_cache(const kernel_cache&) = delete;
+  kernel_cache& operator=(const kernel_cache&) = delete;
+
+
+  /**
+   * Returns the column K_i of the example y (i.e. y_i),
+   * computed only if it is not in the cache.
+   **/
+  column_type column(
+      const size_type i,
+      const Data* y
+    ) {
+    cache_shard& shard = shards_[i % shards_.size()];
+    buffer_type buffer;
+    {
+      std::lock_guard<std::mutex> lock(shard.mutex);
+      auto it = shard.index.find(i);
+      if (it != shard.index.end()) {
+        num_hits_.fetch_add(1, std::memory_order_relaxed);
+        shard.lru.splice(shard.lru.begin(), shard.lru, it->second.second);
+        return it->second.first;
+      }
+      num_misses_.fetch_add(1, std::memory_order_relaxed);
+      if (shard.index.size() >= shard.capacity) {
+        buffer = shard.evict();
+      }
+    }
+
+    // Other threads may use the cache while the column is computed
+    if (buffer.use_count() == 1) {
+      // Nobody else references the evicted column, reuse its storage
+      std::atomic_thread_fence(std::memory_order_acquire);
+    } else {
+      buffer.reset(new std::vector<Data>(num_train_examples_));
+    }
+    compute(y, buffer->data());
+
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.index.find(i);
+    if (it != shard.index.end()) {
+      return it->second.first;
+    }
+    if (shard.index.size() >= shard.capacity) {
+      shard.evict();
+    }
+    shard.lru.push_front(i);
+    shard.index.emplace(i, std::make_pair(buffer, shard.lru.begin()));
+    return buffer;
+  }
+
+
+  // The kernel k(y, y) of an example with itself
+  Data diagonal(
+      const Data* y
+    ) const {
+    return kernel_(num_dimensions_, y, y);
+  }
+
+
+  size_type capacity() const { return capacity_; }
+
+  size_type num_shards() const { return shards_.size(); }
+
+  size_type num_hits() const {
+    return num_hits_.load(std::memory_order_relaxed);
+  }
+
+  size_type num_misses() const {
+    return num_misses_.load(std::memory_order_relaxed);
+  }
+
+  const kernel_function<Data>& kernel() const { return kernel_; }
+
+  size_type num_dimensions() const { return num_dimensions_; }
+
+  size_type num_train_examples() const { return num_train_examples_; }
+
+  const Data* train_features() const { return train_features_; }
+
+
+  inline std::string
+  to_string() const {
+    std::ostringstream str;
+    str << "kernel_cache (capacity: " << capacity_ <<
+           ", shards: " << shards_.size() <<
+           ", hits: " << num_hits() <<
+           ", misses: " << num_misses() << ")";
+    return str.str();
+  }
+
+private:
+  typedef std::shared_ptr<std::vector<Data>> buffer_type;
+
+  static constexpr size_type max_shards = 16;
+  static constexpr size_type min_shard_columns = 8;
+
+  struct cache_shard {
+    size_type capacity = 0;
+    std::list<size_type> lru;
+    std::unordered_map<size_type, std::pair<buffer_type,
+      std::list<size_type>::iterator>> index;
+    std::mutex mutex;
+
+    // Removes the least recently used column (the lock must be held)
+    buffer_type evict() {
+      auto it = index.find(lru.back());
+      buffer_type buffer = std::move(it->second.first);
+      index.erase(it);
+      lru.pop_back();
+      return buffer;
+    }
+  };
+
+  size_type num_dimensions_;
+  size_type num_train_examples_;
+  const Data* train_features_;
+  kernel_function<Data> kernel_;
+  std::vector<Data> norms_;
+
+  size_type capacity_;
+  std::vector<cache_shard> shards_;
+  std::atomic<size_type> num_hits_;
+  std::atomic<size_type> num_misses_;
+
+
+  void compute(
+      const Data* y,
+      Data* K
+    ) const {
+    const size_type n = num_train_examples_;
+    if (kernel_.type == kernel_type::chi_squared) {
+      for (size_type j = 0; j < n; ++j) {
+        K[j] = kernel_.chi_squared(num_dimensions_,
+          train_features_ + num_dimensions_ * j, y);
+      }
+      return;
+    }
+
+    // Let K = X' * y, then apply the kernel to the dot products
+    const blas_int D = static_cast<blas_int>(num_dimensions_);
+    sdca_blas_gemv(D, static_cast<blas_int>(n), train_features_, y, K,
+                   CblasTrans);
+    if (kernel_.type != kernel_type::linear) {
+      const Data yy = sdca_blas_dot(D, y, y);
+      for (size_type j = 0; j < n; ++j) {
+        K[j] = kernel_.from_dot(norms_[j], yy, K[j]);
+      }
+    }
+  }
+};
+
+
+template <typename Data>
+constexpr size_type kernel_cache<Data>::max_shards;
+
+template <typename Data>
+constexpr size_type kernel_cache<Data>::min_shard_columns;
+
+}
+
+#endif
@@ -0,0 +1,562 @@
+#ifndef SDCA_SOLVER_DATA_LIBSVM_FILE_H
+#define SDCA_SOLVER_DATA_LIBSVM_FILE_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "sdca/solver/data.h"
+#include "sdca/utility/mapped_file.h"
+#include "sdca/utility/parallel.h"
+#include "sdca/utility/types.h"
+
+namespace sdca {
+
+/*
+ * Parses an unsigned integer in [first, last), returns the end of the number
+ * or nullptr if there are no digits.
+ */
+inline const char*
+parse_libsvm_unsigned(
+    const char* first,
+    const char* last,
+    size_type& x
+  ) {
+  const char* p = first;
+  x = 0;
+  while (p != last && static_cast<unsigned>(*p - '0') < 10) {
+    x = 10 * x + static_cast<size_type>(*p - '0');
+    ++p;
+  }
+  return (p != first) ? p : nullptr;
+}
+
+
+/*
+ * Returns true and the value of the 8 decimal digits at p (SWAR, i.e. all
+ * 8 bytes at once in a 64-bit integer), or false if some are not digits.
+ * Only on little-endian targets, elsewhere the digits are parsed one by one.
+ */
+inline bool
+parse_libsvm_8digits(
+    const char* p,
+    std::uint64_t& x
+  ) {
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+  std::uint64_t v;
+  std::memcpy(&v, p, sizeof(v));
+  if (((v & 0xF0F0F0F0F0F0F0F0) |
+       (((v + 0x0606060606060606) & 0xF0F0F0F0F0F0F0F0) >> 4)) !=
+      0x3333333333333333) {
+    return false;
+  }
+  v -= 0x3030303030303030;
+  v = (v * 10) + (v >> 8);
+  x = (((v & 0x000000FF000000FF) * (100 + (1000000ULL << 32))) +
+       (((v >> 16) & 0x000000FF000000FF) * (1 + (10000ULL << 32)))) >> 32;
+  return true;
+#else
+  (void) p;
+  (void) x;
+  return false;
+#endif
+}
+
+
+/*
+ * Parses a real number in [first, last), returns the end of the number
+ * or nullptr if it is not a number.
+ * The decimal digits are accumulated in an integer mantissa (8 at a time
+ * where possible) and scaled by a power of ten; if both are exact doubles
+ * (at most 2^53 and 10^22), the result is correctly rounded [1], which
+ * covers the usual short numbers and is several times faster than strtod.
+ * Everything else (long mantissas or exponents, inf, nan, hex) is passed
+ * on to strtod.
+ *
+ * [1] Clinger WD.
+ *     How to read floating point numbers accurately.
+ *     PLDI 1990.
+ */
+template <typename Data>
+inline const char*
+parse_libsvm_real(
+    const char* first,
+    const char* last,
+    Data& x
+  ) {
+  static const double powers[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7,
+    1e8, 1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19,
+    1e20, 1e21, 1e22};
+  const char* p = first;
+  const bool negative = (p != last && *p == '-');
+  if (p != last && (*p == '-' || *p == '+')) ++p;
+
+  // At most 18 digits fit into the mantissa, more go to strtod
+  std::uint64_t mantissa = 0, digits8;
+  int num_digits = 0, exponent = 0;
+  const char* digits = p;
+  for (; p != last && static_cast<unsigned>(*p - '0') < 10; ++p) {
+    mantissa = 10 * mantissa + static_cast<std::uint64_t>(*p - '0');
+    ++num_digits;
+  }
+  bool has_digits = (p != digits);
+  if (p != last && *p == '.') {
+    digits = ++p;
+    while (last - p >= 8 && num_digits <= 10 &&
+           parse_libsvm_8digits(p, digits8)) {
+      mantissa = 100000000 * mantissa + digits8;
+      num_digits += 8;
+      p += 8;
+    }
+    for (; p != last && static_cast<unsigned>(*p - '0') < 10; ++p) {
+      mantissa = 10 * mantissa + static_cast<std::uint64_t>(*p - '0');
+      ++num_digits;
+    }
+    exponent = static_cast<int>(digits - p);
+    has_digits = has_digits || (p != digits);
+  }
+  if (has_digits && p != last && (*p == 'e' || *p == 'E')) {
+    const char* q = p + 1;
+    const bool negative_exponent = (q != last && *q == '-');
+    if (q != last && (*q == '-' || *q == '+')) ++q;
+    size_type e;
+    const char* end = parse_libsvm_unsigned(q, last, e);
+    if (end != nullptr) {
+      exponent += (e > 1000) ? 1000 * (negative_exponent ? -1 : 1)
+        : static_cast<int>(e) * (negative_exponent ? -1 : 1);
+      p = end;
+    }
+  }
+
+  if (has_digits && num_digits <= 18 && exponent >= -22 && exponent <= 22 &&
+      mantissa <= (static_cast<std::uint64_t>(1) << 53)) {
+    double value = static_cast<double>(mantissa);
+    value = (exponent < 0) ? value / powers[-exponent]
+                           : value * powers[exponent];
+    x = static_cast<Data>(negative ? -value : value);
+    return p;
+  }
+
+  // The slow path needs a null-terminated copy of the token
+  char buffer[64];
+  size_type n = 0;
+  for (const char* q = first; q != last && n + 1 < sizeof(buffer) &&
+       *q != ' ' && *q != '\t' && *q != '\n' && *q != '\r'; ++q) {
+    buffer[n++] = *q;
+  }
+  buffer[n] = '\0';
+  char* end;
+  const double value = std::strtod(buffer, &end);
+  if (end == buffer) return nullptr;
+  x = static_cast<Data>(value);
+  return first + (end - buffer);
+}
+
+
+struct libsvm_options {
+  // The number of parsing threads (0 = all hardware threads)
+  size_type num_threads = 0;
+
+  // The number of dimensions (0 = the largest feature index),
+  // e.g. the num_dimensions of the training set for a test set
+  size_type num_dimensions = 0;
+
+  // The feature indices start at 0 instead of 1
+  bool zero_based = false;
+};
+
+
+/*
+ * A dataset in the LIBSVM / SVMlight text format, one example per line:
+ *    <label>[,<label>...] <index>:<value> <index>:<value> ... [# comment]
+ * with 1-based feature indices (see libsvm_options::zero_based) and
+ * non-negative integer labels (several comma-separated labels for
+ * multilabel data, as in the LIBSVM multilabel datasets).
+ * Binary files with the labels -1 and +1 are mapped to the classes 0 and 1,
+ * any other negative label is invalid.
+ * Empty lines, comment lines and SVMlight "qid:" tokens are skipped.
+ *
+ * The file is memory-mapped and split into num_threads byte ranges, each
+ * of which is parsed by a thread into its own buffers; a thread owns the
+ * lines that start in its range. The buffers are then concatenated in
+ * parallel into the compressed sparse column format of sparse_feature_input.
+ * A thread parses about 250-330 MB/s of text (30 short real features per
+ * line, measured on one core); the scaling with more cores is not measured.
+ * Throws std::runtime_error if the file cannot be read or is invalid.
+ */
+template <typename Data>
+class libsvm_file {
+public:
+  typedef Data data_type;
+
+
+  explicit libsvm_file(
+      const std::string& path,
+      const libsvm_options& options = libsvm_options()
+    ) :
+      num_dimensions_(0),
+      num_examples_(0),
+      is_multilabel_(false)
+  {
+    mapped_file file(path);
+    file.advise(access_pattern::sequential);
+    try {
+      parse(file.data(), file.data() + file.size(), options);
+    } catch (const std::runtime_error& e) {
+      throw std::runtime_error(e.what() + (" in '" + path + "'."));
+    }
+  }
+
+
+  size_type num_dimensions() const { return num_dimensions_; }
+
+  size_type num_examples() const { return num_examples_; }
+
+  size_type num_nonzeros() const { return values_.size(); }
+
+  // Some example has more or less than one label
+  bool is_multilabel() const { return is_multilabel_; }
+
+
+  // The features in the compressed sparse column format
+  const std::vector<Data>& values() const { return values_; }
+
+  const std::vector<size_type>& indices() const { return indices_; }
+
+  const std::vector<size_type>& offsets() const { return offsets_; }
+
+
+  // The labels of the example i are labels[label_offsets[i]], ...
+  const std::vector<size_type>& labels() const { return labels_; }
+
+  const std::vector<size_type>& label_offsets() const {
+    return label_offsets_;
+  }
+
+
+  sparse_feature_input<Data> sparse_features() const {
+    return make_input_sparse_feature(num_dimensions_, num_examples_,
+      values_.data(), indices_.data(), offsets_.data());
+  }
+
+
+  /*
+   * Scatters the features into the num_dimensions-by-num_examples dense
+   * matrix (column-major) and returns the input that points to it.
+   */
+  feature_input<Data> dense_features(
+      std::vector<Data>& features
+    ) const {
+    features.assign(num_dimensions_ * num_examples_, static_cast<Data>(0));
+    for (size_type i = 0; i < num_examples_; ++i) {
+      Data* x = &features[num_dimensions_ * i];
+      for (size_type k = offsets_[i]; k < offsets_[i + 1]; ++k) {
+        x[indices_[k]] = values_[k];
+      }
+    }
+    return make_input_feature(num_dimensions_, num_examples_,
+                              features.data());
+  }
+
+
+  multiclass_output multiclass() const {
+    if (is_multilabel_) {
+      throw std::invalid_argument("LIBSVM file has multilabel labels.");
+    }
+    return make_output_multiclass(labels_.begin(), labels_.end());
+  }
+
+
+  multilabel_output multilabel() const {
+    return make_output_multilabel(labels_.begin(), labels_.end(),
+      label_offsets_.begin(), label_offsets_.end());
+  }
+
+
+  inline std::string
+  to_string() const {
+    std::ostringstream str;
+    str << "libsvm_file (num_dimensions: " << num_dimensions_ <<
+           ", num_examples: " << num_examples_ <<
+           ", num_nonzeros: " << num_nonzeros() <<
+           ", num_labels: " << labels_.size() << ")";
+    return str.str();
+  }
+
+private:
+  size_type num_dimensions_;
+  size_type num_examples_;
+  bool is_multilabel_;
+  std::vector<Data> values_;
+  std::vector<size_type> indices_;
+  std::vector<size_type> offsets_;
+  std::vector<size_type> labels_;
+  std::vector<size_type> label_offsets_;
+
+
+  // The examples of one byte range (offsets relative to the range)
+  struct range_type {
+    std::vector<Data> values;
+    std::vector<size_type> indices;
+    std::vector<size_type> offsets;
+    std::vector<size_type> labels;
+    std::vector<size_type> label_offsets;
+    size_type max_index = 0;
+    bool has_negative_label = false;
+    std::exception_ptr error;
+  };
+
+
+  // A label of -1 while parsing (see map_binary_labels)
+  static constexpr size_type negative_label = static_cast<size_type>(-1);
+
+
+  void parse(
+      const char* first,
+      const char* last,
+      const libsvm_options& options
+    ) {
+    const size_type size = static_cast<size_type>(last - first);
+    const size_type min_range = 1 << 16;
+    const size_type num_ranges = std::max(static_cast<size_type>(1),
+      std::min(resolve_num_threads(options.num_threads), size / min_range));
+
+    std::vector<range_type> ranges(num_ranges);
+    parallel_for(num_ranges, 0, num_ranges,
+      [&](const size_type, const size_type begin, const size_type end) {
+        for (size_type t = begin; t < end; ++t) {
+          try {
+            parse_range(first, last,
+              first + block_begin(0, size, num_ranges, t),
+              first + block_begin(0, size, num_ranges, t + 1),
+              options.zero_based, ranges[t]);
+          } catch (...) {
+            ranges[t].error = std::current_exception();
+          }
+        }
+      });
+
+    // Concatenate the ranges in parallel at their prefix sums
+    std::vector<size_type> example_begin(num_ranges + 1, 0);
+    std::vector<size_type> value_begin(num_ranges + 1, 0);
+    std::vector<size_type> label_begin(num_ranges + 1, 0);
+    size_type max_index = 0;
+    bool has_negative_label = false;
+    for (size_type t = 0; t < num_ranges; ++t) {
+      if (ranges[t].error) std::rethrow_exception(ranges[t].error);
+      has_negative_label = has_negative_label || ranges[t].has_negative_label;
+      example_begin[t + 1] = example_begin[t] + ranges[t].offsets.size() - 1;
+      value_begin[t + 1] = value_begin[t] + ranges[t].values.size();
+      label_begin[t + 1] = label_begin[t] + ranges[t].labels.size();
+      max_index = std::max(max_index, ranges[t].max_index);
+    }
+    num_examples_ = example_begin[num_ranges];
+    num_dimensions_ = (options.num_dimensions > 0)
+      ? options.num_dimensions : max_index;
+    if (max_index > num_dimensions_) {
+      throw std::runtime_error("Feature index exceeds num_dimensions");
+    }
+
+    if (num_ranges == 1) {
+      // A single range is already in place
+      values_.swap(ranges[0].values);
+      indices_.swap(ranges[0].indices);
+      offsets_.swap(ranges[0].offsets);
+      labels_.swap(ranges[0].labels);
+      label_offsets_.swap(ranges[0].label_offsets);
+      if (has_negative_label) map_binary_labels();
+      check_multilabel();
+      return;
+    }
+
+    values_.resize(value_begin[num_ranges]);
+    indices_.resize(value_begin[num_ranges]);
+    offsets_.resize(num_examples_ + 1);
+    labels_.resize(label_begin[num_ranges]);
+    label_offsets_.resize(num_examples_ + 1);
+    parallel_for(num_ranges, 0, num_ranges,
+      [&](const size_type, const size_type begin, const size_type end) {
+        for (size_type t = begin; t < end; ++t) {
+          const range_type& r = ranges[t];
+          std::copy(r.values.begin(), r.values.end(),
+                    values_.begin() + static_cast<diff_type>(value_begin[t]));
+          std::copy(r.indices.begin(), r.indices.end(),
+                    indices_.begin() + static_cast<diff_type>(value_begin[t]));
+          std::copy(r.labels.begin(), r.labels.end(),
+                    labels_.begin() + static_cast<diff_type>(label_begin[t]));
+          for (size_type i = 0; i + 1 < r.offsets.size(); ++i) {
+            offsets_[example_begin[t] + i] = value_begin[t] + r.offsets[i];
+            label_offsets_[example_begin[t] + i] =
+              label_begin[t] + r.label_offsets[i];
+          }
+        }
+      });
+    offsets_[num_examples_] = values_.size();
+    label_offsets_[num_examples_] = labels_.size();
+    if (has_negative_label) map_binary_labels();
+    check_multilabel();
+  }
+
+
+  // Maps the binary labels -1 and +1 to 0 and 1
+  void map_binary_labels() {
+    for (size_type& label : labels_) {
+      if (label == negative_label) {
+        label = 0;
+      } else if (label != 1) {
+        throw std::runtime_error("Negative labels other than -1/+1");
+      }
+    }
+  }
+
+
+  void check_multilabel() {
+    is_multilabel_ = false;
+    for (size_type i = 0; i < num_examples_; ++i) {
+      if (label_offsets_[i + 1] - label_offsets_[i] != 1) {
+        is_multilabel_ = true;
+        break;
+      }
+    }
+  }
+
+
+  /*
+   * Parses the lines that start in [begin, end), the last one of which
+   * may continue up to the end of the file.
+   */
+  static void parse_range(
+      const char* file_first,
+      const char* file_last,
+      const char* begin,
+      const char* end,
+      const bool zero_based,
+      range_type& r
+    ) {
+    // Skip the line that started in the previous range
+    const char* p = begin;
+    if (p != file_first && p[-1] != '\n') {
+      p = std::find(p, file_last, '\n');
+      if (p != file_last) ++p;
+    }
+    r.offsets.push_back(0);
+    r.label_offsets.push_back(0);
+    const size_type size_hint = static_cast<size_type>(end - begin) / 8;
+    r.values.reserve(size_hint);
+    r.indices.reserve(size_hint);
+
+    while (p < end) {
+      const char* line_end = std::find(p, file_last, '\n');
+      parse_line(file_first, p, line_end, zero_based, r);
+      p = (line_end != file_last) ? line_end + 1 : file_last;
+    }
+  }
+
+
+  static void parse_line(
+      const char* file_first,
+      const char* p,
+      const char* last,
+      const bool zero_based,
+      range_type& r
+    ) {
+    if (last != p && last[-1] == '\r') --last;
+    p = skip_blanks(p, last);
+    if (p == last || *p == '#') return;
+
+    // The labels
+    const size_type labels_begin = r.labels.size();
+    for (;;) {
+      const bool negative = (p != last && *p == '-');
+      if (p != last && (*p == '+' || *p == '-')) ++p;
+      size_type label;
+      const char* q = parse_libsvm_unsigned(p, last, label);
+      if (q == nullptr) throw_invalid(file_first, p, "Invalid label");
+      if (q != last && *q == '.') {
+        // Integral labels written as reals, e.g. "2.0"
+        while (++q != last && *q == '0') {}
+      }
+      if (negative) {
+        if (label != 1) throw_invalid(file_first, p, "Invalid label");
+        label = negative_label;
+        r.has_negative_label = true;
+      }
+      r.labels.push_back(label);
+      p = q;
+      if (p == last || *p != ',') break;
+      ++p;
+    }
+    std::sort(r.labels.begin() + static_cast<diff_type>(labels_begin),
+              r.labels.end());
+    if (r.labels.back() == negative_label &&
+        r.labels.size() - labels_begin > 1) {
+      throw_invalid(file_first, p, "Invalid multilabel -1");
+    }
+
+    // The features
+    for (;;) {
+      const char* q = skip_blanks(p, last);
+      if (q == last || *q == '#') break;
+      if (q == p) throw_invalid(file_first, q, "Expected a space");
+      p = q;
+      if (last - p > 4 && std::equal(p, p + 4, "qid:")) {
+        while (p != last && *p != ' ' && *p != '\t') ++p;
+        continue;
+      }
+
+      size_type index;
+      q = parse_libsvm_unsigned(p, last, index);
+      if (q == nullptr || q == last || *q != ':') {
+        throw_invalid(file_first, p, "Invalid feature index");
+      }
+      if (!zero_based) {
+        if (index == 0) throw_invalid(file_first, p, "Invalid feature index");
+        --index;
+      }
+      Data value;
+      p = parse_libsvm_real(q + 1, last, value);
+      if (p == nullptr) throw_invalid(file_first, q + 1, "Invalid value");
+
+      r.values.push_back(value);
+      r.indices.push_back(index);
+      r.max_index = std::max(r.max_index, index + 1);
+    }
+
+    r.offsets.push_back(r.values.size());
+    r.label_offsets.push_back(r.labels.size());
+  }
+
+
+  static const char* skip_blanks(
+      const char* p,
+      const char* last
+    ) {
+    while (p != last && (*p == ' ' || *p == '\t')) ++p;
+    return p;
+  }
+
+
+  [[noreturn]] static void throw_invalid(
+      const char* file_first,
+      const char* p,
+      const char* message
+    ) {
+    std::ostringstream str;
+    str << message << " at byte " << (p - file_first);
+    throw std::runtime_error(str.str());
+  }
+};
+
+
+template <typename Data>
+constexpr size_type libsvm_file<Data>::negative_label;
+
+}
+
+#endif
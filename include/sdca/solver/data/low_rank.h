@@ -0,0 +1,286 @@
+#ifndef SDCA_SOLVER_DATA_LOW_RANK_H
+#define SDCA_SOLVER_DATA_LOW_RANK_H
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+
+#include "sdca/math/blas.h"
+#include "sdca/solver/data/input.h"
+#include "sdca/utility/logging.h"
+#include "sdca/utility/types.h"
+
+namespace sdca {
+
+enum class low_rank_method {
+  incomplete_cholesky = 0,
+  nystrom
+};
+
+
+inline const char*
+low_rank_method_name(
+    const low_rank_method method
+  ) {
+  switch (method) {
+    case low_rank_method::incomplete_cholesky:
+      return "incomplete_cholesky";
+    case low_rank_method::nystrom:
+      return "nystrom";
+  }
+  return "unknown";
+}
+
+
+struct low_rank_options {
+  low_rank_method method = low_rank_method::incomplete_cholesky;
+
+  // The rank is increased until the trace of the residual K - G G'
+  // is at most tolerance * trace(K), or max_rank is reached (0 = no limit)
+  double tolerance = 1e-3;
+  size_type max_rank = 0;
+
+  // The order of the landmarks for nystrom
+  unsigned seed = 1;
+
+
+  inline std::string
+  to_string() const {
+    std::ostringstream str;
+    str << "method: " << low_rank_method_name(method) <<
+           ", tolerance: " << tolerance <<
+           ", max_rank: " << max_rank <<
+           ", seed: " << seed;
+    return str.str();
+  }
+};
+
+
+/**
+ * A low-rank approximation K ~ G G' of the n-by-n training kernel, where
+ * G = K(:, P) L^{-T} for r pivots P and the Cholesky factor L of K(P, P).
+ * The examples are then represented by the r-dimensional features
+ *    f(x) = L^{-1} k(P, x),
+ * i.e. the rows of G for the training examples, which turns kernel SDCA
+ * into linear SDCA with O(m r) instead of O(m n) per update.
+ *
+ * The pivots are chosen greedily by the largest residual diagonal
+ * (pivoted incomplete Cholesky [1]) or in a random order (Nystrom [2]),
+ * in both cases the factor is computed in O(n r^2) from r columns of K.
+ *
+ * [1] Fine S, Scheinberg K.
+ *     Efficient SVM training using low-rank kernel representations.
+ *     JMLR 2001;2:243-264.
+ *
+ * [2] Williams CKI, Seeger M.
+ *     Using the Nystrom method to speed up kernel machines.
+ *     NIPS 2001.
+ **/
+template <typename Data>
+class low_rank_kernel {
+public:
+  typedef Data data_type;
+
+
+  low_rank_kernel(
+      const kernel_input<Data>& train,
+      const low_rank_options& options = low_rank_options()
+    ) :
+      num_examples_(train.num_examples),
+      options_(options),
+      trace_(0),
+      trace_error_(0)
+  {
+    if (train.num_train_examples != train.num_examples) {
+      throw std::invalid_argument("The training kernel must be square.");
+    }
+    factorize(train.kernel);
+    LOG_VERBOSE << "Low-rank kernel: " << to_string() << std::endl;
+  }
+
+
+  size_type rank() const { return pivots_.size(); }
+
+  size_type num_examples() const { return num_examples_; }
+
+  const std::vector<size_type>& pivots() const { return pivots_; }
+
+  // The trace of the residual K - G G' relative to the trace of K
+  double trace_error() const {
+    return (trace_ > 0) ? trace_error_ / trace_ : 0;
+  }
+
+
+  // The rank-by-num_examples features of the training examples
+  const std::vector<Data>& features() const { return features_; }
+
+
+  feature_input<Data> train_input() const {
+    return feature_input<Data>(rank(), num_examples_, features_.data());
+  }
+
+
+  /**
+   * Computes the rank-by-num_examples features f(x) = L^{-1} k(P, x)
+   * of the examples of a test kernel (num_train_examples-by-num_examples).
+   **/
+  void transform(
+      const kernel_input<Data>& test,
+      std::vector<Data>& features
+    ) const {
+    if (test.num_train_examples != num_examples_) {
+      throw std::invalid_argument("The test kernel must have one row per "
+                                  "training example.");
+    }
+    const size_type r = rank();
+    features.resize(r * test.num_examples);
+    for (size_type i = 0; i < test.num_examples; ++i) {
+      const Data* k = test.kernel + test.num_train_examples * i;
+      Data* f = &features[r * i];
+      for (size_type j = 0; j < r; ++j) {
+        f[j] = k[pivots_[j]];
+      }
+      solve_lower(f);
+    }
+  }
+
+
+  inline std::string
+  to_string() const {
+    std::ostringstream str;
+    str << "low_rank_kernel (" << options_.to_string() <<
+           ", num_examples: " << num_examples_ <<
+           ", rank: " << rank() <<
+           ", trace_error: " << trace_error() << ")";
+    return str.str();
+  }
+
+private:
+  size_type num_examples_;
+  low_rank_options options_;
+  std::vector<size_type> pivots_;
+  std::vector<Data> factor_; // L = G(P, :), rank-by-rank, row-major
+  std::vector<Data> features_; // G', rank-by-num_examples
+  double trace_;
+  double trace_error_;
+
+
+  void factorize(
+      const Data* K
+    ) {
+    const size_type n = num_examples_;
+    const size_type max_rank = (options_.max_rank > 0)
+      ? std::min(options_.max_rank, n) : n;
+
+    // The residual diagonal of K - G G'
+    std::vector<Data> residual(n);
+    for (size_type i = 0; i < n; ++i) {
+      residual[i] = K[n * i + i];
+    }
+    trace_ = std::accumulate(residual.begin(), residual.end(), 0.0);
+    // Residuals below the round-off of the updates are considered zero
+    const Data eps = static_cast<Data>(n) *
+      std::numeric_limits<Data>::epsilon() *
+      std::max(static_cast<Data>(1), *std::max_element(residual.begin(),
+                                                       residual.end()));
+
+    std::vector<size_type> landmarks;
+    if (options_.method == low_rank_method::nystrom) {
+      landmarks.resize(n);
+      std::iota(landmarks.begin(), landmarks.end(), 0);
+      std::mt19937 gen(options_.seed);
+      std::shuffle(landmarks.begin(), landmarks.end(), gen);
+    }
+
+    // The columns of G (n-by-rank, column-major)
+    std::vector<Data> G;
+    G.reserve(n * std::min(max_rank, static_cast<size_type>(64)));
+    std::vector<Data> g_p;
+    auto next_landmark = landmarks.begin();
+    trace_error_ = trace_;
+    while (pivots_.size() < max_rank &&
+           trace_error_ > options_.tolerance * trace_) {
+      // Choose the pivot p
+      size_type p = 0;
+      if (options_.method == low_rank_method::nystrom) {
+        while (next_landmark != landmarks.end() &&
+               residual[*next_landmark] <= eps) ++next_landmark;
+        if (next_landmark == landmarks.end()) break;
+        p = *next_landmark++;
+      } else {
+        p = static_cast<size_type>(std::max_element(residual.begin(),
+          residual.end()) - residual.begin());
+      }
+      if (residual[p] <= eps) break;
+
+      // Let g = (K(:, p) - G * G(p, :)') / sqrt(residual(p))
+      const size_type k = pivots_.size();
+      const blas_int N = static_cast<blas_int>(n);
+      G.resize(n * (k + 1));
+      Data* g = &G[n * k];
+      std::copy(K + n * p, K + n * (p + 1), g);
+      if (k > 0) {
+        g_p.resize(k);
+        for (size_type j = 0; j < k; ++j) {
+          g_p[j] = G[n * j + p];
+        }
+        sdca_blas_gemv(N, static_cast<blas_int>(k), &G[0], &g_p[0], g,
+                       CblasNoTrans, -1, 1);
+      }
+      const Data pivot = std::sqrt(residual[p]);
+      sdca_blas_scal(N, 1 / pivot, g);
+      g[p] = pivot;
+      for (size_type j : pivots_) {
+        g[j] = 0; // exactly, so that G(P, :) is lower triangular
+      }
+
+      for (size_type i = 0; i < n; ++i) {
+        residual[i] = std::max(residual[i] - g[i] * g[i],
+                               static_cast<Data>(0));
+      }
+      residual[p] = 0;
+      pivots_.push_back(p);
+      trace_error_ = std::accumulate(residual.begin(), residual.end(), 0.0);
+    }
+
+    // Keep L = G(P, :) and the features G'
+    const size_type r = pivots_.size();
+    factor_.resize(r * r);
+    for (size_type a = 0; a < r; ++a) {
+      for (size_type b = 0; b < r; ++b) {
+        factor_[r * a + b] = G[n * b + pivots_[a]];
+      }
+    }
+    features_.resize(r * n);
+    for (size_type i = 0; i < n; ++i) {
+      for (size_type j = 0; j < r; ++j) {
+        features_[r * i + j] = G[n * j + i];
+      }
+    }
+  }
+
+
+  // Let f = L^{-1} f (forward substitution)
+  void solve_lower(
+      Data* f
+    ) const {
+    const size_type r = rank();
+    for (size_type a = 0; a < r; ++a) {
+      const Data* row = &factor_[r * a];
+      Data sum = f[a];
+      for (size_type b = 0; b < a; ++b) {
+        sum -= row[b] * f[b];
+      }
+      f[a] = sum / row[a];
+    }
+  }
+};
+
+}
+
+#endif
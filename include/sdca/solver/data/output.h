@@ -207,6 +207,42 @@ validate_labels_and_offsets(
   }
 }
 
+
+/**
+ * Returns the labels of the examples [first, last) as a new output,
+ * e.g. for a chunk of a dataset that is streamed from disk.
+ **/
+inline multiclass_output
+make_output_slice(
+    const multiclass_output& out,
+    const size_type first,
+    const size_type last
+  ) {
+  std::vector<size_type> labels(
+    out.labels.begin() + static_cast<diff_type>(first),
+    out.labels.begin() + static_cast<diff_type>(last));
+  return multiclass_output(out.num_classes, labels);
+}
+
+
+inline multilabel_output
+make_output_slice(
+    const multilabel_output& out,
+    const size_type first,
+    const size_type last
+  ) {
+  std::vector<size_type> labels(out.labels_cbegin(first),
+                                out.labels_cbegin(last));
+  std::vector<size_type> offsets(
+    out.offsets.begin() + static_cast<diff_type>(first),
+    out.offsets.begin() + static_cast<diff_type>(last + 1));
+  const size_type base = offsets[0];
+  for (auto& offset : offsets) {
+    offset -= base;
+  }
+  return multilabel_output(out.num_classes, labels, offsets);
+}
+
 }
 
 #endif
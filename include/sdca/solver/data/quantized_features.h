@@ -0,0 +1,171 @@
+#ifndef SDCA_SOLVER_DATA_QUANTIZED_FEATURES_H
+#define SDCA_SOLVER_DATA_QUANTIZED_FEATURES_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <sstream>
+#include <vector>
+
+#include "sdca/math/quantized.h"
+#include "sdca/solver/data/input.h"
+#include "sdca/utility/types.h"
+
+namespace sdca {
+
+enum class quantization_scale {
+  per_example = 0,
+  per_feature
+};
+
+
+inline const char*
+quantization_scale_name(
+    const quantization_scale scale
+  ) {
+  switch (scale) {
+    case quantization_scale::per_example:
+      return "per_example";
+    case quantization_scale::per_feature:
+      return "per_feature";
+  }
+  return "unknown";
+}
+
+
+/**
+ * Compresses a dense num_dimensions-by-num_examples feature matrix
+ * (column-major) to 1 (int8) or 2 (fp16, bf16) bytes per value and owns
+ * the storage that input() points to.
+ *
+ * int8 is symmetric with the scale max |x| / 127, either per example
+ * (one scale per column) or per feature (one scale per row); the latter is
+ * better if the features have very different ranges. fp16 and bf16 round
+ * to the nearest representable value and need no scales; fp16 is more
+ * precise, bf16 has the range of float.
+ **/
+template <typename Data>
+class quantized_features {
+public:
+  typedef Data data_type;
+
+
+  quantized_features(
+      const size_type num_dimensions,
+      const size_type num_examples,
+      const Data* features,
+      const quantization_type type,
+      const quantization_scale scale = quantization_scale::per_example
+    ) :
+      num_dimensions_(num_dimensions),
+      num_examples_(num_examples),
+      type_(type),
+      scale_(scale)
+  {
+    const size_type size = num_dimensions * num_examples;
+    switch (type) {
+      case quantization_type::int8:
+        quantize_int8(features);
+        break;
+      case quantization_type::fp16:
+        fp16_.resize(size);
+        for (size_type k = 0; k < size; ++k) {
+          fp16_[k] = sdca_float_to_half(static_cast<float>(features[k]));
+        }
+        break;
+      case quantization_type::bf16:
+        bf16_.resize(size);
+        for (size_type k = 0; k < size; ++k) {
+          bf16_[k] = sdca_float_to_bfloat16(static_cast<float>(features[k]));
+        }
+        break;
+    }
+  }
+
+
+  quantized_feature_input<Data> input() const {
+    return quantized_feature_input<Data>(num_dimensions_, num_examples_,
+      type_, values(),
+      example_scales_.empty() ? nullptr : example_scales_.data(),
+      feature_scales_.empty() ? nullptr : feature_scales_.data());
+  }
+
+
+  // The size of the values and the scales in bytes
+  size_type num_bytes() const {
+    return int8_.size() * sizeof(std::int8_t) +
+      fp16_.size() * sizeof(sdca_half) +
+      bf16_.size() * sizeof(sdca_bfloat16) +
+      (example_scales_.size() + feature_scales_.size()) * sizeof(Data);
+  }
+
+
+  inline std::string
+  to_string() const {
+    std::ostringstream str;
+    str << "quantized_features (type: " << quantization_type_name(type_);
+    if (type_ == quantization_type::int8) {
+      str << ", scale: " << quantization_scale_name(scale_);
+    }
+    str << ", num_bytes: " << num_bytes() << ")";
+    return str.str();
+  }
+
+private:
+  size_type num_dimensions_;
+  size_type num_examples_;
+  quantization_type type_;
+  quantization_scale scale_;
+  std::vector<std::int8_t> int8_;
+  std::vector<sdca_half> fp16_;
+  std::vector<sdca_bfloat16> bf16_;
+  std::vector<Data> example_scales_;
+  std::vector<Data> feature_scales_;
+
+
+  const void* values() const {
+    switch (type_) {
+      case quantization_type::int8:
+        return int8_.data();
+      case quantization_type::fp16:
+        return fp16_.data();
+      case quantization_type::bf16:
+        return bf16_.data();
+    }
+    return nullptr;
+  }
+
+
+  void quantize_int8(
+      const Data* features
+    ) {
+    const size_type d = num_dimensions_, n = num_examples_;
+    std::vector<Data>& scales = (scale_ == quantization_scale::per_example)
+      ? example_scales_ : feature_scales_;
+    scales.assign((scale_ == quantization_scale::per_example) ? n : d, 0);
+    for (size_type i = 0; i < n; ++i) {
+      for (size_type k = 0; k < d; ++k) {
+        Data& s = scales[(scale_ == quantization_scale::per_example) ? i : k];
+        s = std::max(s, std::abs(features[d * i + k]));
+      }
+    }
+    for (auto& s : scales) {
+      s = (s > 0) ? s / 127 : static_cast<Data>(1);
+    }
+
+    int8_.resize(d * n);
+    for (size_type i = 0; i < n; ++i) {
+      for (size_type k = 0; k < d; ++k) {
+        const Data s = scales[(scale_ == quantization_scale::per_example)
+                              ? i : k];
+        const Data q = std::round(features[d * i + k] / s);
+        int8_[d * i + k] = static_cast<std::int8_t>(
+          std::max(static_cast<Data>(-127), std::min(q, static_cast<Data>(127))));
+      }
+    }
+  }
+};
+
+}
+
+#endif
@@ -0,0 +1,113 @@
+#ifndef SDCA_SOLVER_DATA_RANDOM_FEATURES_H
+#define SDCA_SOLVER_DATA_RANDOM_FEATURES_H
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <sstream>
+#include <vector>
+
+#include "sdca/math/blas.h"
+#include "sdca/utility/types.h"
+
+namespace sdca {
+
+/**
+ * Random Fourier features [1] that approximate the rbf kernel
+ *    k(x, y) = exp(-gamma ||x - y||^2) ~ z(x)' z(y),
+ *    z(x) = sqrt(2 / D) cos(Omega' x + b),
+ * where the columns of the num_input_dimensions-by-num_dimensions (D)
+ * matrix Omega are drawn from N(0, 2 gamma I) and b from U[0, 2 pi).
+ * The same seed always gives the same features, so that the model trained
+ * on z(x) can be applied to new examples with transform().
+ *
+ * [1] Rahimi A, Recht B.
+ *     Random features for large-scale kernel machines.
+ *     NIPS 2007.
+ **/
+template <typename Data>
+class random_fourier_features {
+public:
+  typedef Data data_type;
+
+
+  random_fourier_features(
+      const size_type num_input_dimensions,
+      const size_type num_dimensions,
+      const double gamma,
+      const unsigned seed = 1
+    ) :
+      num_input_dimensions_(num_input_dimensions),
+      num_dimensions_(num_dimensions),
+      gamma_(gamma),
+      seed_(seed),
+      omega_(num_input_dimensions * num_dimensions),
+      offsets_(num_dimensions)
+  {
+    std::mt19937 gen(seed);
+    std::normal_distribution<double> normal(0, std::sqrt(2 * gamma));
+    std::uniform_real_distribution<double> uniform(0, 2 * std::acos(-1.0));
+    for (auto& w : omega_) {
+      w = static_cast<Data>(normal(gen));
+    }
+    for (auto& b : offsets_) {
+      b = static_cast<Data>(uniform(gen));
+    }
+  }
+
+
+  size_type num_input_dimensions() const { return num_input_dimensions_; }
+
+  size_type num_dimensions() const { return num_dimensions_; }
+
+
+  /**
+   * Computes the features Z = z(X) (num_dimensions-by-num_examples)
+   * of the raw features X (num_input_dimensions-by-num_examples),
+   * both in column-major order.
+   **/
+  void transform(
+      const size_type num_examples,
+      const Data* X,
+      Data* Z
+    ) const {
+    // Let Z = Omega' * X (one gemm for the whole block)
+    const blas_int D_in = static_cast<blas_int>(num_input_dimensions_);
+    sdca_blas_gemm(static_cast<blas_int>(num_dimensions_),
+                   static_cast<blas_int>(num_examples), D_in,
+                   &omega_[0], D_in, X, D_in, Z, CblasTrans);
+
+    const Data scale = static_cast<Data>(
+      std::sqrt(2 / static_cast<double>(num_dimensions_)));
+    const Data* b = &offsets_[0];
+    for (size_type i = 0; i < num_examples; ++i, Z += num_dimensions_) {
+      for (size_type k = 0; k < num_dimensions_; ++k) {
+        Z[k] = scale * std::cos(Z[k] + b[k]);
+      }
+    }
+  }
+
+
+  inline std::string
+  to_string() const {
+    std::ostringstream str;
+    str << "random_fourier_features (num_input_dimensions: " <<
+           num_input_dimensions_ <<
+           ", num_dimensions: " << num_dimensions_ <<
+           ", gamma: " << gamma_ <<
+           ", seed: " << seed_ << ")";
+    return str.str();
+  }
+
+private:
+  size_type num_input_dimensions_;
+  size_type num_dimensions_;
+  double gamma_;
+  unsigned seed_;
+  std::vector<Data> omega_;
+  std::vector<Data> offsets_;
+};
+
+}
+
+#endif
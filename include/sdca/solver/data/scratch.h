@@ -1,6 +1,7 @@
 #ifndef SDCA_SOLVER_SCRATCH_H
 #define SDCA_SOLVER_SCRATCH_H
 
+#include <algorithm>
 #include <vector>
 
 #include "sdca/math/blas.h"
@@ -13,50 +14,177 @@ template <typename Data,
 struct solver_scratch {};
 
 
-template <typename Data>
-struct solver_scratch<Data, feature_input> {
+/*
+ * The scratch of the dense primal inputs, which provide the features
+ * a block at a time as in.features_block (see feature_input).
+ * The features of the inputs that generate them on the fly
+ * (e.g. fourier_feature_input) are generated into features.
+ */
+template <typename Data,
+          template <typename> class Input>
+struct dense_solver_scratch {
   typedef Data data_type;
-  typedef feature_input<Data> input_type;
+  typedef Input<Data> input_type;
 
   std::vector<data_type> norms;
   std::vector<data_type> scores;
   std::vector<data_type> variables;
+  std::vector<data_type> features; // x_i of the current example (if needed)
 
 
   template <typename Dataset>
-  void init(const Dataset& d) {
+  void init(
+      const Dataset& d,
+      const size_type block_size
+    ) {
     auto n = d.num_examples();
     norms.resize(n);
 
     scores.resize(d.num_classes());
     variables.resize(d.num_classes());
 
-    const auto dim = d.num_dimensions();
+    // The norms are computed a block of examples at a time
+    const size_type dim = d.num_dimensions();
+    const size_type block = std::max(static_cast<size_type>(1), block_size);
     const blas_int D = static_cast<blas_int>(dim);
-    const Data* features = d.in.features;
+    for (size_type first = 0; first < n; first += block) {
+      const size_type last = std::min(first + block, n);
+      const Data* X = d.in.features_block(first, last, features);
+      for (size_type i = first; i < last; ++i, X += dim) {
+        norms[i] = sdca_blas_dot(D, X, X);
+      }
+    }
+  }
+};
+
+
+template <typename Data>
+struct solver_scratch<Data, feature_input>
+    : dense_solver_scratch<Data, feature_input> {
+
+  // Mini-batch buffers (allocated on first use, see update_variables_batch)
+  std::vector<Data> batch_features; // num_dimensions-by-batch_size
+  std::vector<Data> batch_scores; // num_classes-by-batch_size
+  std::vector<Data> batch_variables; // num_classes-by-batch_size
+  std::vector<Data> batch_gram; // batch_size-by-batch_size
+  std::vector<Data> batch_norms; // batch_size
+};
+
+
+template <typename Data>
+struct solver_scratch<Data, sparse_feature_input> {
+  typedef Data data_type;
+  typedef sparse_feature_input<Data> input_type;
+
+  std::vector<data_type> norms;
+  std::vector<data_type> scores;
+  std::vector<data_type> variables;
+
+
+  template <typename Dataset>
+  void init(
+      const Dataset& d,
+      const size_type
+    ) {
+    auto n = d.num_examples();
+    norms.resize(n);
+
+    scores.resize(d.num_classes());
+    variables.resize(d.num_classes());
+
+    const size_type* offsets = d.in.offsets;
+    const Data* values = d.in.values;
     for (size_type i = 0; i < n; ++i) {
-      const Data* x_i = features + dim * i;
-      norms[i] = sdca_blas_dot(D, x_i, x_i);
+      Data norm2(0);
+      for (size_type k = offsets[i]; k < offsets[i + 1]; ++k) {
+        norm2 += values[k] * values[k];
+      }
+      norms[i] = norm2;
     }
   }
 };
 
 
+/*
+ * The norms of the quantized features are computed while they are
+ * dequantized (see quantized_feature_input::norm2), without a buffer;
+ * the updates dequantize x_i once into features.
+ */
 template <typename Data>
-struct solver_scratch<Data, kernel_input> {
+struct solver_scratch<Data, quantized_feature_input>
+    : dense_solver_scratch<Data, quantized_feature_input> {
+
+  template <typename Dataset>
+  void init(
+      const Dataset& d,
+      const size_type
+    ) {
+    auto n = d.num_examples();
+    this->norms.resize(n);
+
+    this->scores.resize(d.num_classes());
+    this->variables.resize(d.num_classes());
+
+    for (size_type i = 0; i < n; ++i) {
+      this->norms[i] = d.in.norm2(i);
+    }
+  }
+};
+
+
+template <typename Data>
+struct solver_scratch<Data, fourier_feature_input>
+    : dense_solver_scratch<Data, fourier_feature_input> {};
+
+
+/*
+ * The scratch of the kernel inputs, which provide the diagonal of the
+ * kernel matrix as in.diagonal(i): norms[i] = in.diagonal(i), and the
+ * scores and variables of the current example.
+ */
+template <typename Data,
+          template <typename> class Input>
+struct kernel_solver_scratch {
   typedef Data data_type;
-  typedef kernel_input<Data> input_type;
+  typedef Input<Data> input_type;
 
+  std::vector<data_type> norms; // the diagonal of the kernel matrix
   std::vector<data_type> scores;
+  std::vector<data_type> variables;
 
 
   template <typename Dataset>
-  void init(const Dataset& d) {
+  void init(
+      const Dataset& d,
+      const size_type
+    ) {
+    auto n = d.num_examples();
+    norms.resize(n);
+    for (size_type i = 0; i < n; ++i) {
+      norms[i] = d.in.diagonal(i);
+    }
+
     scores.resize(d.num_classes());
+    variables.resize(d.num_classes());
   }
 };
 
 
+template <typename Data>
+struct solver_scratch<Data, kernel_input>
+    : kernel_solver_scratch<Data, kernel_input> {};
+
+
+template <typename Data>
+struct solver_scratch<Data, packed_kernel_input>
+    : kernel_solver_scratch<Data, packed_kernel_input> {};
+
+
+template <typename Data>
+struct solver_scratch<Data, kernel_function_input>
+    : kernel_solver_scratch<Data, kernel_function_input> {};
+
+
 template <typename Data>
 struct solver_scratch<Data, model_input> {
   typedef Data data_type;
@@ -69,7 +197,10 @@ struct solver_scratch<Data, model_input> {
 
 
   template <typename Dataset>
-  void init(const Dataset& d) {
+  void init(
+      const Dataset& d,
+      const size_type
+    ) {
     auto dim = d.num_dimensions();
     auto m = d.num_classes();
     scores.resize(m);
@@ -1,6 +1,9 @@
 #ifndef SDCA_SOLVER_EVAL_H
 #define SDCA_SOLVER_EVAL_H
 
+#include <algorithm>
+#include <vector>
+
 #include "sdca/solver/data/scratch.h"
 #include "sdca/solver/eval/core.h"
 #include "sdca/solver/eval/dual.h"
@@ -9,44 +12,108 @@
 #include "sdca/solver/eval/scores.h"
 #include "sdca/solver/eval/types.h"
 #include "sdca/solver/reporting.h"
+#include "sdca/utility/parallel.h"
 
 namespace sdca {
 
 template <typename Data,
-          template <typename> class Input,
           typename Dataset,
-          typename Context>
+          typename Context,
+          typename Evaluation>
 inline void
-evaluate_dataset(
+evaluate_examples(
+    const size_type first,
+    const size_type last,
+    const size_type block_size,
     const Context& ctx,
-    Dataset& d,
-    solver_scratch<Data, Input>& scratch,
-    size_type id = 0
+    const Dataset& d,
+    Data* scores,
+    Data* variables,
+    Evaluation& eval
   ) {
   const size_type m = d.num_classes();
-  const size_type n = d.num_examples();
+  const blas_int M = static_cast<blas_int>(m);
+  for (size_type begin = first; begin < last; begin += block_size) {
+    // Score a block of examples at once (m-by-block_size)
+    const size_type end = std::min(begin + block_size, last);
+    eval_scores_block(begin, end, m, d.in, ctx, scores);
 
-  auto& eval = eval_begin(d);
+    Data* scores_i = scores;
+    for (size_type i = begin; i < end; ++i, scores_i += m) {
+      // Evaluate on a copy of the dual variables, since they are re-ordered
+      // in place and may be concurrently read by other threads (kernels)
+      sdca_blas_copy(M, ctx.dual_variables + m * i, variables);
 
-  eval_recompute_primal(m, n, d, ctx);
-  eval_regularizer_primal(m, d.in, ctx, eval);
+      eval_regularizer_dual(m, d.in, ctx.objective, variables, scores_i, eval);
 
-  assert(m == scratch.scores.size());
-  Data* scores = &scratch.scores[0];
-  for (size_type i = 0; i < n; ++i) {
-    Data* variables = ctx.dual_variables + m * i;
+      eval_dual_loss(i, d.out, ctx.objective, variables, eval);
 
-    eval_scores(i, m, d.in, ctx, scores);
+      eval_primal_loss(i, d.out, ctx.objective, scores_i, eval);
 
-    eval_regularizer_dual(m, d.in, ctx.objective, variables, scores, eval);
+    }
+  }
+}
 
-    eval_dual_loss(i, d.out, ctx.objective, variables, eval);
 
-    eval_primal_loss(i, d.out, ctx.objective, scores, eval);
+/**
+ * Computes a new evaluation of the dataset using num_threads threads.
+ * Every thread accumulates the losses over a contiguous block of examples
+ * into its own eval; the partial evals are then merged in the block order,
+ * so the result only depends on the number of threads.
+ **/
+template <typename Dataset,
+          typename Context>
+inline typename Dataset::eval_type&
+compute_evaluation(
+    const Context& ctx,
+    Dataset& d,
+    const size_type num_threads
+  ) {
+  typedef typename Context::data_type Data;
+  const size_type m = d.num_classes();
+  const size_type n = d.num_examples();
 
+  auto& eval = eval_begin(d);
+  const size_type num_blocks = std::max(static_cast<size_type>(1),
+                                        std::min(num_threads, n));
+  std::vector<typename Dataset::eval_type> partial(num_blocks - 1, eval);
+
+  eval_recompute_primal(m, n, d, ctx);
+  eval_regularizer_primal(m, d.in, ctx, eval);
+
+  const size_type block_size = std::max(static_cast<size_type>(1),
+                                        ctx.options.eval_block_size);
+  parallel_for(num_blocks, 0, n,
+    [&](const size_type t, const size_type first, const size_type last) {
+      std::vector<Data> scores(m * block_size);
+      std::vector<Data> variables(m);
+      evaluate_examples(first, last, block_size, ctx, d,
+                        &scores[0], &variables[0],
+                        (t > 0) ? partial[t - 1] : eval);
+    });
+
+  for (const auto& e : partial) {
+    eval_merge(e, eval);
   }
 
   eval_end(m, n, ctx, eval);
+  return eval;
+}
+
+
+template <typename Data,
+          template <typename> class Input,
+          typename Dataset,
+          typename Context>
+inline void
+evaluate_dataset(
+    const Context& ctx,
+    Dataset& d,
+    solver_scratch<Data, Input>&,
+    size_type id = 0
+  ) {
+  auto& eval = compute_evaluation(ctx, d,
+    resolve_num_threads(ctx.options.num_threads));
   reporting::eval_created(eval, id);
 }
 
@@ -56,7 +123,8 @@ template <typename Data,
           typename Context>
 inline void
 check_stopping_criteria(
-    Context& ctx
+    Context& ctx,
+    const bool check_progress = true
   ) {
   // Nothing to check if the solver is not running
   if (ctx.status != solver_status::solving) return;
@@ -83,7 +151,7 @@ check_stopping_criteria(
       } else {
         ctx.status = solver_status::solved;
       }
-    } else if (evals.size() > 1) {
+    } else if (check_progress && evals.size() > 1) {
       // Check if the solver is making progress
       const auto& before = evals.rbegin()[1];
       if (eval.dual + eps * std::abs(before.dual) < before.dual) {
@@ -1,9 +1,13 @@
 #ifndef SDCA_SOLVER_EVAL_CORE_H
 #define SDCA_SOLVER_EVAL_CORE_H
 
+#include <algorithm>
+#include <functional>
 #include <numeric>
+#include <vector>
 
 #include "sdca/math/blas.h"
+#include "sdca/math/sparse.h"
 #include "sdca/solver/data.h"
 
 namespace sdca {
@@ -40,6 +44,66 @@ eval_begin(
 }
 
 
+template <typename Result>
+inline void
+eval_merge_base(
+    const eval_train_base<Result>& src,
+    eval_train_base<Result>& dst
+  ) {
+  dst.primal_loss += src.primal_loss;
+  dst.dual_loss += src.dual_loss;
+  dst.primal_regularizer += src.primal_regularizer;
+  dst.dual_regularizer += src.dual_regularizer;
+}
+
+
+template <typename Result>
+inline void
+eval_merge(
+    const eval_train<Result, multiclass_output>& src,
+    eval_train<Result, multiclass_output>& dst
+  ) {
+  // Merge the accumulated values (before eval_end normalizes them)
+  eval_merge_base(src, dst);
+  std::transform(src.accuracy.begin(), src.accuracy.end(),
+    dst.accuracy.begin(), dst.accuracy.begin(), std::plus<Result>());
+}
+
+
+template <typename Result>
+inline void
+eval_merge(
+    const eval_train<Result, multilabel_output>& src,
+    eval_train<Result, multilabel_output>& dst
+  ) {
+  eval_merge_base(src, dst);
+  dst.rank_loss += src.rank_loss;
+}
+
+
+template <typename Result>
+inline void
+eval_merge(
+    const eval_test<Result, multiclass_output>& src,
+    eval_test<Result, multiclass_output>& dst
+  ) {
+  dst.primal_loss += src.primal_loss;
+  std::transform(src.accuracy.begin(), src.accuracy.end(),
+    dst.accuracy.begin(), dst.accuracy.begin(), std::plus<Result>());
+}
+
+
+template <typename Result>
+inline void
+eval_merge(
+    const eval_test<Result, multilabel_output>& src,
+    eval_test<Result, multilabel_output>& dst
+  ) {
+  dst.primal_loss += src.primal_loss;
+  dst.rank_loss += src.rank_loss;
+}
+
+
 template <typename Int,
           typename Result,
           typename Context>
@@ -132,6 +196,105 @@ eval_end(
 }
 
 
+template <typename Int,
+          typename Dataset,
+          typename Context>
+inline void
+recompute_primal_variables(
+    const Int,
+    const Int,
+    const Dataset&,
+    const Context&,
+    std::false_type
+  ) {
+}
+
+
+template <typename Int,
+          typename Dataset,
+          typename Context>
+inline void
+recompute_primal_variables(
+    const Int num_classes,
+    const Int num_examples,
+    const Dataset& d,
+    const Context& ctx,
+    std::true_type
+  ) {
+  // Let W = W0 + X * A', where the features X are taken a block at a time
+  // (generated for the block if they are not stored, see features_block)
+  typedef typename Context::data_type Data;
+  const size_type dim = d.num_dimensions();
+  const size_type block_size = std::max(static_cast<size_type>(1),
+                                        ctx.options.eval_block_size);
+  const blas_int D = static_cast<blas_int>(dim);
+  const blas_int M = static_cast<blas_int>(num_classes);
+  if (ctx.is_prox()) {
+    sdca_blas_copy(D * M, ctx.primal_initial, ctx.primal_variables);
+  } else {
+    std::fill_n(ctx.primal_variables, dim * num_classes, static_cast<Data>(0));
+  }
+  std::vector<Data> buffer;
+  for (size_type first = 0; first < num_examples; first += block_size) {
+    const size_type last = std::min(first + block_size,
+                                    static_cast<size_type>(num_examples));
+    const Data* X = d.in.features_block(first, last, buffer);
+    sdca_blas_gemm(D, M, static_cast<blas_int>(last - first), X, D,
+      ctx.dual_variables + num_classes * first, M, ctx.primal_variables,
+      CblasNoTrans, CblasTrans, 1, 1);
+  }
+}
+
+
+/**
+ * Recomputes the primal variables W from the dual ones
+ * (no-op for the inputs without the primal variables, e.g. the kernels).
+ **/
+template <typename Int,
+          typename Dataset,
+          typename Context>
+inline void
+recompute_primal_variables(
+    const Int num_classes,
+    const Int num_examples,
+    const Dataset& d,
+    const Context& ctx
+  ) {
+  recompute_primal_variables(num_classes, num_examples, d, ctx,
+    is_primal_input<typename Dataset::input_type>());
+}
+
+
+template <typename Int,
+          typename Data,
+          typename Output,
+          typename Evaluation,
+          typename Context>
+inline void
+recompute_primal_variables(
+    const Int num_classes,
+    const Int num_examples,
+    const dataset<sparse_feature_input<Data>, Output, Evaluation>& d,
+    const Context& ctx
+  ) {
+  // Let W = W0 + X * A' (one sparse rank-1 update per example)
+  const size_type dim = d.num_dimensions();
+  const auto& in = d.in;
+  if (ctx.is_prox()) {
+    sdca_blas_copy(static_cast<blas_int>(dim * num_classes),
+      ctx.primal_initial, ctx.primal_variables);
+  } else {
+    std::fill_n(ctx.primal_variables, dim * num_classes, static_cast<Data>(0));
+  }
+  for (Int i = 0; i < num_examples; ++i) {
+    const size_type first = in.offsets[i];
+    sdca_sparse_ger(dim, num_classes, static_cast<Data>(1),
+      in.offsets[i + 1] - first, in.values + first, in.indices + first,
+      ctx.dual_variables + num_classes * i, ctx.primal_variables);
+  }
+}
+
+
 template <typename Int,
           typename Dataset,
           typename Context>
@@ -146,7 +309,7 @@ eval_recompute_primal(
 
 
 template <typename Int,
-          typename Data,
+          typename Input,
           typename Result,
           typename Output,
           typename Context>
@@ -155,27 +318,16 @@ eval_recompute_primal(
 #ifdef SDCA_ACCURATE_MATH
     const Int num_classes,
     const Int num_examples,
-    const dataset<feature_input<Data>, Output, eval_train<Result, Output>>& d,
+    const dataset<Input, Output, eval_train<Result, Output>>& d,
     const Context& ctx
   ) {
-  // Let W = W0 + X * A'
-  // (recompute W to minimize the accumulated numerical error)
+  // Recompute W to minimize the accumulated numerical error
   // NOTE: this should be done (if at all) for the training dataset only!
-  auto D = static_cast<blas_int>(d.num_dimensions());
-  auto M = static_cast<blas_int>(num_classes);
-  auto N = static_cast<blas_int>(num_examples);
-  if (ctx.is_prox()) {
-    sdca_blas_copy(D * M, ctx.primal_initial, ctx.primal_variables);
-    sdca_blas_gemm(D, M, N, d.in.features, D, ctx.dual_variables, M,
-      ctx.primal_variables, CblasNoTrans, CblasTrans, 1, 1);
-  } else {
-    sdca_blas_gemm(D, M, N, d.in.features, D, ctx.dual_variables, M,
-      ctx.primal_variables, CblasNoTrans, CblasTrans);
-  }
+  recompute_primal_variables(num_classes, num_examples, d, ctx);
 #else
     const Int,
     const Int,
-    const dataset<feature_input<Data>, Output, eval_train<Result, Output>>&,
+    const dataset<Input, Output, eval_train<Result, Output>>&,
     const Context&
   ) {
 #endif
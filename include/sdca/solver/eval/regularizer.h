@@ -20,25 +20,29 @@ eval_regularizer_primal(
 
 
 template <typename Int,
-          typename Data,
+          typename Input,
           typename Result,
           typename Output,
           typename Context>
 inline void
 eval_regularizer_primal(
     const Int num_classes,
-    const feature_input<Data>& in,
+    const Input& in,
     const Context& ctx,
     eval_train<Result, Output>& eval
   ) {
+  // The regularizer of the kernels is computed from the dual variables
+  // (see eval_regularizer_dual)
+  const size_type size = primal_dimensions(in) * num_classes;
+  if (size == 0) return;
   if (ctx.is_prox()) {
     ctx.objective.regularizers_primal(
-      in.num_dimensions * num_classes,
+      size,
       ctx.primal_variables, ctx.primal_initial,
       eval.primal_regularizer, eval.dual_regularizer);
   } else {
     ctx.objective.regularizers_primal(
-      in.num_dimensions * num_classes, ctx.primal_variables,
+      size, ctx.primal_variables,
       eval.primal_regularizer, eval.dual_regularizer);
   }
 }
@@ -97,6 +101,44 @@ eval_regularizer_dual(
                         eval.primal_regularizer, eval.dual_regularizer);
 }
 
+
+template <typename Int,
+          typename Data,
+          typename Result,
+          typename Output,
+          template <typename, typename> class Objective>
+inline void
+eval_regularizer_dual(
+    const Int num_classes,
+    const packed_kernel_input<Data>&,
+    const Objective<Data, Result>& obj,
+    const Data* dual_variables,
+    const Data* scores,
+    eval_train<Result, Output>& eval
+  ) {
+  obj.regularizers_dual(num_classes, dual_variables, scores,
+                        eval.primal_regularizer, eval.dual_regularizer);
+}
+
+
+template <typename Int,
+          typename Data,
+          typename Result,
+          typename Output,
+          template <typename, typename> class Objective>
+inline void
+eval_regularizer_dual(
+    const Int num_classes,
+    const kernel_function_input<Data>&,
+    const Objective<Data, Result>& obj,
+    const Data* dual_variables,
+    const Data* scores,
+    eval_train<Result, Output>& eval
+  ) {
+  obj.regularizers_dual(num_classes, dual_variables, scores,
+                        eval.primal_regularizer, eval.dual_regularizer);
+}
+
 }
 
 #endif
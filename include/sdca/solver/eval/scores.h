@@ -1,7 +1,10 @@
 #ifndef SDCA_SOLVER_EVAL_SCORES_H
 #define SDCA_SOLVER_EVAL_SCORES_H
 
+#include <vector>
+
 #include "sdca/math/blas.h"
+#include "sdca/math/sparse.h"
 #include "sdca/solver/data/input.h"
 
 namespace sdca {
@@ -27,6 +30,25 @@ eval_scores(
 }
 
 
+template <typename Int,
+          typename Data,
+          typename Context>
+inline void
+eval_scores(
+    const Int i,
+    const Int num_classes,
+    const sparse_feature_input<Data>& in,
+    const Context& ctx,
+    Data* scores
+  ) {
+  // Let scores = W' * x_i (a gather-dot per class)
+  const size_type first = in.offsets[i];
+  sdca_sparse_gemv(in.num_dimensions, num_classes, ctx.primal_variables,
+                   in.offsets[i + 1] - first, in.values + first,
+                   in.indices + first, scores);
+}
+
+
 template <typename Int,
           typename Data,
           typename Context>
@@ -47,6 +69,52 @@ eval_scores(
 }
 
 
+template <typename Int,
+          typename Data,
+          typename Context>
+inline void
+eval_scores(
+    const Int i,
+    const Int num_classes,
+    const packed_kernel_input<Data>& in,
+    const Context& ctx,
+    Data* scores
+  ) {
+  // Let scores = A * K_i, where K_i is read from the packed lower panels
+  if (in.is_packed) {
+    sdca_packed_gemv(num_classes, in.num_train_examples, ctx.dual_variables,
+                     in.kernel, i, scores);
+  } else {
+    sdca_blas_gemv(static_cast<blas_int>(num_classes),
+                   static_cast<blas_int>(in.num_train_examples),
+                   ctx.dual_variables,
+                   in.kernel + in.num_train_examples * i,
+                   scores);
+  }
+}
+
+
+template <typename Int,
+          typename Data,
+          typename Context>
+inline void
+eval_scores(
+    const Int i,
+    const Int num_classes,
+    const kernel_function_input<Data>& in,
+    const Context& ctx,
+    Data* scores
+  ) {
+  // Let scores = A * K_i, where K_i is computed or taken from the cache
+  const auto column = in.column(i);
+  sdca_blas_gemv(static_cast<blas_int>(num_classes),
+                 static_cast<blas_int>(in.num_train_examples),
+                 ctx.dual_variables,
+                 column->data(),
+                 scores);
+}
+
+
 template <typename Int,
           typename Data,
           typename Context>
@@ -67,6 +135,120 @@ eval_scores(
                  CblasTrans);
 }
 
+
+/**
+ * Computes the scores of the examples in [first, last) and stores them
+ * column-wise in the m-by-(last - first) matrix scores.
+ * By default, every example is scored separately.
+ **/
+template <typename Int,
+          typename Input,
+          typename Context,
+          typename Data>
+inline void
+eval_scores_block(
+    const Int first,
+    const Int last,
+    const Int num_classes,
+    const Input& in,
+    const Context& ctx,
+    Data* scores
+  ) {
+  for (Int i = first; i < last; ++i, scores += num_classes) {
+    eval_scores(i, num_classes, in, ctx, scores);
+  }
+}
+
+
+template <typename Int,
+          typename Data,
+          typename Context>
+inline void
+eval_scores_block(
+    const Int first,
+    const Int last,
+    const Int num_classes,
+    const feature_input<Data>& in,
+    const Context& ctx,
+    Data* scores
+  ) {
+  // Let scores = W' * X_B, where X_B are the columns [first, last) of X
+  const blas_int D = static_cast<blas_int>(in.num_dimensions);
+  sdca_blas_gemm(static_cast<blas_int>(num_classes),
+                 static_cast<blas_int>(last - first), D,
+                 ctx.primal_variables, D,
+                 in.features + in.num_dimensions * first, D,
+                 scores, CblasTrans);
+}
+
+
+template <typename Int,
+          typename Data,
+          typename Context>
+inline void
+eval_scores_block(
+    const Int first,
+    const Int last,
+    const Int num_classes,
+    const fourier_feature_input<Data>& in,
+    const Context& ctx,
+    Data* scores
+  ) {
+  // Let scores = W' * Z_B, where Z_B = z(X_B) is generated for the block
+  const blas_int D = static_cast<blas_int>(in.num_dimensions);
+  std::vector<Data> Z(in.num_dimensions * (last - first));
+  in.transform_block(first, last, &Z[0]);
+  sdca_blas_gemm(static_cast<blas_int>(num_classes),
+                 static_cast<blas_int>(last - first), D,
+                 ctx.primal_variables, D, &Z[0], D,
+                 scores, CblasTrans);
+}
+
+
+template <typename Int,
+          typename Data,
+          typename Context>
+inline void
+eval_scores_block(
+    const Int first,
+    const Int last,
+    const Int num_classes,
+    const quantized_feature_input<Data>& in,
+    const Context& ctx,
+    Data* scores
+  ) {
+  // Let scores = W' * X_B, where X_B is dequantized for the block
+  const blas_int D = static_cast<blas_int>(in.num_dimensions);
+  std::vector<Data> X(in.num_dimensions * (last - first));
+  in.dequantize(first, last, &X[0]);
+  sdca_blas_gemm(static_cast<blas_int>(num_classes),
+                 static_cast<blas_int>(last - first), D,
+                 ctx.primal_variables, D, &X[0], D,
+                 scores, CblasTrans);
+}
+
+
+template <typename Int,
+          typename Data,
+          typename Context>
+inline void
+eval_scores_block(
+    const Int first,
+    const Int last,
+    const Int num_classes,
+    const kernel_input<Data>& in,
+    const Context& ctx,
+    Data* scores
+  ) {
+  // Let scores = A * K_B = W' * X_B
+  const blas_int M = static_cast<blas_int>(num_classes);
+  const blas_int N = static_cast<blas_int>(in.num_train_examples);
+  sdca_blas_gemm(M, static_cast<blas_int>(last - first), N,
+                 ctx.dual_variables, M,
+                 in.kernel + in.num_train_examples * first, N,
+                 scores);
+}
+
 }
 
 #endif
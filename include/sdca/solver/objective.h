@@ -159,6 +159,149 @@ make_objective_l2_multilabel_hinge_smooth(
   return l2_multilabel_hinge_smooth<Data, Result>(c, gamma);
 }
 
+
+/*
+ * Returns a copy of the objective with the loss scaled by factor,
+ * i.e. with the parameter c replaced by factor * c.
+ * The feasible sets of the dual variables are scaled by the same factor.
+ */
+template <typename Data,
+          typename Result>
+inline l2_entropy<Data, Result>
+scale_objective(
+    const l2_entropy<Data, Result>& obj,
+    const Result factor
+  ) {
+  return l2_entropy<Data, Result>(factor * obj.c);
+}
+
+
+template <typename Data,
+          typename Result>
+inline l2_entropy_topk<Data, Result>
+scale_objective(
+    const l2_entropy_topk<Data, Result>& obj,
+    const Result factor
+  ) {
+  return l2_entropy_topk<Data, Result>(factor * obj.c, obj.k);
+}
+
+
+template <typename Data,
+          typename Result>
+inline l2_hinge_topk<Data, Result>
+scale_objective(
+    const l2_hinge_topk<Data, Result>& obj,
+    const Result factor
+  ) {
+  return l2_hinge_topk<Data, Result>(factor * obj.c, obj.k);
+}
+
+
+template <typename Data,
+          typename Result>
+inline l2_hinge_topk_smooth<Data, Result>
+scale_objective(
+    const l2_hinge_topk_smooth<Data, Result>& obj,
+    const Result factor
+  ) {
+  return l2_hinge_topk_smooth<Data, Result>(factor * obj.c, obj.gamma, obj.k);
+}
+
+
+template <typename Data,
+          typename Result>
+inline l2_topk_hinge<Data, Result>
+scale_objective(
+    const l2_topk_hinge<Data, Result>& obj,
+    const Result factor
+  ) {
+  return l2_topk_hinge<Data, Result>(factor * obj.c, obj.k);
+}
+
+
+template <typename Data,
+          typename Result>
+inline l2_topk_hinge_smooth<Data, Result>
+scale_objective(
+    const l2_topk_hinge_smooth<Data, Result>& obj,
+    const Result factor
+  ) {
+  return l2_topk_hinge_smooth<Data, Result>(factor * obj.c, obj.gamma, obj.k);
+}
+
+
+template <typename Data,
+          typename Result>
+inline l2_multilabel_entropy<Data, Result>
+scale_objective(
+    const l2_multilabel_entropy<Data, Result>& obj,
+    const Result factor
+  ) {
+  return l2_multilabel_entropy<Data, Result>(factor * obj.c);
+}
+
+
+template <typename Data,
+          typename Result>
+inline l2_multilabel_hinge<Data, Result>
+scale_objective(
+    const l2_multilabel_hinge<Data, Result>& obj,
+    const Result factor
+  ) {
+  return l2_multilabel_hinge<Data, Result>(factor * obj.c);
+}
+
+
+template <typename Data,
+          typename Result>
+inline l2_multilabel_hinge_smooth<Data, Result>
+scale_objective(
+    const l2_multilabel_hinge_smooth<Data, Result>& obj,
+    const Result factor
+  ) {
+  return l2_multilabel_hinge_smooth<Data, Result>(factor * obj.c, obj.gamma);
+}
+
+
+
+/*
+ * Returns a copy of the smooth objective with the parameter gamma replaced
+ * (see has_param_gamma); the feasible sets of the dual variables depend on
+ * c (and k) only, i.e. the dual variables stay feasible.
+ */
+template <typename Data,
+          typename Result>
+inline l2_hinge_topk_smooth<Data, Result>
+objective_with_gamma(
+    const l2_hinge_topk_smooth<Data, Result>& obj,
+    const Result gamma
+  ) {
+  return l2_hinge_topk_smooth<Data, Result>(obj.c, gamma, obj.k);
+}
+
+
+template <typename Data,
+          typename Result>
+inline l2_topk_hinge_smooth<Data, Result>
+objective_with_gamma(
+    const l2_topk_hinge_smooth<Data, Result>& obj,
+    const Result gamma
+  ) {
+  return l2_topk_hinge_smooth<Data, Result>(obj.c, gamma, obj.k);
+}
+
+
+template <typename Data,
+          typename Result>
+inline l2_multilabel_hinge_smooth<Data, Result>
+objective_with_gamma(
+    const l2_multilabel_hinge_smooth<Data, Result>& obj,
+    const Result gamma
+  ) {
+  return l2_multilabel_hinge_smooth<Data, Result>(obj.c, gamma);
+}
+
 }
 
 #endif
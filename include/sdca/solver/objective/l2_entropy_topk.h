@@ -101,8 +101,8 @@ struct l2_entropy_topk
       const Data* variables
     ) const {
     Result d_loss = c_log_c - x_log_x(c - static_cast<Result>(variables[0]));
-    std::for_each(variables + 1, variables + num_classes,
-      [&](const Result a){ d_loss -= x_log_x(-a); });
+    d_loss -= sum_x_log_x(variables + 1, variables + num_classes,
+                          static_cast<Result>(0), static_cast<Result>(-1));
     return d_loss;
   }
 
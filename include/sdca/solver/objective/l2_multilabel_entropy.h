@@ -95,12 +95,11 @@ struct l2_multilabel_entropy
     ) const {
     Result d_loss(0), p(static_cast<Result>(num_labels));
 
-    std::for_each(variables, variables + num_labels,
-      [&](const Result a){ d_loss -= x_log_x(c - p * a); });
+    d_loss -= sum_x_log_x(variables, variables + num_labels, c, -p);
     d_loss /= p;
 
-    std::for_each(variables + num_labels, variables + num_classes,
-      [&](const Result a){ d_loss -= x_log_x(-a); });
+    d_loss -= sum_x_log_x(variables + num_labels, variables + num_classes,
+                          static_cast<Result>(0), static_cast<Result>(-1));
 
     Result sum = std::accumulate(variables, variables + num_labels,
                                  static_cast<Result>(0));
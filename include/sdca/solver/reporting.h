@@ -2,6 +2,7 @@
 #define SDCA_SOLVER_REPORTING_H
 
 #include "sdca/solver/solverdef.h"
+#include "sdca/solver/data/input.h"
 #include "sdca/solver/eval/types.h"
 #include "sdca/utility/logging.h"
 
@@ -17,11 +18,38 @@ begin_solve(
 }
 
 
+template <typename Input>
+inline void
+input_stats(
+    const Input&,
+    const char*
+  ) {}
+
+
+template <typename Data>
+inline void
+input_stats(
+    const kernel_function_input<Data>& in,
+    const char* name
+  ) {
+  LOG_VERBOSE <<
+    "  " << name << " kernel cache: "
+    "capacity: " << in.cache->capacity() << ", "
+    "hits: " << in.cache->num_hits() << ", "
+    "misses: " << in.cache->num_misses() <<
+    std::endl;
+}
+
+
 template <typename Context>
 inline void
 end_solve(
     const Context& ctx
   ) {
+  input_stats(ctx.train.in, "train");
+  for (const auto& test_set : ctx.test) {
+    input_stats(test_set.in, "test");
+  }
   if (ctx.status == solver_status::solved) {
     LOG_INFO << "Solution: " << ctx.status_string() << std::endl;
   } else {
@@ -48,11 +76,122 @@ end_epoch(
     " + " << ctx.eval_time.cpu.elapsed << "), "
     "wall_time: " << ctx.wall_time() <<
     " (" << ctx.solve_time.wall.elapsed <<
-    " + " << ctx.eval_time.wall.elapsed << ")" <<
+    " + " << ctx.eval_time.wall.elapsed << "), "
+    "throughput: " << ctx.throughput() <<
+    std::endl;
+}
+
+
+template <typename Context>
+inline void
+shrink_examples(
+    const Context& ctx,
+    const size_type num_active
+  ) {
+  LOG_DEBUG <<
+    "  "
+    "epoch: " << ctx.epoch << ", "
+    "active_examples: " << num_active << " / " <<
+    ctx.train.num_examples() <<
+    std::endl;
+}
+
+
+template <typename Context,
+          typename Stats>
+inline void
+sample_examples(
+    const Context& ctx,
+    const Stats& stats
+  ) {
+  LOG_DEBUG <<
+    "  "
+    "epoch: " << ctx.epoch << ", "
+    "sampling: " << sampling_type_name(ctx.options.sampling) <<
+    " (" << stats.to_string() << ")" <<
+    std::endl;
+}
+
+
+template <typename Context,
+          typename Inner>
+inline void
+accelerate(
+    const Context& ctx,
+    const Inner& inner,
+    const size_type iteration,
+    const double kappa
+  ) {
+  LOG_VERBOSE <<
+    "  "
+    "accel_iteration: " << iteration << ", "
+    "accel_kappa: " << kappa << ", "
+    "epoch: " << ctx.epoch << ", "
+    "inner_epsilon: " << inner.criteria.epsilon << ", "
+    "inner_status: " << inner.status_name() <<
     std::endl;
 }
 
 
+template <typename Context>
+inline void
+checkpoint(
+    const Context& ctx
+  ) {
+  LOG_DEBUG <<
+    "  "
+    "epoch: " << ctx.epoch << ", "
+    "checkpoint: " << ctx.options.checkpoint_path <<
+    std::endl;
+}
+
+
+template <typename Context>
+inline void
+checkpoint_failed(
+    const Context& ctx
+  ) {
+  LOG_WARNING <<
+    "Warning: failed to write checkpoint; "
+    "path: " << ctx.options.checkpoint_path <<
+    std::endl;
+}
+
+
+template <typename Context>
+inline void
+resume(
+    const Context& ctx,
+    const std::string& path
+  ) {
+  LOG_INFO << "Resume: " << path << ", epoch: " << ctx.epoch << std::endl;
+}
+
+
+template <typename Context>
+inline void
+streaming(
+    const Context&,
+    const size_type num_chunks,
+    const size_type chunk_size
+  ) {
+  LOG_VERBOSE <<
+    "  "
+    "streaming: " << num_chunks << " chunks, "
+    "chunk_size: " << chunk_size <<
+    std::endl;
+}
+
+
+template <typename Point>
+inline void
+path_point(
+    const Point& point
+  ) {
+  LOG_INFO << "Path: " << point.to_string() << std::endl;
+}
+
+
 template <typename Result,
           typename Output>
 inline void
@@ -0,0 +1,198 @@
+#ifndef SDCA_SOLVER_SAMPLING_H
+#define SDCA_SOLVER_SAMPLING_H
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <random>
+#include <sstream>
+#include <vector>
+
+#include "sdca/solver/data/scratch.h"
+
+namespace sdca {
+
+/*
+ * Walker's alias method for sampling from a discrete distribution
+ * in O(1) per draw after an O(n) initialization (Vose's variant [1]).
+ *
+ * [1] Vose MD.
+ *     A linear algorithm for generating random numbers
+ *     with a given distribution.
+ *     IEEE Transactions on Software Engineering. 1991;17(9):972-975.
+ */
+class alias_table {
+public:
+  /**
+   * Builds the table for the probabilities proportional to the weights
+   * in [first, last); the distribution is uniform if all weights are 0.
+   **/
+  template <typename Iterator>
+  void init(
+      Iterator first,
+      Iterator last
+    ) {
+    const size_type n = static_cast<size_type>(std::distance(first, last));
+    prob_.assign(first, last);
+    alias_.resize(n);
+    std::iota(alias_.begin(), alias_.end(), 0);
+
+    double sum = std::accumulate(prob_.begin(), prob_.end(), 0.0);
+    if (!(sum > 0)) {
+      std::fill(prob_.begin(), prob_.end(), 1.0);
+      return;
+    }
+
+    // Scale the probabilities to the mean of 1 and pair the columns
+    // with p < 1 (small) with the columns with p >= 1 (large)
+    small_.clear();
+    large_.clear();
+    const double scale = static_cast<double>(n) / sum;
+    for (size_type i = 0; i < n; ++i) {
+      prob_[i] *= scale;
+      (prob_[i] < 1 ? small_ : large_).push_back(i);
+    }
+    while (!small_.empty() && !large_.empty()) {
+      size_type s = small_.back(), l = large_.back();
+      small_.pop_back();
+      alias_[s] = l;
+      prob_[l] -= 1 - prob_[s];
+      if (prob_[l] < 1) {
+        large_.pop_back();
+        small_.push_back(l);
+      }
+    }
+
+    // The remaining columns are full (up to the rounding errors)
+    for (size_type i : small_) prob_[i] = 1;
+    for (size_type i : large_) prob_[i] = 1;
+  }
+
+
+  template <typename Generator>
+  size_type operator()(
+      Generator& gen
+    ) const {
+    // Pick a column uniformly, then either the column or its alias
+    std::uniform_real_distribution<double> uniform(
+      0, static_cast<double>(prob_.size()));
+    double u = uniform(gen);
+    size_type k = std::min(static_cast<size_type>(u), prob_.size() - 1);
+    return (u - static_cast<double>(k) < prob_[k]) ? k : alias_[k];
+  }
+
+
+  inline size_type size() const { return prob_.size(); }
+
+private:
+  std::vector<double> prob_;
+  std::vector<size_type> alias_;
+  std::vector<size_type> small_;
+  std::vector<size_type> large_;
+};
+
+
+struct sampling_stats {
+  size_type num_draws = 0;
+  size_type num_distinct = 0;
+
+  // The largest probability of an example relative to the uniform one
+  double max_ratio = 0;
+
+
+  inline std::string
+  to_string() const {
+    std::ostringstream str;
+    str << "num_draws: " << num_draws << ", "
+           "num_distinct: " << num_distinct << ", "
+           "max_ratio: " << max_ratio;
+    return str.str();
+  }
+};
+
+
+/**
+ * The norm of the example i, which bounds the change of its scores
+ * (the Lipschitz constant of the primal loss as a function of W);
+ * the scratch keeps the squared norms (the kernel diagonal with kernels).
+ **/
+template <typename Data,
+          template <typename> class Input,
+          typename Context>
+inline Data
+sampling_norm(
+    const size_type i,
+    const Context&,
+    const solver_scratch<Data, Input>& scratch
+  ) {
+  return std::sqrt(scratch.norms[i]);
+}
+
+
+template <typename Data,
+          typename Context>
+inline Data
+sampling_norm(
+    const size_type,
+    const Context&,
+    const solver_scratch<Data, model_input>&
+  ) {
+  return 1;
+}
+
+
+/*
+ * Draws (last - first) examples with replacement from examples[first, last)
+ * into order[first, last) with the probabilities proportional to
+ *    w_i + mean(w),
+ * i.e. a mixture of the uniform distribution and the one given by
+ * the weights w_i (the norms [1] or the dual residuals [2]).
+ *
+ * [1] Zhao P, Zhang T.
+ *     Stochastic optimization with importance sampling
+ *     for regularized loss minimization.
+ *     ICML 2015.
+ *
+ * [2] Csiba D, Qu Z, Richtarik P.
+ *     Stochastic dual coordinate ascent with adaptive probabilities.
+ *     ICML 2015.
+ */
+template <typename Weight,
+          typename Generator>
+inline void
+sample_examples(
+    const size_type first,
+    const size_type last,
+    const size_type* examples,
+    Weight weight,
+    Generator& gen,
+    std::vector<double>& weights,
+    alias_table& table,
+    size_type* order,
+    sampling_stats& stats
+  ) {
+  if (first >= last) return;
+  weights.resize(last - first);
+  for (size_type k = first; k < last; ++k) {
+    weights[k - first] = static_cast<double>(weight(examples[k]));
+  }
+  double mean = std::accumulate(weights.begin(), weights.end(), 0.0)
+    / static_cast<double>(last - first);
+  for (double& w : weights) {
+    w += mean;
+  }
+  if (mean > 0) {
+    stats.max_ratio = std::max(stats.max_ratio,
+      *std::max_element(weights.begin(), weights.end()) / (2 * mean));
+  }
+
+  table.init(weights.begin(), weights.end());
+  for (size_type k = first; k < last; ++k) {
+    order[k] = examples[first + table(gen)];
+  }
+  stats.num_draws += last - first;
+}
+
+}
+
+#endif
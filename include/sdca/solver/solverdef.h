@@ -3,6 +3,7 @@
 
 #include <cassert>
 #include <sstream>
+#include <string>
 
 #include "sdca/utility/types.h"
 
@@ -47,6 +48,30 @@ solver_status_name(
 }
 
 
+enum class sampling_type {
+  uniform = 0,
+  importance,
+  adaptive
+};
+
+
+inline std::string
+sampling_type_name(
+    sampling_type __sampling
+  ) {
+  switch (__sampling) {
+    case sampling_type::uniform:
+      return "uniform";
+    case sampling_type::importance:
+      return "importance";
+    case sampling_type::adaptive:
+      return "adaptive";
+  }
+  assert(false);
+  return "unknown";
+}
+
+
 struct stopping_criteria {
   size_type eval_epoch = 10;
   size_type max_epoch = 1000;
@@ -69,6 +94,74 @@ struct stopping_criteria {
   }
 };
 
+
+struct solver_options {
+  // Number of worker threads in an epoch (0: use all hardware threads).
+  // With more than one thread, the examples are updated asynchronously
+  // (lock-free) and the primal variables are synchronized before evaluation.
+  // Supported for features and kernels.
+  // The evaluation is multi-threaded for all inputs, with the examples
+  // split between the threads and the test sets processed concurrently.
+  size_type num_threads = 1;
+
+  // Number of examples updated jointly in a mini-batch (features only).
+  // The scores and the primal update are computed with one gemm per batch.
+  size_type batch_size = 1;
+
+  // The step size of a mini-batch update is scaled by 1/batch_beta,
+  // where 0 means a safe bound computed for every batch from its data.
+  double batch_beta = 0;
+
+  // Order of the examples in an epoch: a random permutation (uniform),
+  // or draws with replacement proportional to the (smoothed) norms
+  // (importance) or to the last changes of the dual variables (adaptive).
+  sampling_type sampling = sampling_type::uniform;
+
+  // Shrinking: an example is skipped after this many consecutive visits
+  // with negligible updates until the next evaluation (0: no shrinking).
+  size_type shrink_visits = 0;
+
+  // Number of examples scored jointly (with one gemm) during evaluation.
+  size_type eval_block_size = 256;
+
+  // Acceleration (features only, see accelerated_solver): the problem is
+  // solved as a sequence of proximal problems with an extrapolated W0,
+  // where accel_kappa is the weight of the proximal term 1/2 ||W - W0||^2
+  // relative to the regularizer (0: estimated from the data).
+  bool accelerate = false;
+  double accel_kappa = 0;
+
+  // Checkpoints (see checkpoint.h): the state of the solver is written
+  // to checkpoint_path (if not empty) every checkpoint_epoch epochs and/or
+  // once checkpoint_wall_time seconds have passed since the last one
+  // (0: disabled), and once more at the end of the solve;
+  // checkpoint_page_aligned aligns the arrays to pages (for mmap).
+  // Not supported by the accelerated, path and multi solvers.
+  std::string checkpoint_path;
+  size_type checkpoint_epoch = 0;
+  double checkpoint_wall_time = 0;
+  bool checkpoint_page_aligned = false;
+
+
+  inline std::string
+  to_string() const {
+    std::ostringstream str;
+    str << "num_threads: " << num_threads << ", "
+           "batch_size: " << batch_size << ", "
+           "batch_beta: " << batch_beta << ", "
+           "sampling: " << sampling_type_name(sampling) << ", "
+           "shrink_visits: " << shrink_visits << ", "
+           "eval_block_size: " << eval_block_size << ", "
+           "accelerate: " << accelerate << ", "
+           "accel_kappa: " << accel_kappa << ", "
+           "checkpoint_path: " << checkpoint_path << ", "
+           "checkpoint_epoch: " << checkpoint_epoch << ", "
+           "checkpoint_wall_time: " << checkpoint_wall_time << ", "
+           "checkpoint_page_aligned: " << checkpoint_page_aligned;
+    return str.str();
+  }
+};
+
 }
 
 #endif
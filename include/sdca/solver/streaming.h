@@ -0,0 +1,352 @@
+#ifndef SDCA_SOLVER_STREAMING_H
+#define SDCA_SOLVER_STREAMING_H
+
+#include <algorithm>
+#include <numeric>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "sdca/solver/context.h"
+#include "sdca/solver/data/dataset_file.h"
+#include "sdca/solver/eval.h"
+#include "sdca/solver/update.h"
+#include "sdca/utility/parallel.h"
+
+namespace sdca {
+
+/*
+ * Out-of-core SDCA for feature inputs that do not fit into memory.
+ * The features are read from a dataset file (see dataset_file.h) in chunks
+ * of chunk_size examples by a background thread (dataset_chunk_reader),
+ * so that the next chunk is loaded while the current one is updated.
+ * Only the dual variables A, the primal variables W, the labels and the
+ * norms of the examples are kept in memory, i.e. O(d m + n m) instead of
+ * the O(d n) of the features.
+ *
+ * Every epoch visits the chunks in a random order and the examples of
+ * a chunk in a random order, which approximates a random permutation of
+ * all examples as long as a chunk holds many examples.
+ * The training set is evaluated in one more pass over the chunks,
+ * the test sets are evaluated in memory as usual.
+ *
+ * The context is created with the labels of the file and a feature input
+ * of the right size whose features are ignored (e.g. nullptr).
+ * The options shrink_visits and sampling are ignored (uniform sampling),
+ * the others are used as in the solver.
+ */
+template <typename Data,
+          typename Result,
+          typename Output,
+          template <typename, typename> class Objective>
+class streaming_solver {
+public:
+  typedef Data data_type;
+  typedef Result result_type;
+  typedef feature_input<Data> input_type;
+  typedef Output output_type;
+  typedef Objective<Data, Result> objective_type;
+
+  typedef solver_context<Data, Result, feature_input, Output, Objective>
+    context_type;
+  typedef typename context_type::train_set_type train_set_type;
+  typedef solver_scratch<Data, feature_input> scratch_type;
+
+
+  streaming_solver(
+      context_type& __context,
+      const std::string& path,
+      const size_type chunk_size
+    ) :
+      ctx_(__context),
+      reader_(path, chunk_size),
+      is_evaluated_(false)
+  {
+    if (reader_.num_dimensions() != ctx_.train.num_dimensions() ||
+        reader_.num_examples() != ctx_.train.num_examples()) {
+      throw std::invalid_argument("Dataset file does not match the "
+                                  "training set.");
+    }
+  }
+
+
+  void solve() {
+    begin_solve();
+    while (ctx_.status == solver_status::solving) {
+      is_evaluated_ = false;
+      std::shuffle(chunks_.begin(), chunks_.end(), generator_);
+      for_each_chunk(chunks_,
+        [this](const size_type c, const Data* features) {
+          update_chunk(c, features);
+        });
+      ctx_.num_updates += ctx_.train.num_examples();
+      end_epoch();
+    }
+    end_solve();
+  }
+
+protected:
+  context_type& ctx_;
+  dataset_chunk_reader<Data> reader_;
+  scratch_type scratch_;
+
+  bool is_evaluated_;
+  std::minstd_rand generator_;
+  std::vector<size_type> chunks_;
+  std::vector<size_type> examples_;
+
+  // The contexts of the chunks and the scratches of the threads are
+  // created once per solve, a chunk only repoints its features
+  std::vector<context_type> chunk_contexts_;
+  std::vector<scratch_type> workers_;
+
+  // The norms of the examples are computed on the first visit of a chunk
+  std::vector<Data> norms_;
+  std::vector<bool> has_norms_;
+
+
+  void begin_solve() {
+    reporting::begin_solve(ctx_);
+
+    ctx_.status = (ctx_.criteria.max_epoch > ctx_.epoch)
+                  ? solver_status::solving
+                  : solver_status::max_epoch;
+
+    generator_.seed();
+    chunks_.resize(reader_.num_chunks());
+    std::iota(chunks_.begin(), chunks_.end(), 0);
+    norms_.resize(ctx_.train.num_examples());
+    has_norms_.assign(chunks_.size(), false);
+    chunk_contexts_.clear();
+    chunk_contexts_.reserve(chunks_.size());
+    for (size_type c : chunks_) {
+      chunk_contexts_.push_back(make_chunk_context(c));
+    }
+    const size_type num_threads = resolve_num_threads(
+      ctx_.options.num_threads);
+    workers_.assign((num_threads > 1) ? num_threads : 0, scratch_type());
+    reporting::streaming(ctx_, chunks_.size(), reader_.chunk_size());
+
+    if (ctx_.criteria.eval_on_start) {
+      evaluate_solution();
+      check_stopping_criteria<Data, Result>(ctx_);
+    }
+
+    if (ctx_.status == solver_status::solving) {
+      ctx_.solve_time.resume();
+    }
+  }
+
+
+  void end_solve() {
+    ctx_.solve_time.stop();
+    if (!is_evaluated_) {
+      evaluate_solution();
+    }
+
+    reporting::end_solve(ctx_);
+  }
+
+
+  void end_epoch() {
+    ctx_.solve_time.stop();
+
+    ++ctx_.epoch;
+    if ((ctx_.criteria.eval_epoch > 0) &&
+        (ctx_.epoch % ctx_.criteria.eval_epoch == 0)) {
+      evaluate_solution();
+    }
+
+    check_stopping_criteria<Data, Result>(ctx_);
+    reporting::end_epoch(ctx_, is_evaluated_);
+
+    ctx_.solve_time.resume();
+  }
+
+
+  /*
+   * Calls f(c, features) for every chunk c in the given order, while the
+   * next chunk is read in the background.
+   */
+  template <typename Function>
+  void for_each_chunk(
+      const std::vector<size_type>& chunks,
+      Function f
+    ) {
+    if (chunks.empty()) return;
+    reader_.read(chunks[0]);
+    for (size_type j = 0; j < chunks.size(); ++j) {
+      const Data* features = reader_.wait();
+      if (j + 1 < chunks.size()) {
+        reader_.read(chunks[j + 1]);
+      }
+      f(chunks[j], features);
+    }
+  }
+
+
+  /*
+   * The chunk is a training set of its own with the dual variables
+   * A(:, first:last) and the shared primal variables W
+   * (the features are set by chunk_context when the chunk is read).
+   */
+  context_type make_chunk_context(
+      const size_type c
+    ) const {
+    const size_type first = reader_.chunk_begin(c);
+    const size_type last = reader_.chunk_end(c);
+    context_type chunk(train_set_type(
+        input_type(ctx_.train.num_dimensions(), last - first, nullptr),
+        make_output_slice(ctx_.train.out, first, last)),
+      objective_type(ctx_.objective),
+      ctx_.dual_variables + ctx_.train.num_classes() * first,
+      ctx_.primal_variables, ctx_.primal_initial);
+    chunk.options = ctx_.options;
+    return chunk;
+  }
+
+
+  context_type& chunk_context(
+      const size_type c,
+      const Data* features
+    ) {
+    context_type& chunk = chunk_contexts_[c];
+    chunk.train.in.features = features;
+    return chunk;
+  }
+
+
+  void update_chunk(
+      const size_type c,
+      const Data* features
+    ) {
+    context_type& chunk = chunk_context(c, features);
+    const size_type first = reader_.chunk_begin(c);
+    const size_type n = chunk.train.num_examples();
+    if (has_norms_[c]) {
+      scratch_.norms.assign(norms_.begin() + static_cast<diff_type>(first),
+        norms_.begin() + static_cast<diff_type>(first + n));
+    } else {
+      scratch_.init(chunk.train, ctx_.options.eval_block_size);
+      std::copy(scratch_.norms.begin(), scratch_.norms.end(),
+                norms_.begin() + static_cast<diff_type>(first));
+      has_norms_[c] = true;
+    }
+
+    examples_.resize(n);
+    std::iota(examples_.begin(), examples_.end(), 0);
+    std::shuffle(examples_.begin(), examples_.end(), generator_);
+
+    // Lock-free asynchronous updates within the chunk (see solver);
+    // the workers keep their buffers and only take the norms of the chunk
+    if (!workers_.empty()) {
+      for (scratch_type& worker : workers_) {
+        worker.norms.assign(scratch_.norms.begin(), scratch_.norms.end());
+        worker.scores.resize(scratch_.scores.size());
+        worker.variables.resize(scratch_.variables.size());
+      }
+      parallel_for(workers_.size(), 0, n,
+        [&](const size_type t, const size_type begin, const size_type end) {
+          update_examples(begin, end, chunk, workers_[t]);
+        });
+    } else {
+      update_examples(0, n, chunk, scratch_);
+    }
+  }
+
+
+  void update_examples(
+      size_type first,
+      const size_type last,
+      context_type& chunk,
+      scratch_type& scratch
+    ) {
+    const size_type batch_size = ctx_.options.batch_size;
+    if (batch_size > 1) {
+      const Data beta = static_cast<Data>(ctx_.options.batch_beta);
+      for (; first < last; first += batch_size) {
+        update_variables_batch(examples_.data() + first,
+          examples_.data() + std::min(first + batch_size, last), beta,
+          chunk, scratch);
+      }
+    } else {
+      for (; first != last; ++first) {
+        update_variables(examples_[first], chunk, scratch);
+      }
+    }
+  }
+
+
+  void evaluate_solution() {
+    ctx_.eval_time.resume();
+
+    const size_type m = ctx_.train.num_classes();
+    const size_type n = ctx_.train.num_examples();
+    std::vector<size_type> order(chunks_.size());
+    std::iota(order.begin(), order.end(), 0);
+
+#ifdef SDCA_ACCURATE_MATH
+    recompute_primal_variables(order);
+#else
+    // Asynchronous updates may lose some of the primal increments
+    if (resolve_num_threads(ctx_.options.num_threads) > 1) {
+      recompute_primal_variables(order);
+    }
+#endif
+
+    // The chunks are accumulated into one eval in the order of the file
+    auto& eval = eval_begin(ctx_.train);
+    eval_regularizer_primal(m, ctx_.train.in, ctx_, eval);
+    const size_type block_size = std::max(static_cast<size_type>(1),
+                                          ctx_.options.eval_block_size);
+    std::vector<Data> scores(m * block_size);
+    std::vector<Data> variables(m);
+    for_each_chunk(order,
+      [&](const size_type c, const Data* features) {
+        context_type& chunk = chunk_context(c, features);
+        evaluate_examples(0, chunk.train.num_examples(), block_size, chunk,
+          chunk.train, &scores[0], &variables[0], eval);
+      });
+    eval_end(m, n, ctx_, eval);
+    reporting::eval_created(eval, 0);
+
+    size_type id(0);
+    for (auto& test_set : ctx_.test) {
+      evaluate_dataset(ctx_, test_set, scratch_, id++);
+    }
+
+    is_evaluated_ = true;
+    ctx_.eval_time.stop();
+  }
+
+
+  void recompute_primal_variables(
+      const std::vector<size_type>& order
+    ) {
+    // Let W = W0 + X * A', accumulated over the chunks
+    const blas_int DM = static_cast<blas_int>(
+      ctx_.train.num_dimensions() * ctx_.train.num_classes());
+    if (ctx_.is_prox()) {
+      sdca_blas_copy(DM, ctx_.primal_initial, ctx_.primal_variables);
+    } else {
+      std::fill_n(ctx_.primal_variables, DM, static_cast<Data>(0));
+    }
+    for_each_chunk(order,
+      [this](const size_type c, const Data* features) {
+        context_type& chunk = chunk_context(c, features);
+        const blas_int D = static_cast<blas_int>(
+          chunk.train.num_dimensions());
+        sdca_blas_gemm(D, static_cast<blas_int>(chunk.train.num_classes()),
+          static_cast<blas_int>(chunk.train.num_examples()), features, D,
+          chunk.dual_variables, static_cast<blas_int>(
+            chunk.train.num_classes()),
+          ctx_.primal_variables, CblasNoTrans, CblasTrans, 1, 1);
+      });
+  }
+
+};
+
+}
+
+#endif
@@ -1,6 +1,9 @@
 #ifndef SDCA_SOLVER_UPDATE_H
 #define SDCA_SOLVER_UPDATE_H
 
+#include <algorithm>
+#include <cmath>
+
 #include "sdca/prox/proxdef.h"
 #include "sdca/solver/data/input.h"
 #include "sdca/solver/data/output.h"
@@ -49,61 +52,285 @@ update_dual_variables(
 }
 
 
+/*
+ * Updates the dual variables of the example i in place given its scores
+ * and lets var_diff = old - new, i.e. the primal variables are to be
+ * updated as W = W - x_i * var_diff'. Returns ||var_diff||_1.
+ */
 template <typename Data,
           typename Context>
-inline void
+inline Data
+update_dual_variables_diff(
+    const size_type i,
+    const Data norm2,
+    Context& ctx,
+    Data* scores,
+    Data* var_diff
+  ) {
+  const auto& d = ctx.train;
+  const size_type m = d.num_classes();
+  const blas_int M = static_cast<blas_int>(m);
+  Data* variables = ctx.dual_variables + m * i;
+  sdca_blas_copy(M, variables, var_diff);
+  update_dual_variables(i, m, norm2, d.out, ctx.objective, variables, scores);
+  sdca_blas_axpy(M, -1, variables, var_diff);
+  return sdca_blas_asum(M, var_diff);
+}
+
+
+/**
+ * Updates the dual (and primal) variables of the example i
+ * with dense features, i.e. x_i is either read from the input or
+ * generated into the scratch once (see dense_solver_scratch)
+ * for both the scores and the rank-1 update; e.g. only the compressed
+ * x_i of quantized_feature_input is read from memory.
+ * Returns the change of its dual variables (in the l1 norm).
+ **/
+template <typename Data,
+          template <typename> class Input,
+          typename Context>
+inline Data
+update_variables(
+    const size_type i,
+    Context& ctx,
+    dense_solver_scratch<Data, Input>& scratch
+  ) {
+  const auto& d = ctx.train;
+  const Data norm2 = scratch.norms[i];
+
+  if (norm2 <= 0) return 0;
+
+  const blas_int D = static_cast<blas_int>(d.in.num_dimensions);
+  const blas_int M = static_cast<blas_int>(d.num_classes());
+  const Data* x_i = d.in.features_block(i, i + 1, scratch.features);
+
+  // Let scores = W' * x_i
+  Data* scores = &scratch.scores[0];
+  sdca_blas_gemv(D, M, ctx.primal_variables, x_i, scores, CblasTrans);
+
+  // Update dual variables
+  Data* var_diff = &scratch.variables[0];
+  Data diff = update_dual_variables_diff(i, norm2, ctx, scores, var_diff);
+
+  // Update primal variables
+  if (diff > std::numeric_limits<Data>::epsilon()) {
+    sdca_blas_ger(D, M, -1, x_i, var_diff, ctx.primal_variables);
+  }
+  return diff;
+}
+
+
+/**
+ * Updates the dual (and primal) variables of the example i
+ * with sparse features, i.e. in O(nnz * m) instead of O(d * m).
+ * Returns the change of its dual variables (in the l1 norm).
+ **/
+template <typename Data,
+          typename Context>
+inline Data
 update_variables(
     const size_type i,
     Context& ctx,
-    solver_scratch<Data, feature_input>& scratch
+    solver_scratch<Data, sparse_feature_input>& scratch
   ) {
   const auto& d = ctx.train;
   const Data norm2 = scratch.norms[i];
 
-  if (norm2 <= 0) return;
+  if (norm2 <= 0) return 0;
 
   const size_type m = d.num_classes();
   Data* scores = &scratch.scores[0];
   eval_scores(i, m, d.in, ctx, scores);
 
   // Update dual variables
-  const blas_int M = static_cast<blas_int>(m);
-  Data* var_copy = &scratch.variables[0];
-  Data* variables = ctx.dual_variables + m * i;
-  sdca_blas_copy(M, variables, var_copy);
-  update_dual_variables(i, m, norm2, d.out, ctx.objective, variables, scores);
+  Data* var_diff = &scratch.variables[0];
+  Data diff = update_dual_variables_diff(i, norm2, ctx, scores, var_diff);
 
-  // Update primal variables
-  sdca_blas_axpy(M, -1, variables, var_copy);
-  Data diff = sdca_blas_asum(M, var_copy);
+  // Update primal variables (a sparse rank-1 update)
   if (diff > std::numeric_limits<Data>::epsilon()) {
-    const size_type dim = d.in.num_dimensions;
-    const blas_int D = static_cast<blas_int>(dim);
-    const Data* x_i = d.in.features + dim * i;
-    sdca_blas_ger(D, M, -1, x_i, var_copy, ctx.primal_variables);
+    const size_type first = d.in.offsets[i];
+    sdca_sparse_ger(d.in.num_dimensions, m, static_cast<Data>(-1),
+      d.in.offsets[i + 1] - first, d.in.values + first,
+      d.in.indices + first, var_diff, ctx.primal_variables);
   }
+  return diff;
+}
+
+
+/**
+ * Computes an upper bound on the largest eigenvalue of the Gram matrix
+ * of the normalized features x_j / ||x_j|| in the batch (a B-by-B matrix).
+ * It is a safe step size scaling for the mini-batch update,
+ *    ||sum_j x_j * d_j'||^2 <= beta * sum_j ||x_j||^2 * ||d_j||^2,
+ * and is 1 for orthogonal and B for collinear features.
+ **/
+template <typename Data>
+inline Data
+batch_beta_bound(
+    const size_type batch_size,
+    const size_type num_dimensions,
+    const Data* norms,
+    const Data* features,
+    Data* gram
+  ) {
+  const blas_int B = static_cast<blas_int>(batch_size);
+  const blas_int D = static_cast<blas_int>(num_dimensions);
+  sdca_blas_gemm(B, B, D, features, D, features, D, gram, CblasTrans);
+
+  // Gershgorin's bound: beta <= max_j sum_k |G_jk| / ||x_j|| / ||x_k||
+  Data beta(1);
+  for (size_type j = 0; j < batch_size; ++j, gram += batch_size) {
+    if (norms[j] <= 0) continue;
+    Data sum(0);
+    for (size_type k = 0; k < batch_size; ++k) {
+      if (norms[k] > 0) sum += std::abs(gram[k]) / norms[k];
+    }
+    beta = std::max(beta, sum / norms[j]);
+  }
+  return std::min(beta, static_cast<Data>(batch_size));
+}
+
+
+/*
+ * Mini-batch update of the examples in [first, last).
+ * The scores for the whole batch are computed with a single gemm,
+ * the dual variables are updated independently with the step size
+ * scaled by 1/beta, and the primal variables are updated with
+ * a single rank-B gemm.
+ * If changes is given, changes[i] is set to the change of the dual
+ * variables of the example i (in the l1 norm).
+ *
+ * [1] Takac M, Bijral A, Richtarik P, Srebro N.
+ *     Mini-batch primal and dual methods for SVMs.
+ *     ICML 2013.
+ */
+template <typename Data,
+          typename Context>
+inline void
+update_variables_batch(
+    const size_type* first,
+    const size_type* last,
+    const Data beta,
+    Context& ctx,
+    solver_scratch<Data, feature_input>& scratch,
+    Data* changes = nullptr
+  ) {
+  const auto& d = ctx.train;
+  const size_type num_batch = static_cast<size_type>(last - first);
+  const size_type dim = d.in.num_dimensions;
+  const size_type m = d.num_classes();
+  const blas_int B = static_cast<blas_int>(num_batch);
+  const blas_int D = static_cast<blas_int>(dim);
+  const blas_int M = static_cast<blas_int>(m);
+
+  scratch.batch_features.resize(dim * num_batch);
+  scratch.batch_scores.resize(m * num_batch);
+  scratch.batch_variables.resize(m * num_batch);
+  Data* features = &scratch.batch_features[0];
+  Data* scores = &scratch.batch_scores[0];
+  Data* var_diff = &scratch.batch_variables[0];
+
+  // Gather the batch into a contiguous d-by-B matrix
+  scratch.batch_norms.resize(num_batch);
+  Data* norms = &scratch.batch_norms[0];
+  for (size_type j = 0; j < num_batch; ++j) {
+    sdca_blas_copy(D, d.in.features + dim * first[j], features + dim * j);
+    norms[j] = std::sqrt(scratch.norms[first[j]]);
+  }
+
+  Data step(beta);
+  if (step <= 0) {
+    scratch.batch_gram.resize(num_batch * num_batch);
+    step = batch_beta_bound(num_batch, dim, norms, features,
+                            &scratch.batch_gram[0]);
+  }
+
+  // Let scores = W' * X_B
+  sdca_blas_gemm(M, B, D, ctx.primal_variables, D, features, D, scores,
+                 CblasTrans);
+
+  // Update dual variables
+  for (size_type j = 0; j < num_batch; ++j) {
+    const size_type i = first[j];
+    const Data norm2 = scratch.norms[i];
+    Data* diff = var_diff + m * j;
+    if (norm2 <= 0) {
+      std::fill_n(diff, m, static_cast<Data>(0));
+      if (changes != nullptr) changes[i] = 0;
+      continue;
+    }
+
+    Data* variables = ctx.dual_variables + m * i;
+    sdca_blas_copy(M, variables, diff);
+    update_dual_variables(i, m, step * norm2, d.out, ctx.objective,
+                          variables, scores + m * j);
+    sdca_blas_axpby(M, 1, variables, -1, diff);
+    if (changes != nullptr) changes[i] = sdca_blas_asum(M, diff);
+  }
+
+  // Let W = W + X_B * (A_B_new - A_B_old)'
+  sdca_blas_gemm(D, M, B, features, D, var_diff, M, ctx.primal_variables,
+                 CblasNoTrans, CblasTrans, 1, 1);
 }
 
 
 template <typename Data,
+          template <typename> class Input,
           typename Context>
 inline void
+update_variables_batch(
+    const size_type* first,
+    const size_type* last,
+    const Data,
+    Context& ctx,
+    solver_scratch<Data, Input>& scratch,
+    Data* changes = nullptr
+  ) {
+  // Mini-batches are not supported, fall back to sequential updates
+  for (; first != last; ++first) {
+    Data change = update_variables(*first, ctx, scratch);
+    if (changes != nullptr) changes[*first] = change;
+  }
+}
+
+
+/**
+ * Updates the dual variables of the example i with a kernel input,
+ * i.e. its scores are computed from the dual variables and the column K_i
+ * (see eval_scores) and its norm is K_ii (see kernel_solver_scratch).
+ * Returns the change of its dual variables (in the l1 norm).
+ **/
+template <typename Data,
+          template <typename> class Input,
+          typename Context>
+inline Data
 update_variables(
     const size_type i,
     Context& ctx,
-    solver_scratch<Data, kernel_input>& scratch
+    kernel_solver_scratch<Data, Input>& scratch
   ) {
   const auto& d = ctx.train;
-  const Data norm2 = d.in.kernel[d.in.num_train_examples * i + i];
+  const Data norm2 = scratch.norms[i];
 
-  if (norm2 <= 0) return;
+  if (norm2 <= 0) return 0;
 
   const size_type m = d.num_classes();
   Data* scores = &scratch.scores[0];
   eval_scores(i, m, d.in, ctx, scores);
 
-  Data* variables = ctx.dual_variables + m * i;
+  // Update a copy of the dual variables, since they are re-ordered in place
+  // and may be concurrently read by other threads to compute their scores
+  const blas_int M = static_cast<blas_int>(m);
+  Data* variables = &scratch.variables[0];
+  sdca_blas_copy(M, ctx.dual_variables + m * i, variables);
   update_dual_variables(i, m, norm2, d.out, ctx.objective, variables, scores);
+
+  // The scores are no longer needed, use them to compute the change
+  sdca_blas_copy(M, ctx.dual_variables + m * i, scores);
+  sdca_blas_axpy(M, -1, variables, scores);
+  Data diff = sdca_blas_asum(M, scores);
+  sdca_blas_copy(M, variables, ctx.dual_variables + m * i);
+  return diff;
 }
 
 
@@ -150,7 +377,7 @@ guess_lipschitz_constant(
  */
 template <typename Data,
           typename Context>
-inline void
+inline Data
 update_variables(
     const size_type i,
     Context& ctx,
@@ -161,7 +388,7 @@ update_variables(
   const auto& out = dataset.out;
 
   const Data lip = scratch.lipschitz;
-  if (lip <= 0) return;
+  if (lip <= 0) return 0;
 
   const size_type d = dataset.num_dimensions();
   const size_type m = dataset.num_classes();
@@ -213,6 +440,10 @@ update_variables(
     // u = u + Wx - z = u - z
     sdca_blas_axpy(D, -1, z, u);
   }
+
+  // The change of x is not tracked across the iterations,
+  // report the update as non-negligible
+  return std::numeric_limits<Data>::max();
 }
 
 }
@@ -0,0 +1,111 @@
+#ifndef SDCA_UTILITY_DURABLE_FILE_H
+#define SDCA_UTILITY_DURABLE_FILE_H
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdio>
+#include <fstream>
+#include <string>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define SDCA_POSIX_FILE
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace sdca {
+
+#ifdef SDCA_POSIX_FILE
+
+/*
+ * Flushes the data of the file to the disk:
+ * fdatasync on Linux, F_FULLFSYNC on macOS (where fsync only reaches
+ * the drive cache, and fdatasync is not declared), fsync elsewhere.
+ */
+inline bool
+sync_file_data(
+    const int fd
+  ) {
+#if defined(__APPLE__)
+  return ::fcntl(fd, F_FULLFSYNC) != -1 || ::fsync(fd) == 0;
+#elif defined(__linux__)
+  return ::fdatasync(fd) == 0;
+#else
+  return ::fsync(fd) == 0;
+#endif
+}
+
+
+/**
+ * Writes size bytes to path.tmp, flushes them to the disk and renames
+ * the file to path; the directory is then flushed as well, so that
+ * the rename survives a crash of the machine.
+ * Returns false if any of the steps fails.
+ **/
+inline bool
+write_file_durable(
+    const std::string& path,
+    const char* data,
+    const std::size_t size
+  ) {
+  const std::string tmp_path = path + ".tmp";
+  int fd = ::open(tmp_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0) return false;
+  for (std::size_t left = size; left > 0;) {
+    const ::ssize_t written = ::write(fd, data, left);
+    if (written < 0 && errno == EINTR) continue;
+    if (written <= 0) {
+      ::close(fd);
+      return false;
+    }
+    data += written;
+    left -= static_cast<std::size_t>(written);
+  }
+  if (!sync_file_data(fd)) {
+    ::close(fd);
+    return false;
+  }
+  if (::close(fd) != 0 ||
+      std::rename(tmp_path.c_str(), path.c_str()) != 0) {
+    return false;
+  }
+
+  const std::string::size_type slash = path.rfind('/');
+  const std::string dir = (slash == std::string::npos) ? "."
+    : (slash == 0) ? "/" : path.substr(0, slash);
+  fd = ::open(dir.c_str(), O_RDONLY);
+  if (fd < 0) return false;
+  const bool is_ok = ::fsync(fd) == 0;
+  ::close(fd);
+  return is_ok;
+}
+
+#else
+
+/**
+ * Writes size bytes to path.tmp and renames the file to path
+ * (without the POSIX calls, the data is not explicitly flushed to the disk).
+ * Returns false if any of the steps fails.
+ **/
+inline bool
+write_file_durable(
+    const std::string& path,
+    const char* data,
+    const std::size_t size
+  ) {
+  const std::string tmp_path = path + ".tmp";
+  {
+    std::ofstream file(tmp_path, std::ios::binary | std::ios::trunc);
+    if (!file.write(data, static_cast<std::streamsize>(size)).flush()) {
+      return false;
+    }
+  }
+  std::remove(path.c_str());
+  return std::rename(tmp_path.c_str(), path.c_str()) == 0;
+}
+
+#endif
+
+}
+
+#endif
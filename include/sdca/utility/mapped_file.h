@@ -0,0 +1,157 @@
+#ifndef SDCA_UTILITY_MAPPED_FILE_H
+#define SDCA_UTILITY_MAPPED_FILE_H
+
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "sdca/utility/types.h"
+
+namespace sdca {
+
+enum class access_pattern {
+  normal = 0,
+  sequential,
+  random,
+  will_need
+};
+
+
+/**
+ * A read-only memory mapping of a whole file (POSIX).
+ * The pages are shared with the page cache, i.e. loading is instant and
+ * concurrent processes mapping the same file share the physical memory.
+ * Throws std::runtime_error if the file cannot be mapped.
+ **/
+class mapped_file {
+public:
+  mapped_file() :
+      data_(nullptr),
+      size_(0)
+  {}
+
+
+  explicit mapped_file(
+      const std::string& path
+    ) :
+      data_(nullptr),
+      size_(0)
+  {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+      throw std::runtime_error("Cannot open file '" + path + "'.");
+    }
+    struct stat st;
+    if (::fstat(fd, &st) != 0) {
+      ::close(fd);
+      throw std::runtime_error("Cannot stat file '" + path + "'.");
+    }
+    size_ = static_cast<size_type>(st.st_size);
+    if (size_ > 0) {
+      void* p = ::mmap(nullptr, size_, PROT_READ, MAP_SHARED, fd, 0);
+      if (p == MAP_FAILED) {
+        ::close(fd);
+        throw std::runtime_error("Cannot map file '" + path + "'.");
+      }
+      data_ = static_cast<const char*>(p);
+    }
+    // The mapping stays valid after the descriptor is closed
+    ::close(fd);
+  }
+
+
+  ~mapped_file() {
+    unmap();
+  }
+
+
+  mapped_file(const mapped_file&) = delete;
+  mapped_file& operator=(const mapped_file&) = delete;
+
+
+  mapped_file(
+      mapped_file&& other
+    ) :
+      data_(other.data_),
+      size_(other.size_)
+  {
+    other.data_ = nullptr;
+    other.size_ = 0;
+  }
+
+
+  mapped_file& operator=(
+      mapped_file&& other
+    ) {
+    if (this != &other) {
+      unmap();
+      std::swap(data_, other.data_);
+      std::swap(size_, other.size_);
+    }
+    return *this;
+  }
+
+
+  const char* data() const { return data_; }
+
+  size_type size() const { return size_; }
+
+
+  /**
+   * Hints the kernel how the bytes [offset, offset + size) will be read:
+   * sequential (aggressive read-ahead, e.g. evaluation),
+   * random (no read-ahead, e.g. shuffled examples),
+   * or will_need (prefetch now). The hint is advisory and never fails.
+   **/
+  void advise(
+      const access_pattern pattern,
+      size_type offset = 0,
+      size_type size = 0
+    ) const {
+    if (data_ == nullptr || offset >= size_) return;
+    if (size == 0 || offset + size > size_) size = size_ - offset;
+
+    // madvise requires a page aligned address
+    const size_type page = static_cast<size_type>(::sysconf(_SC_PAGESIZE));
+    const size_type aligned = offset / page * page;
+    int advice = MADV_NORMAL;
+    switch (pattern) {
+      case access_pattern::normal:
+        advice = MADV_NORMAL;
+        break;
+      case access_pattern::sequential:
+        advice = MADV_SEQUENTIAL;
+        break;
+      case access_pattern::random:
+        advice = MADV_RANDOM;
+        break;
+      case access_pattern::will_need:
+        advice = MADV_WILLNEED;
+        break;
+    }
+    ::madvise(const_cast<char*>(data_) + aligned, size + offset - aligned,
+              advice);
+  }
+
+private:
+  const char* data_;
+  size_type size_;
+
+
+  void unmap() {
+    if (data_ != nullptr) {
+      ::munmap(const_cast<char*>(data_), size_);
+      data_ = nullptr;
+      size_ = 0;
+    }
+  }
+};
+
+}
+
+#endif
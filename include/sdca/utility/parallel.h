@@ -0,0 +1,79 @@
+#ifndef SDCA_UTILITY_PARALLEL_H
+#define SDCA_UTILITY_PARALLEL_H
+
+#include <thread>
+#include <vector>
+
+#include "sdca/utility/types.h"
+
+namespace sdca {
+
+/**
+ * Returns the number of threads to use given the requested number,
+ * where 0 means "use all available hardware threads".
+ **/
+inline size_type
+resolve_num_threads(
+    const size_type num_threads
+  ) {
+  if (num_threads > 0) return num_threads;
+  const size_type hw = static_cast<size_type>(
+    std::thread::hardware_concurrency());
+  return (hw > 0) ? hw : 1;
+}
+
+
+/**
+ * Returns the first index of the block t when the range [first, last)
+ * is split into num_blocks contiguous blocks of (almost) equal size.
+ **/
+inline size_type
+block_begin(
+    const size_type first,
+    const size_type last,
+    const size_type num_blocks,
+    const size_type t
+  ) {
+  return first + (last - first) * t / num_blocks;
+}
+
+
+/**
+ * Splits the range [first, last) into num_threads contiguous blocks
+ * of (almost) equal size and calls
+ *    f(thread_id, block_first, block_last)
+ * for every block, each in a separate thread.
+ * The last block is processed in the calling thread.
+ **/
+template <typename Function>
+inline void
+parallel_for(
+    const size_type num_threads,
+    const size_type first,
+    const size_type last,
+    Function f
+  ) {
+  const size_type n = last - first;
+  if (num_threads <= 1 || n <= 1) {
+    f(static_cast<size_type>(0), first, last);
+    return;
+  }
+
+  const size_type num_blocks = (num_threads < n) ? num_threads : n;
+  std::vector<std::thread> threads;
+  threads.reserve(num_blocks - 1);
+  for (size_type t = 0; t < num_blocks - 1; ++t) {
+    threads.emplace_back(f, t, block_begin(first, last, num_blocks, t),
+      block_begin(first, last, num_blocks, t + 1));
+  }
+  f(num_blocks - 1, block_begin(first, last, num_blocks, num_blocks - 1),
+    last);
+
+  for (auto& thread : threads) {
+    thread.join();
+  }
+}
+
+}
+
+#endif
@@ -49,6 +49,30 @@ printHelp(const mxArray* opts) {
 "    eval_on_start  [false]  - whether to check the duality gap on start;\n"
 "    eval_epoch     [10]     - how often to check the gap;\n"
 "\n"
+"    num_threads    [1]      - number of threads for asynchronous updates\n"
+"                              and evaluation (0: all hardware threads);\n"
+"    batch_size     [1]      - mini-batch size (features only);\n"
+"    batch_beta     [0]      - mini-batch step size scaling 1/batch_beta\n"
+"                              (0: safe bound computed for every batch);\n"
+"    sampling  ['uniform']   - order of the examples in an epoch:\n"
+"                              'uniform' (random permutation),\n"
+"                              'importance' (proportional to the norms),\n"
+"                              'adaptive' (proportional to the changes);\n"
+"    shrink_visits  [0]      - skip an example after this many visits with\n"
+"                              negligible updates until the next eval\n"
+"                              (0: no shrinking);\n"
+"    eval_block_size [256]   - number of examples scored jointly in eval;\n"
+"    accelerate     [false]  - whether to accelerate the solver with an outer\n"
+"                              loop of proximal problems (features only);\n"
+"    accel_kappa    [0]      - weight of the proximal term in the outer loop\n"
+"                              (0: estimated from the data);\n"
+"    checkpoint_path ['']    - file to save the solver state to (no outer\n"
+"                              loop, i.e. with accelerate=false);\n"
+"    checkpoint_epoch [0]    - save the state every this many epochs;\n"
+"    checkpoint_wall_time [0] - save the state every this many seconds;\n"
+"    checkpoint_page_aligned [false] - align the arrays to pages (mmap);\n"
+"    resume          ['']    - checkpoint file to continue solving from;\n"
+"\n"
 "    log_level  ['info']     - logging verbosity:\n"
 "                              'none', 'warning', 'info', 'verbose', 'debug';\n"
 "    log_format ['short_e']  - numeric format:\n"
@@ -88,6 +112,7 @@ printHelp(const mxArray* opts) {
 "  data can be:\n"
 "    - a d-by-n feature matrix,\n"
 "      where d is the number of features and n is the number of examples.\n"
+"      A sparse (double) matrix is used without densifying it.\n"
 "    - a n-by-n Gram matrix (requires opts.is_dual=true),\n"
 "      where n is the number of training examples.\n"
 "    - a cell array containing either the feature or the Gram matrices,\n"
@@ -280,6 +305,7 @@ add_info_solution(
   info.add("epoch", mxCreateScalar(ctx.epoch));
   info.add("cpu_time", mxCreateScalar(ctx.cpu_time()));
   info.add("wall_time", mxCreateScalar(ctx.wall_time()));
+  info.add("throughput", mxCreateScalar(ctx.throughput()));
 
   const auto& evals = ctx.train.evals;
   if (evals.size() > 0) {
@@ -303,6 +329,15 @@ add_info_input(
   info.add("num_dimensions", mxCreateScalar(in.num_dimensions));
 }
 
+template <typename Data>
+inline void
+add_info_input(
+    const sparse_feature_input<Data>& in,
+    model_info<mxArray*>& info
+  ) {
+  info.add("num_dimensions", mxCreateScalar(in.num_dimensions));
+}
+
 template <typename Objective>
 inline void
 add_info_k(
@@ -364,6 +399,22 @@ add_info(
   info.add("max_wall_time", mxCreateScalar(ctx.criteria.max_wall_time));
   info.add("eval_on_start", mxCreateScalar(ctx.criteria.eval_on_start));
   info.add("eval_epoch", mxCreateScalar(ctx.criteria.eval_epoch));
+  info.add("num_threads", mxCreateScalar(ctx.options.num_threads));
+  info.add("batch_size", mxCreateScalar(ctx.options.batch_size));
+  info.add("batch_beta", mxCreateScalar(ctx.options.batch_beta));
+  info.add("sampling",
+           mxCreateString(sampling_type_name(ctx.options.sampling).c_str()));
+  info.add("shrink_visits", mxCreateScalar(ctx.options.shrink_visits));
+  info.add("eval_block_size", mxCreateScalar(ctx.options.eval_block_size));
+  info.add("accelerate", mxCreateScalar(ctx.options.accelerate));
+  info.add("accel_kappa", mxCreateScalar(ctx.options.accel_kappa));
+  info.add("checkpoint_path",
+           mxCreateString(ctx.options.checkpoint_path.c_str()));
+  info.add("checkpoint_epoch", mxCreateScalar(ctx.options.checkpoint_epoch));
+  info.add("checkpoint_wall_time",
+           mxCreateScalar(ctx.options.checkpoint_wall_time));
+  info.add("checkpoint_page_aligned",
+           mxCreateScalar(ctx.options.checkpoint_page_aligned));
 
   info.add("data_precision",
            mxCreateString(type_name<typename Context::data_type>()));
@@ -390,6 +441,34 @@ validate_matrix(
   }
 }
 
+inline void
+validate_sparse_matrix(
+    const mxArray* data
+  ) {
+  mxCheckNotEmpty(data, "data");
+  mxCheckReal(data, "data");
+  mxCheckDouble(data, "data");
+}
+
+template <typename Data,
+          typename Input>
+inline void
+validate_test_matrix(
+    const Input&,
+    const mxArray* data
+  ) {
+  validate_matrix<Data>(data);
+}
+
+template <typename Data>
+inline void
+validate_test_matrix(
+    const sparse_feature_input<Data>&,
+    const mxArray* data
+  ) {
+  validate_sparse_matrix(data);
+}
+
 inline void
 validate_labels(
     const mxArray* labels,
@@ -419,6 +498,20 @@ make_test_input(
     static_cast<Data*>(mxGetData(data)));
 }
 
+template <typename Data>
+inline sparse_feature_input<Data>
+make_test_input(
+    const sparse_feature_input<Data>& trn_in,
+    const mxArray* data,
+    const size_type id
+  ) {
+  if (trn_in.num_dimensions != mxGetM(data)) {
+    mexErrMsgIdAndTxt(err_id[err_num_dim], err_msg[err_num_dim], id);
+  }
+  return sdca::make_input_sparse_feature(mxGetM(data), mxGetN(data),
+    mxGetPr(data), mxGetIr(data), mxGetJc(data));
+}
+
 template <typename Data>
 inline kernel_input<Data>
 make_test_input(
@@ -486,7 +579,7 @@ set_test_data(
   for (size_type i = 1; i < num_datasets; ++i) {
     auto data = mxGetCell(all_data, i);
     auto labels = mxGetCell(all_labels, i);
-    validate_matrix<Data>(data);
+    validate_test_matrix<Data>(ctx.train.in, data);
     validate_labels(labels, mxGetN(data));
 
     Input<Data> in = make_test_input(ctx.train.in, data, i + 1);
@@ -526,12 +619,61 @@ set_stopping_criteria(
     c->max_wall_time, 0, "max_wall_time");
 }
 
+template <typename Context>
+inline void
+set_solver_options(
+    const mxArray* opts,
+    Context& ctx
+  ) {
+  auto o = &ctx.options;
+  mxSetFieldValue(opts, "num_threads", o->num_threads);
+  mxSetFieldValue(opts, "batch_size", o->batch_size);
+  mxSetFieldValue(opts, "batch_beta", o->batch_beta);
+  mxSetFieldValue(opts, "shrink_visits", o->shrink_visits);
+  mxSetFieldValue(opts, "eval_block_size", o->eval_block_size);
+  mxSetFieldValue(opts, "accelerate", o->accelerate);
+  mxSetFieldValue(opts, "accel_kappa", o->accel_kappa);
+  mxSetFieldValue(opts, "checkpoint_epoch", o->checkpoint_epoch);
+  mxSetFieldValue(opts, "checkpoint_wall_time", o->checkpoint_wall_time);
+  mxSetFieldValue(opts, "checkpoint_page_aligned", o->checkpoint_page_aligned);
+  o->checkpoint_path = mxGetFieldValueOrDefault(
+    opts, "checkpoint_path", o->checkpoint_path);
+
+  std::string sampling = mxGetFieldValueOrDefault(
+    opts, "sampling", sampling_type_name(o->sampling));
+  if (sampling == "uniform") {
+    o->sampling = sampling_type::uniform;
+  } else if (sampling == "importance") {
+    o->sampling = sampling_type::importance;
+  } else if (sampling == "adaptive") {
+    o->sampling = sampling_type::adaptive;
+  } else {
+    mexErrMsgIdAndTxt(
+      err_id[err_sampling], err_msg[err_sampling], sampling.c_str());
+  }
+
+  mxCheck<size_type>(std::greater_equal<size_type>(),
+    o->num_threads, 0, "num_threads");
+  mxCheck<size_type>(std::greater_equal<size_type>(),
+    o->batch_size, 1, "batch_size");
+  mxCheck<double>(std::greater_equal<double>(),
+    o->batch_beta, 0, "batch_beta");
+  mxCheck<size_type>(std::greater_equal<size_type>(),
+    o->eval_block_size, 1, "eval_block_size");
+  mxCheck<double>(std::greater_equal<double>(),
+    o->accel_kappa, 0, "accel_kappa");
+  mxCheck<double>(std::greater_equal<double>(),
+    o->checkpoint_wall_time, 0, "checkpoint_wall_time");
+}
+
+// Dense and sparse features
 template <typename Data,
+          typename Input,
           typename Output>
 inline void
-set_variables(
+set_feature_variables(
     const mxArray* opts,
-    feature_input<Data>& in,
+    Input& in,
     Output& out,
     model_info<mxArray*>& info,
     Data*& A,
@@ -565,6 +707,36 @@ set_variables(
   }
 }
 
+template <typename Data,
+          typename Output>
+inline void
+set_variables(
+    const mxArray* opts,
+    feature_input<Data>& in,
+    Output& out,
+    model_info<mxArray*>& info,
+    Data*& A,
+    Data*& W,
+    Data*& W0
+    ) {
+  set_feature_variables(opts, in, out, info, A, W, W0);
+}
+
+template <typename Data,
+          typename Output>
+inline void
+set_variables(
+    const mxArray* opts,
+    sparse_feature_input<Data>& in,
+    Output& out,
+    model_info<mxArray*>& info,
+    Data*& A,
+    Data*& W,
+    Data*& W0
+    ) {
+  set_feature_variables(opts, in, out, info, A, W, W0);
+}
+
 template <typename Data,
           template <typename> class Input,
           typename Output>
@@ -611,9 +783,20 @@ set_context(
   }
 
   set_stopping_criteria(opts, ctx);
+  set_solver_options(opts, ctx);
 
-  auto solver = sdca::make_solver(ctx);
-  solver.solve();
+  if (ctx.options.accelerate) {
+    auto solver = sdca::make_accelerated_solver(ctx);
+    solver.solve();
+  } else {
+    auto solver = sdca::make_solver(ctx);
+    std::string resume = mxGetFieldValueOrDefault(
+      opts, "resume", std::string());
+    if (!resume.empty()) {
+      solver.resume(resume);
+    }
+    solver.solve();
+  }
 
   add_info(opts, ctx, info);
   plhs[0] = mxCreateStruct(info.fields, "model");
@@ -765,6 +948,15 @@ set_input(
     labels = mxGetCell(prhs[1], 0);
   }
 
+  if (mxIsSparse(data) && !is_dual) {
+    // Matlab's sparse matrices are double and in the CSC format
+    validate_sparse_matrix(data);
+    set_output<double, Result>(plhs, prhs, opts, labels,
+      sdca::make_input_sparse_feature(mxGetM(data), mxGetN(data),
+        mxGetPr(data), mxGetIr(data), mxGetJc(data)));
+    return;
+  }
+
   validate_matrix<Data>(data, is_dual);
   Data* p_data = static_cast<Data*>(mxGetData(data));
   if (is_dual) {
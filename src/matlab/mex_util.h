@@ -94,6 +94,7 @@ enum err_index {
   err_precision,
   err_log_level,
   err_log_format,
+  err_sampling,
   err_help_arg,
   err_not_implemented
 };
@@ -127,6 +128,7 @@ static const char* err_id[] = {
   "LIBSDCA:precision",
   "LIBSDCA:log_level",
   "LIBSDCA:log_format",
+  "LIBSDCA:sampling",
   "LIBSDCA:help_arg",
   "LIBSDCA:not_implemented"
 };
@@ -160,6 +162,7 @@ static const char* err_msg[] = {
   "Unknown precision '%s'.",
   "Unknown log_level '%s'.",
   "Unknown log_format '%s'.",
+  "Unknown sampling '%s'.",
   "Unknown help argument '%s'.",
   "%s is not implemented yet."
 };
@@ -114,3 +114,65 @@ TEST(ProxKnapsackLEBiasedTest, test_prox_feasible_double) {
   test_prox_knapsack_le_biased_feasible<double>(-3, 3, 256);
 #endif
 }
+
+template <typename Type>
+inline void
+test_prox_knapsack_le_biased_compare_search(
+    const int pow_from, const int pow_to, const Type tol) {
+  std::mt19937 gen(1);
+  std::uniform_real_distribution<Type> d_lo(-2, 0.5);
+  std::uniform_real_distribution<Type> d_hi(-0.5, 2);
+  std::uniform_real_distribution<Type> d_rhs(-5, 5);
+  std::uniform_real_distribution<Type> d_rho(0.01, 2);
+
+  Type lo, hi, rhs, rho, eps;
+  std::vector<Type> v, x_sort, x_search;
+  for (int p = pow_from; p < pow_to; ++p) {
+    for (std::size_t n : {1, 2, 10, 100, 1000}) {
+      for (int i = 0; i < 20; ++i) {
+        v.clear();
+        test_populate_real(n, p, p + 1, static_cast<Type>(1), gen, v);
+        test_populate_real(n, p, p + 1, -static_cast<Type>(1), gen, v);
+        test_prox_knapsack_le_biased_set_params(
+          v, gen, d_lo, d_hi, d_rhs, d_rho, lo, hi, rhs, rho, eps);
+
+        // Only the case when the inequality is inactive goes to the search
+        auto t = sdca::thresholds_knapsack_eq(v.begin(), v.end(), lo, hi, rhs);
+        if (t.t >= rho * rhs) continue;
+
+        x_sort = v;
+        auto t_sort = sdca::thresholds_knapsack_le_biased_search_sort(
+          x_sort.begin(), x_sort.end(), lo, hi, rhs, rho);
+        x_search = v;
+        auto t_search = sdca::thresholds_knapsack_le_biased_search(
+          x_search.begin(), x_search.end(), lo, hi, rhs, rho);
+        ASSERT_NEAR(t_sort.t, t_search.t, tol * eps);
+
+        for (std::size_t k = 0; k < v.size(); ++k) {
+          ASSERT_NEAR(std::max(lo, std::min(v[k] - t_sort.t, hi)),
+                      std::max(lo, std::min(v[k] - t_search.t, hi)),
+                      tol * eps);
+        }
+      }
+    }
+  }
+}
+
+TEST(ProxKnapsackLEBiasedTest, test_search_float) {
+  test_prox_knapsack_le_biased_compare_search<float>(-3, 3, 256);
+}
+
+TEST(ProxKnapsackLEBiasedTest, test_search_double) {
+  test_prox_knapsack_le_biased_compare_search<double>(-3, 3, 256);
+}
+
+TEST(ProxKnapsackLEBiasedTest, test_search_at_rhs) {
+  // The solution t = 10 is at rho * rhs (x = [5, 5, 0, 0])
+  std::vector<double> v = {15.040874736545476, 15.048521043716388,
+                           9.9950112883918987, 9.9845023450654864};
+  auto t = sdca::thresholds_knapsack_le_biased_search(
+    v.begin(), v.end(), 0.0, 5.0, 10.0, 1.0);
+  EXPECT_NEAR(10.0, t.t, 16 * std::numeric_limits<double>::epsilon());
+  EXPECT_EQ(2, std::distance(v.begin(), t.first));
+  EXPECT_EQ(2, std::distance(v.begin(), t.last));
+}
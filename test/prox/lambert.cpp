@@ -155,3 +155,47 @@ TEST(LambertTest, omega_const) {
   long double omega = static_cast<long double>(sdca::kOmega);
   EXPECT_TRUE(std::abs(w_l - omega) < eps_l);
 }
+
+template <typename Type>
+inline void
+test_lambert_w_exp_array(const Type eps, const std::vector<Type>& v) {
+  std::vector<Type> w(v.size());
+  sdca::lambert_w_exp(v.size(), v.data(), w.data());
+  for (std::size_t k = 0; k < v.size(); ++k) {
+    const Type x = v[k];
+    if (x > 0) {
+      ASSERT_TRUE(std::abs(x - sdca::lambert_w_exp_inverse(w[k]))
+                  < eps * std::max(static_cast<Type>(1), x));
+    } else {
+      ASSERT_TRUE(std::abs(std::exp(x) - sdca::x_exp_x(w[k])) < eps);
+    }
+    ASSERT_TRUE(std::abs(w[k] - sdca::lambert_w_exp(x))
+                < eps * std::max(static_cast<Type>(1), w[k]));
+  }
+}
+
+TEST(LambertTest, lambert_w_exp_array_float) {
+  std::mt19937 gen(1);
+  float eps = 4 * std::numeric_limits<float>::epsilon();
+
+  std::vector<float> v;
+  test_populate_real(1000, -8, 8, 1.0f, gen, v);
+  test_populate_real(1000, -8, 8, -1.0f, gen, v);
+  test_add_0_1_eps_min_max(1.0f, v);
+  test_add_0_1_eps_min_max(-1.0f, v);
+  std::shuffle(v.begin(), v.end(), gen);
+  test_lambert_w_exp_array(eps, v);
+}
+
+TEST(LambertTest, lambert_w_exp_array_double) {
+  std::mt19937 gen(1);
+  double eps = 4 * std::numeric_limits<double>::epsilon();
+
+  std::vector<double> v;
+  test_populate_real(1000, -16, 16, 1.0, gen, v);
+  test_populate_real(1000, -16, 16, -1.0, gen, v);
+  test_add_0_1_eps_min_max(1.0, v);
+  test_add_0_1_eps_min_max(-1.0, v);
+  std::shuffle(v.begin(), v.end(), gen);
+  test_lambert_w_exp_array(eps, v);
+}
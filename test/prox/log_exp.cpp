@@ -161,3 +161,83 @@ TEST(LogExpTest, log_sum_exp_special_cases) {
   test_log_sum_exp_special_cases<double, double>(-16, 16);
   test_log_sum_exp_special_cases<long double, long double>(-24, 24, 1024);
 }
+
+template <typename Type,
+          typename Function,
+          typename Reference>
+inline void
+test_vector_math_ulp(const Type eps, const std::vector<Type>& v,
+                     Function fun, Reference ref) {
+  for (const Type x : v) {
+    const long double y = ref(static_cast<long double>(x));
+    ASSERT_TRUE(std::abs(static_cast<long double>(fun(x)) - y)
+                <= eps * std::abs(y)) << x;
+  }
+}
+
+template <typename Type>
+inline void
+test_vector_math(const int pow_from, const int pow_to) {
+  std::mt19937 gen(1);
+  Type eps = 4 * std::numeric_limits<Type>::epsilon();
+  auto exp_ref = [](const long double x){ return std::exp(x); };
+  auto log_ref = [](const long double x){ return std::log(x); };
+  auto log1p_ref = [](const long double x){ return std::log1p(x); };
+
+  // exp over the range where it is normal
+  std::vector<Type> v;
+  test_populate_real(1000, -8, 1, static_cast<Type>(1), gen, v);
+  test_populate_real(1000, -8, 1, -static_cast<Type>(1), gen, v);
+  std::uniform_real_distribution<Type> d(sdca::exp_traits<Type>::min_arg(),
+                                         sdca::exp_traits<Type>::max_arg());
+  for (int i = 0; i < 10000; ++i) {
+    v.push_back(d(gen));
+  }
+  v.push_back(sdca::exp_traits<Type>::min_arg());
+  v.push_back(sdca::exp_traits<Type>::max_arg());
+  test_vector_math_ulp(eps, v,
+    [](const Type x){ return sdca::vector_math_exp(x); }, exp_ref);
+  ASSERT_EQ(static_cast<Type>(1), sdca::vector_math_exp(static_cast<Type>(0)));
+  ASSERT_EQ(static_cast<Type>(0),
+            sdca::vector_math_exp(static_cast<Type>(-1) *
+                                  std::numeric_limits<Type>::max()));
+
+  // log and log1p
+  v.clear();
+  test_populate_real(100, pow_from, pow_to, static_cast<Type>(1), gen, v);
+  test_add_0_1_eps_min_max(static_cast<Type>(1), v);
+  v.erase(v.begin() + static_cast<long>(v.size()) - 5); // 0
+  test_vector_math_ulp(eps, v,
+    [](const Type x){ return sdca::vector_math_log(x); }, log_ref);
+  test_vector_math_ulp(eps, v,
+    [](const Type x){ return sdca::vector_math_log1p(x); }, log1p_ref);
+  v.clear();
+  test_populate_real(1000, -8, 0, -static_cast<Type>(1), gen, v);
+  test_vector_math_ulp(eps, v,
+    [](const Type x){ return sdca::vector_math_log1p(x); }, log1p_ref);
+  ASSERT_EQ(static_cast<Type>(0), sdca::vector_math_log1p(static_cast<Type>(0)));
+  ASSERT_EQ(static_cast<Type>(0), sdca::vector_x_log_x(static_cast<Type>(0)));
+  ASSERT_EQ(static_cast<Type>(0), sdca::vector_x_log_x(static_cast<Type>(-1)));
+}
+
+TEST(LogExpTest, vector_math_float) {
+  test_vector_math<float>(-37, 38);
+}
+
+TEST(LogExpTest, vector_math_double) {
+  test_vector_math<double>(-307, 308);
+}
+
+TEST(LogExpTest, sum_x_log_x) {
+  std::mt19937 gen(1);
+  std::vector<float> v;
+  test_populate_real(1000, -8, 8, 1.0f, gen, v);
+  test_populate_real(1000, -8, 8, -1.0f, gen, v);
+  double sum(0);
+  for (const float x : v) {
+    sum += sdca::x_log_x(2.0 - 0.5 * static_cast<double>(x));
+  }
+  double eps = 1024 * std::numeric_limits<double>::epsilon();
+  EXPECT_NEAR(sum, sdca::sum_x_log_x(v.begin(), v.end(), 2.0, -0.5),
+              eps * std::abs(sum));
+}
@@ -86,3 +86,63 @@ TEST(ProxTopKConeTest, test_prox_feasible_float) {
 TEST(ProxTopKConeTest, test_prox_feasible_double) {
   test_prox_topk_cone_feasible<double>(-6, 6, 1);
 }
+
+template <typename Type>
+inline void
+test_prox_topk_cone_compare_search(
+    const int pow_from, const int pow_to, const bool ties, const Type tol) {
+  std::mt19937 gen(1);
+  std::uniform_int_distribution<ptrdiff_t> d_k(1, 10);
+
+  Type eps;
+  ptrdiff_t k;
+  std::vector<Type> v, x_sort, x_search;
+  for (int p = pow_from; p < pow_to; ++p) {
+    for (std::size_t n : {5, 10, 100, 1000}) {
+      for (int i = 0; i < 20; ++i) {
+        v.clear();
+        test_populate_real(n, p, p + 1, static_cast<Type>(1), gen, v);
+        test_populate_real(n, p, p + 1, -static_cast<Type>(1), gen, v);
+        if (ties) {
+          Type scale = std::pow(static_cast<Type>(10), static_cast<Type>(p));
+          for (auto& x : v) x = scale * std::round(x / scale);
+        }
+        test_prox_topk_cone_set_params(v, gen, d_k, k, eps);
+
+        // Only the general case goes to the search
+        x_sort = v;
+        auto proj = sdca::topk_cone_special_cases(
+          x_sort.begin(), x_sort.end(), k, static_cast<Type>(k));
+        if (proj.projection != sdca::projection::general) continue;
+
+        auto t_sort = sdca::thresholds_topk_cone_search_sort<Type>(
+          x_sort.begin(), x_sort.end(), k);
+        x_search = v;
+        auto t_search = sdca::thresholds_topk_cone_search<Type>(
+          x_search.begin(), x_search.end(), k);
+
+        // hi is a sum over M and may be much larger than the data
+        Type tol_eps = tol * eps
+          * std::max(static_cast<Type>(1), std::abs(t_sort.hi));
+        ASSERT_NEAR(t_sort.t, t_search.t, tol_eps);
+        ASSERT_NEAR(t_sort.hi, t_search.hi, tol_eps);
+
+        for (std::size_t j = 0; j < v.size(); ++j) {
+          ASSERT_NEAR(std::max(Type(0), std::min(v[j] - t_sort.t, t_sort.hi)),
+            std::max(Type(0), std::min(v[j] - t_search.t, t_search.hi)),
+            tol_eps);
+        }
+      }
+    }
+  }
+}
+
+TEST(ProxTopKConeTest, test_search_float) {
+  test_prox_topk_cone_compare_search<float>(-3, 3, false, 1);
+  test_prox_topk_cone_compare_search<float>(-3, 3, true, 1);
+}
+
+TEST(ProxTopKConeTest, test_search_double) {
+  test_prox_topk_cone_compare_search<double>(-6, 6, false, 1);
+  test_prox_topk_cone_compare_search<double>(-6, 6, true, 1);
+}
@@ -0,0 +1,168 @@
+#include "sdca/prox/two_simplex.h"
+#include "test_util.h"
+
+template <typename Type>
+inline void
+test_prox_two_simplex_pivot_check_feasible(
+    const ptrdiff_t p,
+    const Type rhs,
+    const Type eps, std::vector<Type>& v) {
+  ASSERT_TRUE(p > 0);
+  ASSERT_TRUE(static_cast<std::size_t>(p) < v.size());
+  sdca::prox_two_simplex_pivot(v.begin(), v.begin() + p, v.end(), rhs);
+
+  Type lo(0), hi(rhs);
+  std::for_each(v.begin(), v.end(), [=](const Type x){
+    ASSERT_GE(x, lo); });
+  std::for_each(v.begin(), v.end(), [=](const Type x){
+    ASSERT_LE(x, hi); });
+
+  Type sum1 = std::accumulate(v.begin(), v.begin() + p, static_cast<Type>(0));
+  Type sum2 = std::accumulate(v.begin() + p, v.end(), static_cast<Type>(0));
+  ASSERT_LE(sum1, rhs + eps);
+  ASSERT_LE(sum2, rhs + eps);
+  ASSERT_NEAR(sum1, sum2, eps);
+}
+
+template <typename Type>
+inline void
+test_prox_two_simplex_pivot_set_params(
+    const std::vector<Type>& v,
+    std::mt19937& gen,
+    std::uniform_int_distribution<ptrdiff_t>& d_p,
+    std::uniform_real_distribution<Type>& d_rhs,
+    ptrdiff_t& p, Type& rhs, Type& eps) {
+  p = d_p(gen);
+  rhs = d_rhs(gen);
+  Type max(*std::max_element(v.begin(), v.end()));
+  eps = std::numeric_limits<Type>::epsilon()
+      * std::max(static_cast<Type>(1), std::abs(max))
+      * static_cast<Type>(v.size());
+}
+
+template <typename Type>
+inline void
+test_prox_two_simplex_pivot_feasible(
+    const int pow_from, const int pow_to, const Type tol) {
+  std::mt19937 gen(1);
+  std::uniform_int_distribution<ptrdiff_t> d_p(1, 10);
+  std::uniform_real_distribution<Type> d_rhs(0, 5);
+
+  ptrdiff_t p;
+  Type rhs, eps;
+  std::vector<Type> v;
+
+  // One special case (also test this in debug mode!)
+  p = 1;
+  rhs = 2;
+  v.push_back(static_cast<Type>(-0.49371069182389915));
+  for (int i = 0; i < 158; ++i) {
+    v.push_back(static_cast<Type>(0.49371069182390021));
+  }
+  eps = 4 * std::numeric_limits<Type>::epsilon() * static_cast<Type>(v.size());
+  test_prox_two_simplex_pivot_check_feasible(p, rhs, tol * eps, v);
+  v.clear();
+
+  for (int pow = pow_from; pow < pow_to; ++pow) {
+    v.clear();
+    for (int i = 0; i < 100; ++i) {
+      test_populate_real(100, pow, pow + 1, static_cast<Type>(1), gen, v);
+      test_prox_two_simplex_pivot_set_params(v, gen, d_p, d_rhs, p, rhs, eps);
+      test_prox_two_simplex_pivot_check_feasible(p, rhs, tol * eps, v);
+    }
+  }
+
+  for (int pow = pow_from; pow < pow_to; ++pow) {
+    v.clear();
+    for (int i = 0; i < 100; ++i) {
+      test_populate_real(100, pow, pow + 1, -static_cast<Type>(1), gen, v);
+      test_prox_two_simplex_pivot_set_params(v, gen, d_p, d_rhs, p, rhs, eps);
+      test_prox_two_simplex_pivot_check_feasible(p, rhs, tol * eps, v);
+    }
+  }
+
+  for (int pow = pow_from; pow < pow_to; ++pow) {
+    v.clear();
+    for (int i = 0; i < 100; ++i) {
+      test_populate_real(100, pow, pow + 1, static_cast<Type>(1), gen, v);
+      test_populate_real(100, pow, pow + 1, -static_cast<Type>(1), gen, v);
+      test_prox_two_simplex_pivot_set_params(v, gen, d_p, d_rhs, p, rhs, eps);
+      test_prox_two_simplex_pivot_check_feasible(p, rhs, tol * eps, v);
+    }
+  }
+
+  for (int i = 0; i < 100; ++i) {
+    for (int pow = pow_from; pow < pow_to; ++pow) {
+      test_populate_real(25, pow, pow + 1, static_cast<Type>(1), gen, v);
+      test_populate_real(25, pow, pow + 1, -static_cast<Type>(1), gen, v);
+      test_prox_two_simplex_pivot_set_params(v, gen, d_p, d_rhs, p, rhs, eps);
+      test_prox_two_simplex_pivot_check_feasible(p, rhs, tol * eps, v);
+    }
+  }
+}
+
+TEST(ProxTwoSimplexPivotTest, test_prox_feasible_float) {
+  test_prox_two_simplex_pivot_feasible<float>(-3, 3, 1);
+}
+
+TEST(ProxTwoSimplexPivotTest, test_prox_feasible_double) {
+  test_prox_two_simplex_pivot_feasible<double>(-6, 6, 1);
+}
+
+template <typename Type>
+inline void
+test_prox_two_simplex_pivot_compare_fix(
+    const int pow_from, const int pow_to, const bool ties, const Type tol) {
+  std::mt19937 gen(1);
+  std::uniform_real_distribution<Type> d_rhs(0, 5);
+
+  Type rhs, eps;
+  std::vector<Type> v, x_fix, x_pivot;
+  for (int pow = pow_from; pow < pow_to; ++pow) {
+    for (std::size_t n : {1, 10, 100, 1000}) {
+      std::uniform_int_distribution<ptrdiff_t> d_p(1,
+        static_cast<ptrdiff_t>(2 * n - 1));
+      for (int i = 0; i < 20; ++i) {
+        v.clear();
+        test_populate_real(n, pow, pow + 1, static_cast<Type>(1), gen, v);
+        test_populate_real(n, pow, pow + 1, -static_cast<Type>(1), gen, v);
+        std::shuffle(v.begin(), v.end(), gen);
+        if (ties) {
+          Type scale = std::pow(static_cast<Type>(10), static_cast<Type>(pow));
+          for (auto& x : v) x = scale * std::round(x / scale);
+        }
+        ptrdiff_t p = d_p(gen);
+        rhs = d_rhs(gen);
+        Type max(*std::max_element(v.begin(), v.end()));
+        eps = std::numeric_limits<Type>::epsilon()
+          * std::max(std::max(static_cast<Type>(1), rhs), std::abs(max))
+          * static_cast<Type>(v.size());
+
+        x_fix = v;
+        auto t_fix = sdca::thresholds_two_simplex_fix(x_fix.begin(),
+          x_fix.begin() + p, x_fix.begin() + p, x_fix.end(), rhs);
+        x_pivot = v;
+        auto t_pivot = sdca::thresholds_two_simplex_pivot(x_pivot.begin(),
+          x_pivot.begin() + p, x_pivot.begin() + p, x_pivot.end(), rhs);
+
+        for (ptrdiff_t j = 0; j < static_cast<ptrdiff_t>(v.size()); ++j) {
+          auto& t = (j < p) ? t_fix.first : t_fix.second;
+          auto& s = (j < p) ? t_pivot.first : t_pivot.second;
+          ASSERT_NEAR(std::max(Type(0), std::min(v[j] - t.t, t.hi)),
+                      std::max(Type(0), std::min(v[j] - s.t, s.hi)),
+                      tol * eps);
+        }
+      }
+    }
+  }
+}
+
+TEST(ProxTwoSimplexPivotTest, test_compare_fix_float) {
+  test_prox_two_simplex_pivot_compare_fix<float>(-3, 3, false, 1);
+  test_prox_two_simplex_pivot_compare_fix<float>(-3, 3, true, 1);
+}
+
+TEST(ProxTwoSimplexPivotTest, test_compare_fix_double) {
+  test_prox_two_simplex_pivot_compare_fix<double>(-6, 6, false, 1);
+  test_prox_two_simplex_pivot_compare_fix<double>(-6, 6, true, 1);
+}
@@ -108,3 +108,11 @@ TEST(ProxTwoSimplexSortTest, test_prox_feasible_float) {
 TEST(ProxTwoSimplexSortTest, test_prox_feasible_double) {
   test_prox_two_simplex_sort_feasible<double>(-6, 6, 1);
 }
+
+TEST(ProxTwoSimplexSortTest, test_prox_zero) {
+  // max(a) + max(b) <= 0, so the solution is x = y = 0
+  std::vector<double> v = {0.55, -0.25, -3.0, -0.75};
+  sdca::prox_two_simplex_sort(v.begin(), v.begin() + 2, v.end(), 4.0);
+  std::for_each(v.begin(), v.end(), [](const double x){
+    ASSERT_EQ(0, x); });
+}
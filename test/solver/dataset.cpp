@@ -1,4 +1,8 @@
+#include <thread>
+
 #include "sdca/solver/data.h"
+#include "sdca/solver/data/dataset_file.h"
+#include "sdca/solver/data/libsvm_file.h"
 #include "test_util.h"
 
 
@@ -236,3 +240,399 @@ TEST(SolverDatasetTest, kernel_in_multilabel_out) {
   EXPECT_TRUE((std::is_same<sdca::eval_test<float, sdca::multilabel_output>,
                tst_eval_type>::value));
 }
+
+
+TEST(SolverDatasetTest, dataset_file_feature_multiclass) {
+  sdca::size_type n = 50, m = 3, d = 5, pow_from = 0, pow_to = 1;
+  std::vector<float> features;
+  std::vector<sdca::size_type> labels;
+
+  std::mt19937 gen(1);
+  test_populate_real(n * d, pow_from, pow_to, 1.0f, gen, features);
+  test_populate_int<sdca::size_type>(n, 1, m, gen, labels);
+
+  const std::string path = "test_dataset_file.bin";
+  auto out = sdca::make_output_multiclass(labels.begin(), labels.end());
+  sdca::write_dataset_file(path,
+    sdca::make_input_feature(d, n, &features[0]), out);
+
+  {
+    sdca::dataset_file file(path);
+    file.advise(sdca::access_pattern::random);
+    EXPECT_FALSE(file.is_kernel());
+    EXPECT_FALSE(file.is_multilabel());
+
+    // The features are not copied and are aligned to a page
+    auto in = file.features<float>();
+    EXPECT_EQ(d, in.num_dimensions);
+    EXPECT_EQ(n, in.num_examples);
+    EXPECT_EQ(0U, reinterpret_cast<std::uintptr_t>(in.features) % 4096);
+    for (sdca::size_type i = 0; i < n * d; ++i) {
+      ASSERT_EQ(features[i], in.features[i]);
+    }
+
+    auto mapped_out = file.multiclass();
+    EXPECT_EQ(m, mapped_out.num_classes);
+    EXPECT_TRUE(out.labels == mapped_out.labels);
+    EXPECT_EQ(n + 1, file.multilabel().offsets.size());
+
+    // Another input type or precision
+    EXPECT_THROW(file.features<double>(), std::invalid_argument);
+    EXPECT_THROW(file.kernel<float>(), std::invalid_argument);
+  }
+
+  // Truncated file
+  {
+    std::ifstream src(path, std::ios::binary);
+    std::vector<char> bytes((std::istreambuf_iterator<char>(src)),
+                            std::istreambuf_iterator<char>());
+    std::ofstream dst(path, std::ios::binary | std::ios::trunc);
+    dst.write(bytes.data(), static_cast<std::streamsize>(bytes.size() / 2));
+  }
+  EXPECT_THROW(sdca::dataset_file file(path), std::runtime_error);
+  EXPECT_THROW(sdca::dataset_file file(path + ".missing"), std::runtime_error);
+  std::remove(path.c_str());
+}
+
+
+// Rewrites the header of a valid dataset file
+template <typename Edit>
+void
+test_edit_dataset_header(
+    const std::string& path,
+    const Edit& edit
+  ) {
+  std::fstream file(path, std::ios::binary | std::ios::in | std::ios::out);
+  sdca::dataset_file_header header;
+  file.read(reinterpret_cast<char*>(&header), sizeof(header));
+  edit(header);
+  file.seekp(0);
+  file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+}
+
+
+TEST(SolverDatasetTest, dataset_file_invalid_header) {
+  sdca::size_type n = 50, m = 3, d = 5;
+  std::vector<float> features(n * d, 1.0f);
+  std::vector<sdca::size_type> labels;
+  std::mt19937 gen(1);
+  test_populate_int<sdca::size_type>(n, 1, m, gen, labels);
+
+  const std::string path = "test_dataset_file.bin";
+  auto write = [&]() {
+    sdca::write_dataset_file(path, sdca::make_input_feature(d, n, &features[0]),
+      sdca::make_output_multiclass(labels.begin(), labels.end()));
+  };
+
+  // A multiclass file needs one label per example
+  write();
+  test_edit_dataset_header(path, [](sdca::dataset_file_header& h) {
+    h.num_examples -= 1;
+  });
+  EXPECT_THROW(sdca::dataset_file file(path), std::runtime_error);
+
+  // The size of the matrix overflows (2^62 * 50 * 4 = 0 mod 2^64)
+  write();
+  test_edit_dataset_header(path, [](sdca::dataset_file_header& h) {
+    h.num_rows = static_cast<std::uint64_t>(1) << 62;
+  });
+  EXPECT_THROW(sdca::dataset_file file(path), std::runtime_error);
+
+  // The size of the labels overflows
+  write();
+  test_edit_dataset_header(path, [](sdca::dataset_file_header& h) {
+    h.num_labels = std::numeric_limits<std::uint64_t>::max() / 4;
+    h.num_examples = h.num_labels;
+    h.num_rows = 0;
+  });
+  EXPECT_THROW(sdca::dataset_file file(path), std::runtime_error);
+
+  write();
+  EXPECT_NO_THROW(sdca::dataset_file file(path));
+  std::remove(path.c_str());
+}
+
+
+TEST(SolverDatasetTest, dataset_file_kernel_multilabel) {
+  std::vector<double> kernel;
+  std::vector<std::vector<sdca::size_type>> labels;
+
+  sdca::size_type n = 6, pow_from = 0, pow_to = 1;
+  labels = { {1, 2}, {3}, {1, 2}, {1, 3}, {2, 3}, {2, 3, 4} };
+
+  std::mt19937 gen(1);
+  test_populate_real(n * n, pow_from, pow_to, 1.0, gen, kernel);
+
+  const std::string path = "test_dataset_file.bin";
+  auto out = sdca::make_output_multilabel(labels);
+  sdca::write_dataset_file(path, sdca::make_input_kernel(n, &kernel[0]), out);
+
+  sdca::dataset_file file(path);
+  EXPECT_TRUE(file.is_kernel());
+  EXPECT_TRUE(file.is_multilabel());
+
+  auto in = file.kernel<double>();
+  EXPECT_EQ(n, in.num_train_examples);
+  EXPECT_EQ(n, in.num_examples);
+  for (sdca::size_type i = 0; i < n * n; ++i) {
+    ASSERT_EQ(kernel[i], in.kernel[i]);
+  }
+
+  auto mapped_out = file.multilabel();
+  EXPECT_EQ(out.num_classes, mapped_out.num_classes);
+  EXPECT_TRUE(out.labels == mapped_out.labels);
+  EXPECT_TRUE(out.offsets == mapped_out.offsets);
+  EXPECT_THROW(file.multiclass(), std::invalid_argument);
+  std::remove(path.c_str());
+}
+
+
+TEST(SolverDatasetTest, kernel_cache) {
+  sdca::size_type n = 6, d = 3;
+  std::vector<double> X = {1, 0, 0,  0, 1, 0,  0, 0, 1,
+                           1, 1, 0,  0, 1, 1,  1, 1, 1};
+  sdca::kernel_function<double> chi2(sdca::kernel_type::chi_squared);
+  sdca::kernel_cache<double> cache(d, n, &X[0], chi2, 2 * n * sizeof(double));
+  EXPECT_EQ(2, cache.capacity());
+
+  // Columns are computed once while they are in the cache
+  auto K0 = cache.column(0, &X[0]);
+  auto K5 = cache.column(5, &X[15]);
+  EXPECT_EQ(2, cache.num_misses());
+  EXPECT_EQ(K0, cache.column(0, &X[0]));
+  EXPECT_EQ(1, cache.num_hits());
+  for (sdca::size_type j = 0; j < n; ++j) {
+    EXPECT_DOUBLE_EQ(chi2(d, &X[d * j], &X[0]), (*K0)[j]);
+    EXPECT_DOUBLE_EQ(chi2(d, &X[d * j], &X[15]), (*K5)[j]);
+  }
+  EXPECT_DOUBLE_EQ(1, (*K5)[0]);
+  EXPECT_DOUBLE_EQ(3, cache.diagonal(&X[15]));
+
+  // The least recently used column (5) is evicted, but stays valid
+  cache.column(1, &X[3]);
+  cache.column(0, &X[0]);
+  EXPECT_EQ(2, cache.num_hits());
+  cache.column(5, &X[15]);
+  EXPECT_EQ(4, cache.num_misses());
+  EXPECT_DOUBLE_EQ(1, (*K5)[0]);
+}
+
+
+TEST(SolverDatasetTest, kernel_cache_reuse) {
+  sdca::size_type n = 6, d = 3;
+  std::vector<double> X = {1, 0, 0,  0, 1, 0,  0, 0, 1,
+                           1, 1, 0,  0, 1, 1,  1, 1, 1};
+  sdca::kernel_function<double> rbf(sdca::kernel_type::rbf);
+  sdca::kernel_cache<double> cache(d, n, &X[0], rbf, n * sizeof(double));
+  EXPECT_EQ(1, cache.num_shards());
+
+  // The buffer of an evicted column is reused once it is released
+  const double* K0 = cache.column(0, &X[0])->data();
+  auto K1 = cache.column(1, &X[3]);
+  EXPECT_EQ(K0, K1->data());
+  for (sdca::size_type j = 0; j < n; ++j) {
+    EXPECT_DOUBLE_EQ(rbf(d, &X[d * j], &X[3]), (*K1)[j]);
+  }
+
+  // ... but not while it is referenced
+  auto K2 = cache.column(2, &X[6]);
+  EXPECT_NE(K1->data(), K2->data());
+  EXPECT_DOUBLE_EQ(1, (*K1)[1]);
+}
+
+
+TEST(SolverDatasetTest, kernel_cache_threads) {
+  sdca::size_type n = 100, d = 5, num_threads = 4, num_rounds = 20;
+  std::vector<double> X;
+  std::mt19937 gen(1);
+  test_populate_real(n * d, 0, 1, 1.0, gen, X);
+  sdca::kernel_function<double> rbf(sdca::kernel_type::rbf, 0.01);
+
+  // The columns are split into shards with their own locks
+  sdca::kernel_cache<double> cache(d, n, &X[0], rbf,
+                                   n / 2 * n * sizeof(double));
+  EXPECT_EQ(n / 2, cache.capacity());
+  EXPECT_EQ(6, cache.num_shards());
+
+  std::vector<sdca::size_type> num_errors(num_threads);
+  std::vector<std::thread> threads;
+  for (sdca::size_type t = 0; t < num_threads; ++t) {
+    threads.emplace_back([&, t]() {
+      for (sdca::size_type r = 0; r < num_rounds; ++r) {
+        for (sdca::size_type k = 0; k < n; ++k) {
+          const sdca::size_type i = (k * 7 + t * 13 + r) % n;
+          auto K = cache.column(i, &X[d * i]);
+          const sdca::size_type j = (i + r) % n;
+          if (std::abs(rbf(d, &X[d * j], &X[d * i]) - (*K)[j]) > 1e-12) {
+            ++num_errors[t];
+          }
+        }
+      }
+    });
+  }
+  for (auto& thread : threads) thread.join();
+
+  EXPECT_EQ(std::vector<sdca::size_type>(num_threads), num_errors);
+  EXPECT_EQ(num_threads * num_rounds * n,
+            cache.num_hits() + cache.num_misses());
+  EXPECT_GT(cache.num_hits(), 0UL);
+}
+
+
+TEST(SolverDatasetTest, libsvm_file_multiclass) {
+  const std::string path = "test_libsvm_file.txt";
+  {
+    std::ofstream text(path);
+    text << "# comment\n"
+            "2 1:0.5 3:-1.25e-1 # comment\n"
+            "\n"
+            "1 qid:7 2:3\r\n"
+            "3.0 1:1E2 2:+.5 3:0\n"
+            "1";
+  }
+  sdca::libsvm_options options;
+  options.num_threads = 1;
+  sdca::libsvm_file<double> file(path, options);
+  EXPECT_EQ(3, file.num_dimensions());
+  EXPECT_EQ(4, file.num_examples());
+  EXPECT_EQ(6, file.num_nonzeros());
+  EXPECT_FALSE(file.is_multilabel());
+
+  std::vector<double> X;
+  auto in = file.dense_features(X);
+  std::vector<double> expected = {0.5, 0, -0.125,  0, 3, 0,
+                                  100, 0.5, 0,  0, 0, 0};
+  EXPECT_EQ(3, in.num_dimensions);
+  EXPECT_TRUE(expected == X);
+  auto sparse = file.sparse_features();
+  EXPECT_EQ(6, sparse.num_nonzeros());
+  EXPECT_EQ(1, sparse.indices[2]);
+
+  auto out = file.multiclass();
+  EXPECT_EQ(3, out.num_classes);
+  EXPECT_TRUE((std::vector<sdca::size_type>{1, 0, 2, 0}) == out.labels);
+
+  // A test set with the dimensions of the training set
+  options.num_dimensions = 5;
+  EXPECT_EQ(5, sdca::libsvm_file<float>(path, options).num_dimensions());
+  options.num_dimensions = 2;
+  EXPECT_THROW(sdca::libsvm_file<float>(path, options), std::runtime_error);
+
+  {
+    std::ofstream text(path);
+    text << "1 1:0.5\n2 0:1\n";
+  }
+  EXPECT_THROW(sdca::libsvm_file<float> f(path), std::runtime_error);
+  {
+    std::ofstream text(path);
+    text << "1 1:0.5\n2 2:x\n";
+  }
+  EXPECT_THROW(sdca::libsvm_file<float> f(path), std::runtime_error);
+  EXPECT_THROW(sdca::libsvm_file<float> f(path + ".missing"),
+               std::runtime_error);
+  std::remove(path.c_str());
+}
+
+
+TEST(SolverDatasetTest, libsvm_file_binary) {
+  const std::string path = "test_libsvm_file.txt";
+  {
+    std::ofstream text(path);
+    text << "-1 1:0.5\n"
+            "+1 2:3\n"
+            "1 1:1\n"
+            "-1.0 2:2\n";
+  }
+  sdca::libsvm_options options;
+  options.num_threads = 1;
+  sdca::libsvm_file<double> file(path, options);
+  EXPECT_EQ(4, file.num_examples());
+  EXPECT_TRUE((std::vector<sdca::size_type>{0, 1, 1, 0}) == file.labels());
+  auto out = file.multiclass();
+  EXPECT_EQ(2, out.num_classes);
+  EXPECT_TRUE((std::vector<sdca::size_type>{0, 1, 1, 0}) == out.labels);
+
+  // The labels are mapped after the ranges of the threads are merged
+  sdca::size_type n = 20000;
+  std::vector<sdca::size_type> labels;
+  {
+    std::ofstream text(path);
+    for (sdca::size_type i = 0; i < n; ++i) {
+      labels.push_back((i % 3 == 0) ? 1 : 0);
+      text << ((i % 3 == 0) ? "+1" : "-1") << " 1:0.5\n";
+    }
+  }
+  options.num_threads = 4;
+  EXPECT_TRUE(labels == sdca::libsvm_file<float>(path, options).labels());
+
+  // Other negative labels are invalid
+  for (const char* line : {"-2 1:1\n1 1:1\n", "0 1:1\n-1 1:1\n",
+                           "2 1:1\n-1 1:1\n", "-1,1 1:1\n"}) {
+    {
+      std::ofstream text(path);
+      text << line;
+    }
+    EXPECT_THROW(sdca::libsvm_file<float> f(path), std::runtime_error);
+  }
+  std::remove(path.c_str());
+}
+
+
+TEST(SolverDatasetTest, libsvm_file_multilabel_parallel) {
+  sdca::size_type n = 5000, d = 20;
+  std::vector<double> features;
+  std::vector<sdca::size_type> labels;
+  std::mt19937 gen(1);
+  test_populate_real(n * d, 0, 1, 1.0, gen, features);
+  test_populate_int<sdca::size_type>(n, 1, 4, gen, labels);
+
+  // Random sparsity, reals in several formats and multiple labels
+  const std::string path = "test_libsvm_file.txt";
+  {
+    std::ofstream file(path);
+    for (sdca::size_type i = 0; i < n; ++i) {
+      file << labels[i];
+      if (labels[i] > 1) file << "," << labels[i] + 1;
+      for (sdca::size_type k = 0; k < d; ++k) {
+        double& x = features[d * i + k];
+        if ((i + k) % 3 == 0) {
+          x = 0;
+        } else {
+          x *= std::pow(10.0, static_cast<int>((i + k) % 9) - 4);
+          if ((i * k) % 5 == 0) x = -x;
+          std::ostringstream str;
+          str.precision((k % 3) ? 6 : 17);
+          str << ((k % 2) ? std::scientific : std::defaultfloat) << x;
+          x = std::strtod(str.str().c_str(), nullptr);
+          file << " " << k + 1 << ":" << str.str();
+        }
+      }
+      file << "\n";
+    }
+  }
+
+  sdca::libsvm_options options;
+  options.num_threads = 1;
+  sdca::libsvm_file<double> serial(path, options);
+  options.num_threads = 4;
+  sdca::libsvm_file<double> parallel(path, options);
+  EXPECT_EQ(n, parallel.num_examples());
+  EXPECT_EQ(d, parallel.num_dimensions());
+  EXPECT_TRUE(parallel.is_multilabel());
+  EXPECT_TRUE(serial.values() == parallel.values());
+  EXPECT_TRUE(serial.indices() == parallel.indices());
+  EXPECT_TRUE(serial.offsets() == parallel.offsets());
+  EXPECT_TRUE(serial.labels() == parallel.labels());
+  EXPECT_TRUE(serial.label_offsets() == parallel.label_offsets());
+
+  // The values are parsed as by strtod
+  std::vector<double> X;
+  parallel.dense_features(X);
+  EXPECT_TRUE(features == X);
+
+  auto out = parallel.multilabel();
+  EXPECT_EQ(5, out.num_classes);
+  EXPECT_EQ(n + 1, out.offsets.size());
+  EXPECT_THROW(parallel.multiclass(), std::invalid_argument);
+  std::remove(path.c_str());
+}
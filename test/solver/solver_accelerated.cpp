@@ -0,0 +1,65 @@
+#include "sdca/solver.h"
+#include "test_util.h"
+
+
+template <typename Data,
+          typename Result,
+          template <typename, typename> class Objective>
+inline void
+test_solver_accelerated(
+    Objective<Data, Result> objective,
+    const bool is_prox
+  ) {
+  sdca::size_type n = 200, m = 5, d = 20;
+  std::vector<Data> X;
+  std::vector<sdca::size_type> Y;
+
+  std::mt19937 gen(1);
+  test_populate_multiclass(n, d, m, gen, X, Y);
+
+  // Prox center W0 = X * A0' for some dual variables A0
+  std::vector<Data> W0(d * m), A0(m * n);
+  if (is_prox) {
+    test_populate_real(m * n, -3, -2, static_cast<Data>(1), gen, A0);
+    sdca::sdca_blas_gemm(static_cast<sdca::blas_int>(d),
+      static_cast<sdca::blas_int>(m), static_cast<sdca::blas_int>(n),
+      &X[0], static_cast<sdca::blas_int>(d), &A0[0],
+      static_cast<sdca::blas_int>(m), &W0[0], CblasNoTrans, CblasTrans);
+  }
+
+  sdca::size_type epochs[2];
+  sdca::eval_train<Result, sdca::multiclass_output> evals[2];
+  for (int accelerate = 0; accelerate < 2; ++accelerate) {
+    std::vector<Data> W(W0), A(m * n);
+    auto ctx = sdca::make_context(
+      sdca::make_input_feature(d, n, &X[0]),
+      sdca::make_output_multiclass(Y.begin(), Y.end()),
+      Objective<Data, Result>(objective), &A[0], &W[0]);
+    if (is_prox) ctx.primal_initial = &W0[0];
+    ctx.criteria.epsilon = 1e-4;
+    ctx.criteria.max_epoch = 10000;
+    ctx.options.accelerate = accelerate > 0;
+    sdca::make_accelerated_solver(ctx).solve();
+    EXPECT_TRUE(ctx.status == sdca::solver_status::solved);
+    epochs[accelerate] = ctx.epoch;
+    evals[accelerate] = ctx.train.evals.back();
+    test_expect_primal_consistent(d, m, n, X, A, W0, W, 1e-2);
+  }
+
+  test_expect_same_primal(evals[0], evals[1], 2e-4);
+  EXPECT_LT(epochs[1], epochs[0]);
+}
+
+
+TEST(SolverAcceleratedTest, plain_and_prox) {
+  sdca::logging::set_level(sdca::logging::level::warning);
+  sdca::logging::set_format(sdca::logging::format::short_e);
+  for (bool is_prox : {false, true}) {
+    test_solver_accelerated(
+      sdca::make_objective_l2_topk_hinge_smooth<double, double>(100), is_prox);
+    test_solver_accelerated(
+      sdca::make_objective_l2_entropy<double, double>(100), is_prox);
+    test_solver_accelerated(
+      sdca::make_objective_l2_entropy<float, double>(100), is_prox);
+  }
+}
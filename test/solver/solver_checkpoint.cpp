@@ -0,0 +1,131 @@
+#include "sdca/solver.h"
+#include "test_util.h"
+
+
+template <typename Data,
+          typename Result>
+inline void
+test_solver_checkpoint(
+    const sdca::solver_options& options
+  ) {
+  sdca::size_type n = 200, m = 5, d = 20;
+  std::vector<Data> X;
+  std::vector<sdca::size_type> Y;
+
+  std::mt19937 gen(1);
+  test_populate_multiclass(n, d, m, gen, X, Y);
+  auto make_context = [&](std::vector<Data>& A, std::vector<Data>& W) {
+    A.assign(m * n, 0);
+    W.assign(d * m, 0);
+    auto ctx = sdca::make_context(
+      sdca::make_input_feature(d, n, &X[0]),
+      sdca::make_output_multiclass(Y.begin(), Y.end()),
+      sdca::make_objective_l2_topk_hinge<Data, Result>(10, 1), &A[0], &W[0]);
+    ctx.criteria.epsilon = 1e-16;
+    ctx.criteria.eval_epoch = 7;
+    ctx.options = options;
+    return ctx;
+  };
+  const std::string path = "test_solver_checkpoint.bin";
+
+  // Uninterrupted run
+  std::vector<Data> A_ref, W_ref;
+  auto ref = make_context(A_ref, W_ref);
+  ref.criteria.max_epoch = 40;
+  sdca::make_solver(ref).solve();
+
+  // Interrupted run with periodic checkpoints and one at the end
+  std::vector<Data> A_first, W_first;
+  auto first = make_context(A_first, W_first);
+  first.criteria.max_epoch = 25;
+  first.options.checkpoint_path = path;
+  first.options.checkpoint_epoch = 5;
+  sdca::make_solver(first).solve();
+
+  // Resumed run continues bit-identically
+  std::vector<Data> A, W;
+  auto ctx = make_context(A, W);
+  ctx.criteria.max_epoch = 40;
+  auto solver = sdca::make_solver(ctx);
+  solver.resume(path);
+  EXPECT_EQ(first.epoch, ctx.epoch);
+  EXPECT_EQ(first.num_updates, ctx.num_updates);
+  EXPECT_EQ(first.train.evals.size(), ctx.train.evals.size());
+  solver.solve();
+  EXPECT_EQ(ref.epoch, ctx.epoch);
+  EXPECT_EQ(ref.num_updates, ctx.num_updates);
+  for (sdca::size_type i = 0; i < A.size(); ++i) {
+    ASSERT_EQ(A_ref[i], A[i]);
+  }
+  for (sdca::size_type i = 0; i < W.size(); ++i) {
+    ASSERT_EQ(W_ref[i], W[i]);
+  }
+
+  // A converged run is not solved again on resume
+  std::vector<Data> A_done, W_done;
+  auto done = make_context(A_done, W_done);
+  done.criteria.epsilon = 1e-3;
+  done.options.checkpoint_path = path;
+  sdca::make_solver(done).solve();
+  ASSERT_TRUE(done.status == sdca::solver_status::solved);
+  auto again = make_context(A, W);
+  auto again_solver = sdca::make_solver(again);
+  again_solver.resume(path);
+  again_solver.solve();
+  EXPECT_TRUE(again.status == sdca::solver_status::solved);
+  EXPECT_EQ(done.epoch, again.epoch);
+  EXPECT_EQ(done.num_updates, again.num_updates);
+  EXPECT_EQ(done.train.evals.size(), again.train.evals.size());
+  for (sdca::size_type i = 0; i < A.size(); ++i) {
+    ASSERT_EQ(A_done[i], A[i]);
+  }
+
+  // Corrupted checkpoints and mismatched problems are detected
+  std::uint64_t offset = 0;
+  {
+    sdca::checkpoint_reader reader(path);
+    for (const auto& entry : reader.entries()) {
+      if (entry.id == static_cast<std::uint32_t>(
+            sdca::checkpoint_section::dual_variables)) {
+        offset = entry.offset + entry.size / 2;
+      }
+    }
+  }
+  ASSERT_GT(offset, 0UL);
+  {
+    std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+    file.seekp(static_cast<std::streamoff>(offset));
+    file.put('\x7f');
+  }
+  auto other = make_context(A, W);
+  EXPECT_THROW(sdca::make_solver(other).resume(path), std::runtime_error);
+  EXPECT_THROW(sdca::make_solver(other).resume(path + ".missing"),
+               std::runtime_error);
+
+  // A corrupted number of sections is rejected before it is allocated
+  for (std::uint32_t num_sections : {10U, 0xFFFFFFFFU}) {
+    {
+      std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+      file.seekp(static_cast<std::streamoff>(
+        offsetof(sdca::checkpoint_header, num_sections)));
+      file.write(reinterpret_cast<const char*>(&num_sections),
+                 sizeof(num_sections));
+    }
+    EXPECT_THROW(sdca::checkpoint_reader reader(path), std::runtime_error);
+  }
+  std::remove(path.c_str());
+}
+
+
+TEST(SolverCheckpointTest, resume) {
+  sdca::logging::set_level(sdca::logging::level::warning);
+  sdca::logging::set_format(sdca::logging::format::short_e);
+  sdca::solver_options options;
+  test_solver_checkpoint<float, double>(options);
+  test_solver_checkpoint<double, double>(options);
+
+  options.sampling = sdca::sampling_type::adaptive;
+  options.shrink_visits = 2;
+  options.checkpoint_page_aligned = true;
+  test_solver_checkpoint<double, double>(options);
+}
@@ -0,0 +1,169 @@
+#include "sdca/solver.h"
+#include "sdca/solver/data/quantized_features.h"
+#include "test_util.h"
+
+
+template <typename Data,
+          typename Result>
+inline void
+test_solver_fourier_features(
+    const sdca::solver_options& options
+  ) {
+  sdca::size_type n = 200, m = 4, d = 5, D = 300;
+  std::vector<Data> X;
+  std::vector<sdca::size_type> Y;
+
+  std::mt19937 gen(1);
+  test_populate_multiclass(n, d, m, gen, X, Y);
+  auto transform = std::make_shared<sdca::random_fourier_features<Data>>(
+    d, D, 0.5, 7);
+
+  // The reference materializes Z = z(X)
+  std::vector<Data> Z(D * n);
+  transform->transform(n, &X[0], &Z[0]);
+  std::vector<Data> W_ref(D * m), A_ref(m * n);
+  auto ref = sdca::make_context(sdca::make_input_feature(D, n, &Z[0]),
+    sdca::make_output_multiclass(Y.begin(), Y.end()),
+    sdca::make_objective_l2_entropy<Data, Result>(1), &A_ref[0], &W_ref[0]);
+  ref.options = options;
+  ref.criteria.epsilon = 1e-5;
+  sdca::make_solver(ref).solve();
+
+  std::vector<Data> W(D * m), A(m * n);
+  auto ctx = sdca::make_context(
+    sdca::make_input_fourier_feature(n, &X[0], transform),
+    sdca::make_output_multiclass(Y.begin(), Y.end()),
+    sdca::make_objective_l2_entropy<Data, Result>(1), &A[0], &W[0]);
+  ctx.add_test(sdca::make_input_fourier_feature(n, &X[0], transform),
+    sdca::make_output_multiclass(Y.begin(), Y.end()));
+  ctx.options = options;
+  ctx.criteria.epsilon = 1e-5;
+  sdca::make_solver(ctx).solve();
+  EXPECT_TRUE(ctx.status == sdca::solver_status::solved);
+
+  test_expect_same_primal(ref.train.evals.back(), ctx.train.evals.back(), 1e-4);
+  test_expect_test_as_train(ctx, 1e-4);
+  test_expect_primal_consistent(D, m, n, Z, A, std::vector<Data>(), W, 1e-3);
+}
+
+
+TEST(SolverInputTest, fourier_features) {
+  sdca::logging::set_level(sdca::logging::level::warning);
+  sdca::logging::set_format(sdca::logging::format::short_e);
+
+  // The features approximate the rbf kernel
+  sdca::size_type d = 3, D = 20000;
+  std::vector<double> x = {0.1, -0.2, 0.3}, y = {0.4, 0.1, -0.1};
+  sdca::random_fourier_features<double> features(d, D, 0.5);
+  std::vector<double> zx(D), zy(D);
+  features.transform(1, &x[0], &zx[0]);
+  features.transform(1, &y[0], &zy[0]);
+  double dist2 = 0.09 + 0.09 + 0.16;
+  EXPECT_NEAR(std::exp(-0.5 * dist2), sdca::sdca_blas_dot(
+    static_cast<sdca::blas_int>(D), &zx[0], &zy[0]), 0.02);
+
+  sdca::solver_options options;
+  test_solver_fourier_features<float, double>(options);
+  test_solver_fourier_features<double, double>(options);
+
+  options.num_threads = 2;
+  test_solver_fourier_features<double, double>(options);
+}
+
+
+template <typename Data,
+          typename Result>
+inline void
+test_solver_quantized(
+    const sdca::quantization_type type,
+    const sdca::quantization_scale scale,
+    const sdca::solver_options& options
+  ) {
+  sdca::size_type n = 200, m = 4, d = 30;
+  std::vector<Data> X;
+  std::vector<sdca::size_type> Y;
+
+  std::mt19937 gen(1);
+  test_populate_real(n * d, -1, 1, static_cast<Data>(1), gen, X);
+  test_populate_int<sdca::size_type>(n, 0, m - 1, gen, Y);
+  sdca::quantized_features<Data> quantized(d, n, &X[0], type, scale);
+  auto in = quantized.input();
+  EXPECT_LT(quantized.num_bytes(), n * d * sizeof(Data));
+
+  // The reference solves with the dequantized features
+  std::vector<Data> X_q(d * n);
+  in.dequantize(0, n, &X_q[0]);
+  for (sdca::size_type i = 0; i < d * n; ++i) {
+    double x = static_cast<double>(X[i]);
+    ASSERT_NEAR(x, static_cast<double>(X_q[i]), 0.05 * (1 + std::abs(x)));
+  }
+  for (sdca::size_type i = 0; i < n; i += 17) {
+    const Data* x_i = &X_q[d * i];
+    double norm2 = static_cast<double>(sdca::sdca_blas_dot(
+      static_cast<sdca::blas_int>(d), x_i, x_i));
+    EXPECT_NEAR(norm2, static_cast<double>(in.norm2(i)), 1e-5 * norm2);
+  }
+
+  std::vector<Data> W_ref(d * m), A_ref(m * n);
+  auto ref = sdca::make_context(sdca::make_input_feature(d, n, &X_q[0]),
+    sdca::make_output_multiclass(Y.begin(), Y.end()),
+    sdca::make_objective_l2_entropy<Data, Result>(1), &A_ref[0], &W_ref[0]);
+  ref.options = options;
+  ref.criteria.epsilon = 1e-5;
+  sdca::make_solver(ref).solve();
+
+  std::vector<Data> W(d * m), A(m * n);
+  auto ctx = sdca::make_context(quantized.input(),
+    sdca::make_output_multiclass(Y.begin(), Y.end()),
+    sdca::make_objective_l2_entropy<Data, Result>(1), &A[0], &W[0]);
+  ctx.add_test(quantized.input(),
+    sdca::make_output_multiclass(Y.begin(), Y.end()));
+  ctx.options = options;
+  ctx.criteria.epsilon = 1e-5;
+  sdca::make_solver(ctx).solve();
+  EXPECT_TRUE(ctx.status == sdca::solver_status::solved);
+
+  test_expect_same_primal(ref.train.evals.back(), ctx.train.evals.back(), 1e-4);
+  test_expect_test_as_train(ctx, 1e-4);
+  test_expect_primal_consistent(d, m, n, X_q, A, std::vector<Data>(), W, 1e-3);
+}
+
+
+TEST(SolverInputTest, quantized_features) {
+  sdca::logging::set_level(sdca::logging::level::warning);
+  sdca::logging::set_format(sdca::logging::format::short_e);
+
+  // Round trips of the 16-bit formats
+  std::vector<float> values = {0, -0.0f, 1, -2.5f, 65504, 6.103515625e-05f,
+                               5.9604644775390625e-08f, 0.333251953125f};
+  for (float x : values) {
+    EXPECT_EQ(x, sdca::sdca_dequantize(sdca::sdca_float_to_half(x)));
+  }
+  EXPECT_EQ(0x7C00, sdca::sdca_float_to_half(1e6f).bits); // inf
+  EXPECT_EQ(1.0009765625f, sdca::sdca_dequantize(sdca::sdca_float_to_half(
+    1.00048828125f + 1e-7f)));
+  EXPECT_EQ(1, sdca::sdca_dequantize(sdca::sdca_float_to_half(
+    1.00048828125f))); // a tie rounds to even
+  EXPECT_EQ(-2.5f, sdca::sdca_dequantize(sdca::sdca_float_to_bfloat16(-2.5f)));
+  EXPECT_NEAR(1e30f, sdca::sdca_dequantize(
+    sdca::sdca_float_to_bfloat16(1e30f)), 1e30f / 256);
+
+  sdca::solver_options options;
+  test_solver_quantized<float, double>(sdca::quantization_type::int8,
+    sdca::quantization_scale::per_example, options);
+  test_solver_quantized<double, double>(sdca::quantization_type::int8,
+    sdca::quantization_scale::per_feature, options);
+  test_solver_quantized<float, double>(sdca::quantization_type::fp16,
+    sdca::quantization_scale::per_example, options);
+  test_solver_quantized<float, double>(sdca::quantization_type::bf16,
+    sdca::quantization_scale::per_example, options);
+
+  options.num_threads = 2;
+  test_solver_quantized<double, double>(sdca::quantization_type::fp16,
+    sdca::quantization_scale::per_example, options);
+
+  options.num_threads = 1;
+  options.accelerate = true;
+  test_solver_quantized<double, double>(sdca::quantization_type::int8,
+    sdca::quantization_scale::per_feature, options);
+}
@@ -0,0 +1,261 @@
+#include "sdca/solver.h"
+#include "sdca/solver/data/low_rank.h"
+#include "test_util.h"
+
+
+template <typename Data,
+          typename Result>
+inline void
+test_solver_kernel_function(
+    const sdca::kernel_function<Data>& kernel,
+    const sdca::size_type cache_columns,
+    const sdca::solver_options& options
+  ) {
+  sdca::size_type n = 200, m = 5, d = 10;
+  std::vector<Data> X;
+  std::vector<sdca::size_type> Y;
+
+  std::mt19937 gen(1);
+  test_populate_multiclass(n, d, m, gen, X, Y);
+
+  // The reference uses the full Gram matrix
+  std::vector<Data> K(n * n);
+  for (sdca::size_type i = 0; i < n; ++i) {
+    for (sdca::size_type j = 0; j < n; ++j) {
+      K[n * i + j] = kernel(d, &X[d * j], &X[d * i]);
+    }
+  }
+  std::vector<Data> A_ref(m * n);
+  auto ref = sdca::make_context(sdca::make_input_kernel(n, &K[0]),
+    sdca::make_output_multiclass(Y.begin(), Y.end()),
+    sdca::make_objective_l2_entropy<Data, Result>(1), &A_ref[0]);
+  ref.options = options;
+  ref.criteria.epsilon = 1e-6;
+  sdca::make_solver(ref).solve();
+
+  std::vector<Data> A(m * n);
+  const sdca::size_type cache_size = cache_columns * n * sizeof(Data);
+  auto in = sdca::make_input_kernel_function(d, n, &X[0], kernel, cache_size);
+  auto test_in = sdca::make_input_kernel_function(in, n, &X[0], cache_size);
+  auto ctx = sdca::make_context(std::move(in),
+    sdca::make_output_multiclass(Y.begin(), Y.end()),
+    sdca::make_objective_l2_entropy<Data, Result>(1), &A[0]);
+  ctx.add_test(std::move(test_in),
+    sdca::make_output_multiclass(Y.begin(), Y.end()));
+  ctx.options = options;
+  ctx.criteria.epsilon = 1e-6;
+  sdca::make_solver(ctx).solve();
+  EXPECT_TRUE(ctx.status == sdca::solver_status::solved);
+
+  test_expect_same_primal(ref.train.evals.back(), ctx.train.evals.back(), 1e-5);
+  test_expect_test_as_train(ctx, 1e-5);
+
+  // The cache holds at most cache_columns columns
+  const auto& cache = *ctx.train.in.cache;
+  EXPECT_EQ(std::max(cache_columns, static_cast<sdca::size_type>(1)),
+            cache.capacity());
+  EXPECT_GT(cache.num_misses(), 0UL);
+  if (cache_columns >= n) {
+    EXPECT_EQ(n, cache.num_misses());
+  }
+}
+
+
+TEST(SolverKernelTest, kernel_function) {
+  sdca::logging::set_level(sdca::logging::level::warning);
+  sdca::logging::set_format(sdca::logging::format::short_e);
+  sdca::solver_options options;
+  test_solver_kernel_function<double, double>(
+    sdca::kernel_function<double>(sdca::kernel_type::rbf, 0.5), 200,
+    options);
+  test_solver_kernel_function<double, double>(
+    sdca::kernel_function<double>(sdca::kernel_type::polynomial, 0.5, 1, 2),
+    50, options);
+  test_solver_kernel_function<float, double>(
+    sdca::kernel_function<float>(sdca::kernel_type::linear), 0, options);
+
+  options.num_threads = 2;
+  test_solver_kernel_function<double, double>(
+    sdca::kernel_function<double>(sdca::kernel_type::rbf, 0.5), 30,
+    options);
+}
+
+
+template <typename Data,
+          typename Result>
+inline void
+test_solver_packed_kernel(
+    const sdca::solver_options& options
+  ) {
+  sdca::size_type n = 150, m = 4, d = 10;
+  std::vector<Data> X;
+  std::vector<sdca::size_type> Y;
+
+  std::mt19937 gen(1);
+  test_populate_multiclass(n, d, m, gen, X, Y);
+  std::vector<Data> K(n * n), P(sdca::sdca_packed_size(n));
+  sdca::sdca_blas_gemm(static_cast<sdca::blas_int>(n),
+    static_cast<sdca::blas_int>(n), static_cast<sdca::blas_int>(d),
+    &X[0], static_cast<sdca::blas_int>(d), &X[0],
+    static_cast<sdca::blas_int>(d), &K[0], CblasTrans);
+  sdca::sdca_pack_lower(n, &K[0], &P[0]);
+
+  // The packed gemv reads every column of the symmetric matrix
+  // (three panels, the last one narrower than a block)
+  EXPECT_LT(sdca::sdca_packed_size(n), n * n);
+  for (sdca::size_type i = 0; i < n; ++i) {
+    EXPECT_EQ(K[n * i + i], P[sdca::sdca_packed_offset(n, i)]);
+  }
+  std::vector<Data> A, scores(m), scores_full(m);
+  test_populate_real(m * n, -1, 0, static_cast<Data>(1), gen, A);
+  for (sdca::size_type i = 0; i < n; ++i) {
+    sdca::sdca_packed_gemv(m, n, &A[0], &P[0], i, &scores[0]);
+    sdca::sdca_blas_gemv(static_cast<sdca::blas_int>(m),
+      static_cast<sdca::blas_int>(n), &A[0], &K[n * i], &scores_full[0]);
+    for (sdca::size_type c = 0; c < m; ++c) {
+      double s = static_cast<double>(scores_full[c]);
+      EXPECT_NEAR(s, static_cast<double>(scores[c]), 1e-5 * (1 + std::abs(s)));
+    }
+  }
+
+  std::vector<Data> A_ref(m * n);
+  auto ref = sdca::make_context(sdca::make_input_kernel(n, &K[0]),
+    sdca::make_output_multiclass(Y.begin(), Y.end()),
+    sdca::make_objective_l2_entropy<Data, Result>(1), &A_ref[0]);
+  ref.options = options;
+  ref.criteria.epsilon = 1e-6;
+  sdca::make_solver(ref).solve();
+
+  std::vector<Data> A_packed(m * n);
+  auto ctx = sdca::make_context(sdca::make_input_kernel_packed(n, &P[0]),
+    sdca::make_output_multiclass(Y.begin(), Y.end()),
+    sdca::make_objective_l2_entropy<Data, Result>(1), &A_packed[0]);
+  ctx.add_test(sdca::make_input_kernel_packed(n, n, &K[0]),
+    sdca::make_output_multiclass(Y.begin(), Y.end()));
+  ctx.options = options;
+  ctx.criteria.epsilon = 1e-6;
+  sdca::make_solver(ctx).solve();
+  EXPECT_TRUE(ctx.status == sdca::solver_status::solved);
+
+  test_expect_same_primal(ref.train.evals.back(), ctx.train.evals.back(), 1e-5);
+  test_expect_test_as_train(ctx, 1e-5);
+}
+
+
+TEST(SolverKernelTest, packed_kernel) {
+  sdca::logging::set_level(sdca::logging::level::warning);
+  sdca::logging::set_format(sdca::logging::format::short_e);
+  sdca::solver_options options;
+  test_solver_packed_kernel<float, double>(options);
+  test_solver_packed_kernel<double, double>(options);
+
+  options.num_threads = 2;
+  options.sampling = sdca::sampling_type::importance;
+  test_solver_packed_kernel<double, double>(options);
+}
+
+
+template <typename Data,
+          typename Result>
+inline void
+test_solver_low_rank(
+    const sdca::low_rank_options& low_rank,
+    const double tolerance
+  ) {
+  sdca::size_type n = 200, m = 4, d = 3, n_test = 50;
+  std::vector<Data> X, X_test;
+  std::vector<sdca::size_type> Y, Y_test;
+
+  std::mt19937 gen(1);
+  test_populate_real(n * d, -1, 0, static_cast<Data>(1), gen, X);
+  test_populate_real(n_test * d, -1, 0, static_cast<Data>(1), gen, X_test);
+  test_populate_int<sdca::size_type>(n, 0, m - 1, gen, Y);
+  test_populate_int<sdca::size_type>(n_test, 0, m - 1, gen, Y_test);
+  sdca::kernel_function<Data> rbf(sdca::kernel_type::rbf, 0.5);
+  std::vector<Data> K(n * n), K_test(n * n_test);
+  for (sdca::size_type i = 0; i < n; ++i) {
+    for (sdca::size_type j = 0; j < n; ++j) {
+      K[n * i + j] = rbf(d, &X[d * j], &X[d * i]);
+    }
+  }
+  for (sdca::size_type i = 0; i < n_test; ++i) {
+    for (sdca::size_type j = 0; j < n; ++j) {
+      K_test[n * i + j] = rbf(d, &X[d * j], &X_test[d * i]);
+    }
+  }
+
+  std::vector<Data> A_ref(m * n);
+  auto ref = sdca::make_context(sdca::make_input_kernel(n, &K[0]),
+    sdca::make_output_multiclass(Y.begin(), Y.end()),
+    sdca::make_objective_l2_entropy<Data, Result>(1), &A_ref[0]);
+  ref.add_test(sdca::make_input_kernel(n, n_test, &K_test[0]),
+    sdca::make_output_multiclass(Y_test.begin(), Y_test.end()));
+  ref.criteria.epsilon = 1e-6;
+  sdca::make_solver(ref).solve();
+
+  // The features of the training examples reproduce the kernel
+  sdca::low_rank_kernel<Data> approx(sdca::make_input_kernel(n, &K[0]),
+                                     low_rank);
+  const sdca::size_type r = approx.rank();
+  EXPECT_LE(approx.trace_error(), low_rank.tolerance);
+  EXPECT_LT(r, n);
+  std::vector<Data> F_test;
+  approx.transform(sdca::make_input_kernel(n, n_test, &K_test[0]), F_test);
+  const std::vector<Data>& F = approx.features();
+  for (sdca::size_type i = 0; i < n; i += 7) {
+    for (sdca::size_type j = 0; j < n_test; j += 3) {
+      double k = static_cast<double>(sdca::sdca_blas_dot(
+        static_cast<sdca::blas_int>(r), &F[r * i], &F_test[r * j]));
+      EXPECT_NEAR(static_cast<double>(K_test[n * j + i]), k, tolerance);
+    }
+  }
+
+  std::vector<Data> W(r * m), A(m * n);
+  auto ctx = sdca::make_context(approx.train_input(),
+    sdca::make_output_multiclass(Y.begin(), Y.end()),
+    sdca::make_objective_l2_entropy<Data, Result>(1), &A[0], &W[0]);
+  ctx.add_test(sdca::make_input_feature(r, n_test, &F_test[0]),
+    sdca::make_output_multiclass(Y_test.begin(), Y_test.end()));
+  ctx.criteria.epsilon = 1e-6;
+  sdca::make_solver(ctx).solve();
+
+  // The solutions are close up to the approximation error
+  Result primal = ctx.train.evals.back().primal;
+  Result primal_ref = ref.train.evals.back().primal;
+  EXPECT_NEAR(primal_ref, primal, tolerance * std::abs(primal_ref));
+  EXPECT_NEAR(ref.test[0].evals.back().primal_loss,
+              ctx.test[0].evals.back().primal_loss,
+              tolerance * std::abs(primal_ref));
+}
+
+
+TEST(SolverKernelTest, low_rank_kernel) {
+  sdca::logging::set_level(sdca::logging::level::warning);
+  sdca::logging::set_format(sdca::logging::format::short_e);
+  sdca::low_rank_options options;
+  options.tolerance = 1e-4;
+  test_solver_low_rank<double, double>(options, 1e-2);
+  test_solver_low_rank<float, double>(options, 1e-2);
+
+  options.method = sdca::low_rank_method::nystrom;
+  test_solver_low_rank<double, double>(options, 1e-2);
+
+  // A linear kernel of 3 dimensions has rank 3
+  sdca::size_type n = 20, d = 3;
+  std::vector<double> X, K(n * n);
+  std::mt19937 gen(1);
+  test_populate_real(n * d, -1, 0, 1.0, gen, X);
+  sdca::sdca_blas_gemm(static_cast<sdca::blas_int>(n),
+    static_cast<sdca::blas_int>(n), static_cast<sdca::blas_int>(d),
+    &X[0], static_cast<sdca::blas_int>(d), &X[0],
+    static_cast<sdca::blas_int>(d), &K[0], CblasTrans);
+  options.method = sdca::low_rank_method::incomplete_cholesky;
+  options.tolerance = 0;
+  sdca::low_rank_kernel<double> exact(sdca::make_input_kernel(n, &K[0]),
+                                      options);
+  EXPECT_EQ(d, exact.rank());
+  EXPECT_NEAR(0, exact.trace_error(), 1e-12);
+  options.max_rank = 2;
+  EXPECT_EQ(2, sdca::low_rank_kernel<double>(
+    sdca::make_input_kernel(n, &K[0]), options).rank());
+}
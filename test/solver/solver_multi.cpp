@@ -0,0 +1,95 @@
+#include "sdca/solver.h"
+#include "test_util.h"
+
+
+template <typename Data,
+          typename Result>
+inline void
+test_solver_multi(
+    const sdca::size_type num_threads
+  ) {
+  sdca::size_type n = 200, m = 5, d = 20;
+  std::vector<Data> X;
+  std::vector<sdca::size_type> Y;
+
+  std::mt19937 gen(1);
+  test_populate_multiclass(n, d, m, gen, X, Y);
+  auto make_output = [&]() {
+    return sdca::make_output_multiclass(Y.begin(), Y.end());
+  };
+  auto make_input = [&]() {
+    return sdca::make_input_feature(d, n, &X[0]);
+  };
+
+  // Reference solutions (one solver per model)
+  std::vector<Data> W_ref(3 * d * m), A_ref(3 * m * n);
+  auto ref_1 = sdca::make_context(make_input(), make_output(),
+    sdca::make_objective_l2_entropy<Data, Result>(1), &A_ref[0], &W_ref[0]);
+  auto ref_2 = sdca::make_context(make_input(), make_output(),
+    sdca::make_objective_l2_topk_hinge<Data, Result>(1, 1),
+    &A_ref[m * n], &W_ref[d * m]);
+  auto ref_3 = sdca::make_context(make_input(), make_output(),
+    sdca::make_objective_l2_topk_hinge<Data, Result>(1, 2),
+    &A_ref[2 * m * n], &W_ref[2 * d * m]);
+  sdca::make_solver(ref_1).solve();
+  sdca::make_solver(ref_2).solve();
+  sdca::make_solver(ref_3).solve();
+
+  // All models in one pass over the data
+  std::vector<Data> W(3 * d * m), A(3 * m * n);
+  auto ctx_1 = sdca::make_context(make_input(), make_output(),
+    sdca::make_objective_l2_entropy<Data, Result>(1), &A[0], &W[0]);
+  auto ctx_2 = sdca::make_context(make_input(), make_output(),
+    sdca::make_objective_l2_topk_hinge<Data, Result>(1, 1),
+    &A[m * n], &W[d * m]);
+  auto ctx_3 = sdca::make_context(make_input(), make_output(),
+    sdca::make_objective_l2_topk_hinge<Data, Result>(1, 2),
+    &A[2 * m * n], &W[2 * d * m]);
+  ctx_1.options.num_threads = num_threads;
+  ctx_2.options.num_threads = num_threads;
+  ctx_3.options.num_threads = num_threads;
+  sdca::multi_solver<Data> solver;
+  solver.add(ctx_1);
+  solver.add(ctx_2);
+  solver.add(ctx_3);
+  ASSERT_EQ(3UL, solver.num_models());
+  solver.solve();
+
+  // The examples are visited in the same order as by the solver
+  // (sequentially, also with more threads)
+  EXPECT_TRUE(ctx_1.status == sdca::solver_status::solved);
+  EXPECT_TRUE(ctx_2.status == sdca::solver_status::solved);
+  EXPECT_TRUE(ctx_3.status == sdca::solver_status::solved);
+  EXPECT_EQ(ref_1.epoch, ctx_1.epoch);
+  EXPECT_EQ(ref_2.epoch, ctx_2.epoch);
+  EXPECT_EQ(ref_3.epoch, ctx_3.epoch);
+  EXPECT_EQ(ref_1.train.evals.size(), ctx_1.train.evals.size());
+  EXPECT_EQ(n * ctx_2.epoch, ctx_2.num_updates);
+  for (sdca::size_type i = 0; i < A.size(); ++i) {
+    EXPECT_EQ(A_ref[i], A[i]);
+  }
+
+  // The time of the shared passes is reported once
+  EXPECT_FALSE(solver.solve_time().wall.is_running);
+  EXPECT_GE(solver.solve_time().wall.elapsed, ctx_1.solve_time.wall.elapsed);
+
+  // The models must share the features
+  std::vector<Data> X_other(X);
+  auto ctx_other = sdca::make_context(
+    sdca::make_input_feature(d, n, &X_other[0]), make_output(),
+    sdca::make_objective_l2_entropy<Data, Result>(1), &A[0], &W[0]);
+  EXPECT_THROW(solver.add(ctx_other), std::invalid_argument);
+  auto ctx_reshaped = sdca::make_context(
+    sdca::make_input_feature(d / 2, n, &X[0]), make_output(),
+    sdca::make_objective_l2_entropy<Data, Result>(1), &A[0], &W[0]);
+  EXPECT_THROW(solver.add(ctx_reshaped), std::invalid_argument);
+}
+
+
+TEST(SolverMultiTest, shared_features) {
+  sdca::logging::set_level(sdca::logging::level::warning);
+  sdca::logging::set_format(sdca::logging::format::short_e);
+  test_solver_multi<float, double>(1);
+  test_solver_multi<double, double>(1);
+  test_solver_multi<double, double>(2);
+}
@@ -0,0 +1,409 @@
+#include "sdca/solver.h"
+#include "test_util.h"
+
+
+template <typename Data,
+          typename Result,
+          typename OutputMaker,
+          template <typename, typename> class Objective>
+inline void
+test_solver_parallel_feature_in(
+    OutputMaker make_output,
+    Objective<Data, Result> objective,
+    const sdca::solver_options& options
+  ) {
+  sdca::size_type n = 200, m = 5, d = 10;
+  int pow_from = -1, pow_to = 0;
+  std::vector<Data> X;
+  std::vector<sdca::size_type> Y;
+
+  std::mt19937 gen(1);
+  test_populate_real(n * d, pow_from, pow_to, static_cast<Data>(1), gen, X);
+  test_populate_int<sdca::size_type>(n, 1, m, gen, Y);
+
+  // Reference solution (single thread)
+  std::vector<Data> W_ref(d * m), A_ref(m * n);
+  auto ctx_ref = sdca::make_context(
+    sdca::make_input_feature(d, n, &X[0]), make_output(Y),
+    Objective<Data, Result>(objective), &A_ref[0], &W_ref[0]);
+  ctx_ref.criteria.epsilon = 1e-4;
+  ctx_ref.criteria.eval_epoch = 5;
+  sdca::make_solver(ctx_ref).solve();
+  ASSERT_TRUE(ctx_ref.status == sdca::solver_status::solved);
+
+  // Asynchronous solution
+  std::vector<Data> W(d * m), A(m * n);
+  auto ctx = sdca::make_context(
+    sdca::make_input_feature(d, n, &X[0]), make_output(Y),
+    Objective<Data, Result>(objective), &A[0], &W[0]);
+  ctx.criteria.epsilon = 1e-4;
+  ctx.criteria.eval_epoch = 5;
+  ctx.options = options;
+  sdca::make_solver(ctx).solve();
+  if (ctx.status != sdca::solver_status::solved) {
+    std::printf("%s\n", ctx.to_string().c_str());
+    std::printf("%s\n", ctx.status_string().c_str());
+  }
+  EXPECT_TRUE(ctx.status == sdca::solver_status::solved);
+  if (options.shrink_visits > 0) {
+    EXPECT_LE(ctx.num_updates, n * ctx.epoch);
+  } else {
+    EXPECT_EQ(n * ctx.epoch, ctx.num_updates);
+  }
+  EXPECT_TRUE(ctx.throughput() > 0);
+
+  // Both solutions must be within the duality gap of each other
+  Result primal_ref = ctx_ref.train.evals.back().primal;
+  Result primal = ctx.train.evals.back().primal;
+  EXPECT_NEAR(primal_ref, primal, 2e-4 * std::abs(primal_ref));
+
+  // The primal variables are consistent with the dual variables, W = X * A'
+  std::vector<Data> W_check(d * m);
+  sdca::sdca_blas_gemm(static_cast<sdca::blas_int>(d),
+    static_cast<sdca::blas_int>(m), static_cast<sdca::blas_int>(n),
+    &X[0], static_cast<sdca::blas_int>(d), &A[0],
+    static_cast<sdca::blas_int>(m), &W_check[0], CblasNoTrans, CblasTrans);
+  for (sdca::size_type i = 0; i < d * m; ++i) {
+    EXPECT_NEAR(W_check[i], W[i], 1e-3);
+  }
+}
+
+
+template <typename Data,
+          typename Result,
+          typename OutputMaker,
+          template <typename, typename> class Objective>
+inline void
+test_solver_parallel_kernel_in(
+    OutputMaker make_output,
+    Objective<Data, Result> objective,
+    const sdca::solver_options& options
+  ) {
+  sdca::size_type n = 200, m = 5, d = 10;
+  int pow_from = -1, pow_to = 0;
+  std::vector<Data> X;
+  std::vector<sdca::size_type> Y;
+
+  std::mt19937 gen(1);
+  test_populate_real(n * d, pow_from, pow_to, static_cast<Data>(1), gen, X);
+  test_populate_int<sdca::size_type>(n, 1, m, gen, Y);
+
+  std::vector<Data> K(n * n);
+  sdca::blas_int D = static_cast<sdca::blas_int>(d);
+  sdca::blas_int N = static_cast<sdca::blas_int>(n);
+  sdca::sdca_blas_gemm(N, N, D, &X[0], D, &X[0], D, &K[0], CblasTrans);
+
+  // Reference solution (single thread)
+  std::vector<Data> A_ref(m * n);
+  auto ctx_ref = sdca::make_context(
+    sdca::make_input_kernel(n, &K[0]), make_output(Y),
+    Objective<Data, Result>(objective), &A_ref[0]);
+  ctx_ref.criteria.epsilon = 1e-4;
+  ctx_ref.criteria.eval_epoch = 5;
+  sdca::make_solver(ctx_ref).solve();
+  ASSERT_TRUE(ctx_ref.status == sdca::solver_status::solved);
+
+  // Asynchronous solution
+  std::vector<Data> A(m * n);
+  auto ctx = sdca::make_context(
+    sdca::make_input_kernel(n, &K[0]), make_output(Y),
+    Objective<Data, Result>(objective), &A[0]);
+  ctx.criteria.epsilon = 1e-4;
+  ctx.criteria.eval_epoch = 5;
+  ctx.options = options;
+  sdca::make_solver(ctx).solve();
+  if (ctx.status != sdca::solver_status::solved) {
+    std::printf("%s\n", ctx.to_string().c_str());
+    std::printf("%s\n", ctx.status_string().c_str());
+  }
+  EXPECT_TRUE(ctx.status == sdca::solver_status::solved);
+  if (options.shrink_visits > 0) {
+    EXPECT_LE(ctx.num_updates, n * ctx.epoch);
+  } else {
+    EXPECT_EQ(n * ctx.epoch, ctx.num_updates);
+  }
+
+  Result primal_ref = ctx_ref.train.evals.back().primal;
+  Result primal = ctx.train.evals.back().primal;
+  EXPECT_NEAR(primal_ref, primal, 2e-4 * std::abs(primal_ref));
+}
+
+
+template <typename Data,
+          typename Result>
+inline void
+test_solver_parallel_all(
+    const sdca::solver_options& options
+  ) {
+  Result C = 1;
+  auto multiclass_output_maker = [](std::vector<sdca::size_type> Y) {
+    return sdca::make_output_multiclass(Y.begin(), Y.end());
+  };
+
+  test_solver_parallel_feature_in(multiclass_output_maker,
+    sdca::make_objective_l2_topk_hinge<Data, Result>(C), options);
+
+  test_solver_parallel_feature_in(multiclass_output_maker,
+    sdca::make_objective_l2_entropy<Data, Result>(C), options);
+
+  test_solver_parallel_kernel_in(multiclass_output_maker,
+    sdca::make_objective_l2_topk_hinge<Data, Result>(C), options);
+
+  test_solver_parallel_kernel_in(multiclass_output_maker,
+    sdca::make_objective_l2_entropy<Data, Result>(C), options);
+}
+
+
+TEST(SolverParallelTest, async) {
+  sdca::logging::set_level(sdca::logging::level::warning);
+  sdca::logging::set_format(sdca::logging::format::short_e);
+  sdca::solver_options options;
+  options.num_threads = 2;
+  test_solver_parallel_all<float, double>(options);
+  options.num_threads = 4;
+  test_solver_parallel_all<double, double>(options);
+}
+
+
+TEST(SolverParallelTest, mini_batch) {
+  sdca::logging::set_level(sdca::logging::level::warning);
+  sdca::logging::set_format(sdca::logging::format::short_e);
+  sdca::solver_options options;
+  options.batch_size = 16;
+  test_solver_parallel_all<float, double>(options);
+  test_solver_parallel_all<double, double>(options);
+
+  // Fixed (conservative) step size scaling
+  options.batch_size = 7;
+  options.batch_beta = 7;
+  test_solver_parallel_all<double, double>(options);
+
+  // Asynchronous mini-batches
+  options.batch_size = 8;
+  options.batch_beta = 0;
+  options.num_threads = 2;
+  test_solver_parallel_all<double, double>(options);
+}
+
+
+template <typename Context>
+inline void
+test_evaluate_parallel(
+    Context& ctx,
+    const sdca::size_type num_threads
+  ) {
+  sdca::make_solver(ctx).solve();
+
+  // Evaluate the same solution with one and with several threads
+  // (copies, since every evaluation appends to the evals of the dataset)
+  const auto train_1 = sdca::compute_evaluation(ctx, ctx.train, 1);
+  const auto train_n = sdca::compute_evaluation(ctx, ctx.train, num_threads);
+  EXPECT_NEAR(train_1.primal, train_n.primal, 1e-10 * std::abs(train_1.primal));
+  EXPECT_NEAR(train_1.dual, train_n.dual, 1e-10 * std::abs(train_1.dual));
+  for (std::size_t k = 0; k < train_1.accuracy.size(); ++k) {
+    EXPECT_NEAR(train_1.accuracy[k], train_n.accuracy[k], 1e-12);
+  }
+
+  for (auto& test_set : ctx.test) {
+    const auto test_1 = sdca::compute_evaluation(ctx, test_set, 1);
+    const auto test_n = sdca::compute_evaluation(ctx, test_set, num_threads);
+    EXPECT_NEAR(test_1.primal_loss, test_n.primal_loss,
+                1e-10 * std::abs(test_1.primal_loss));
+    for (std::size_t k = 0; k < test_1.accuracy.size(); ++k) {
+      EXPECT_NEAR(test_1.accuracy[k], test_n.accuracy[k], 1e-12);
+    }
+  }
+
+  // Scoring in blocks (gemm) matches scoring every example separately
+  for (sdca::size_type block_size : {1, 7}) {
+    ctx.options.eval_block_size = block_size;
+    const auto train_b = sdca::compute_evaluation(ctx, ctx.train, num_threads);
+    EXPECT_NEAR(train_1.primal, train_b.primal,
+                1e-10 * std::abs(train_1.primal));
+    EXPECT_NEAR(train_1.dual, train_b.dual, 1e-10 * std::abs(train_1.dual));
+    for (auto& test_set : ctx.test) {
+      const auto test_1 = sdca::compute_evaluation(ctx, test_set, 1);
+      ctx.options.eval_block_size = 256;
+      const auto test_b = sdca::compute_evaluation(ctx, test_set, 1);
+      ctx.options.eval_block_size = block_size;
+      EXPECT_NEAR(test_1.primal_loss, test_b.primal_loss,
+                  1e-10 * std::abs(test_1.primal_loss));
+    }
+  }
+  ctx.options.eval_block_size = 256;
+
+  // The reduction order only depends on the number of threads
+  const auto train_a = sdca::compute_evaluation(ctx, ctx.train, num_threads);
+  const auto train_b = sdca::compute_evaluation(ctx, ctx.train, num_threads);
+  EXPECT_EQ(train_a.primal, train_b.primal);
+  EXPECT_EQ(train_a.dual, train_b.dual);
+
+  // All test sets are evaluated when the solver runs multi-threaded
+  ctx.options.num_threads = num_threads;
+  ctx.criteria.max_epoch = ctx.epoch + 2;
+  ctx.criteria.eval_epoch = 1;
+  auto num_train = ctx.train.evals.size();
+  std::vector<std::size_t> num_test;
+  for (auto& test_set : ctx.test) {
+    num_test.push_back(test_set.evals.size());
+  }
+  sdca::make_solver(ctx).solve();
+  for (std::size_t t = 0; t < ctx.test.size(); ++t) {
+    EXPECT_EQ(ctx.train.evals.size() - num_train,
+              ctx.test[t].evals.size() - num_test[t]);
+  }
+}
+
+
+TEST(SolverParallelTest, shrinking) {
+  sdca::logging::set_level(sdca::logging::level::warning);
+  sdca::logging::set_format(sdca::logging::format::short_e);
+  sdca::solver_options options;
+  options.shrink_visits = 2;
+  test_solver_parallel_all<float, double>(options);
+  test_solver_parallel_all<double, double>(options);
+
+  // Shrinking with asynchronous updates and mini-batches
+  options.num_threads = 2;
+  test_solver_parallel_all<double, double>(options);
+  options.batch_size = 8;
+  test_solver_parallel_all<double, double>(options);
+}
+
+
+TEST(SolverParallelTest, shrinking_without_eval) {
+  sdca::logging::set_level(sdca::logging::level::warning);
+  sdca::logging::set_format(sdca::logging::format::short_e);
+
+  typedef double Data;
+  sdca::size_type n = 200, m = 5, d = 10;
+  std::vector<Data> X;
+  std::vector<sdca::size_type> Y;
+
+  std::mt19937 gen(1);
+  test_populate_multiclass(n, d, m, gen, X, Y);
+
+  // Reference solution (no shrinking)
+  std::vector<Data> W_ref(d * m), A_ref(m * n);
+  auto ctx_ref = sdca::make_context(
+    sdca::make_input_feature(d, n, &X[0]),
+    sdca::make_output_multiclass(Y.begin(), Y.end()),
+    sdca::make_objective_l2_entropy<Data, double>(1), &A_ref[0], &W_ref[0]);
+  ctx_ref.criteria.epsilon = 1e-6;
+  sdca::make_solver(ctx_ref).solve();
+  ASSERT_TRUE(ctx_ref.status == sdca::solver_status::solved);
+
+  // Without the intermediate evaluations, the examples are reactivated
+  // once the active set is empty, i.e. the later epochs still do some work
+  sdca::size_type num_updates = 0;
+  for (sdca::size_type num_epochs : {100, 200}) {
+    std::vector<Data> W(d * m), A(m * n);
+    auto ctx = sdca::make_context(
+      sdca::make_input_feature(d, n, &X[0]),
+      sdca::make_output_multiclass(Y.begin(), Y.end()),
+      sdca::make_objective_l2_entropy<Data, double>(1), &A[0], &W[0]);
+    ctx.criteria.eval_epoch = 0;
+    ctx.criteria.max_epoch = num_epochs;
+    ctx.options.shrink_visits = 2;
+    sdca::make_solver(ctx).solve();
+    EXPECT_TRUE(ctx.status == sdca::solver_status::max_epoch);
+    EXPECT_EQ(num_epochs, ctx.epoch);
+    EXPECT_GE(ctx.num_updates, num_updates + n);
+    num_updates = ctx.num_updates;
+    test_expect_same_primal(ctx_ref.train.evals.back(),
+                            ctx.train.evals.back(), 1e-4);
+  }
+}
+
+
+TEST(SolverParallelTest, evaluate) {
+  sdca::logging::set_level(sdca::logging::level::warning);
+  sdca::logging::set_format(sdca::logging::format::short_e);
+
+  typedef double Data;
+  sdca::size_type n = 200, m = 5, d = 10, num_test = 3;
+  int pow_from = -1, pow_to = 0;
+  std::vector<Data> X;
+  std::vector<sdca::size_type> Y;
+
+  std::mt19937 gen(1);
+  test_populate_real(n * d, pow_from, pow_to, static_cast<Data>(1), gen, X);
+  test_populate_int<sdca::size_type>(n, 1, m, gen, Y);
+
+  std::vector<Data> K(n * n);
+  sdca::blas_int D = static_cast<sdca::blas_int>(d);
+  sdca::blas_int N = static_cast<sdca::blas_int>(n);
+  sdca::sdca_blas_gemm(N, N, D, &X[0], D, &X[0], D, &K[0], CblasTrans);
+
+  // Features (the test sets are the first n - 10 * t examples)
+  std::vector<Data> W(d * m), A(m * n);
+  auto ctx = sdca::make_context(
+    sdca::make_input_feature(d, n, &X[0]),
+    sdca::make_output_multiclass(Y.begin(), Y.end()),
+    sdca::make_objective_l2_entropy<Data, Data>(1), &A[0], &W[0]);
+  for (sdca::size_type t = 0; t < num_test; ++t) {
+    ctx.add_test(sdca::make_input_feature(d, n - 10 * t, &X[0]),
+                 sdca::make_output_multiclass(Y.begin(), Y.end() - 10 * t));
+  }
+  test_evaluate_parallel(ctx, 4);
+
+  // Kernels
+  std::vector<Data> B(m * n);
+  auto ctx_k = sdca::make_context(
+    sdca::make_input_kernel(n, &K[0]),
+    sdca::make_output_multiclass(Y.begin(), Y.end()),
+    sdca::make_objective_l2_topk_hinge<Data, Data>(1), &B[0]);
+  for (sdca::size_type t = 0; t < num_test; ++t) {
+    ctx_k.add_test(sdca::make_input_kernel(n, n - 10 * t, &K[0]),
+                   sdca::make_output_multiclass(Y.begin(), Y.end() - 10 * t));
+  }
+  test_evaluate_parallel(ctx_k, 3);
+}
+
+
+TEST(SolverParallelTest, sampling) {
+  sdca::logging::set_level(sdca::logging::level::warning);
+  sdca::logging::set_format(sdca::logging::format::short_e);
+  sdca::solver_options options;
+  for (auto sampling : {sdca::sampling_type::importance,
+                        sdca::sampling_type::adaptive}) {
+    options.sampling = sampling;
+    test_solver_parallel_all<float, double>(options);
+    test_solver_parallel_all<double, double>(options);
+
+    // Every worker draws from its own block of examples
+    options.num_threads = 2;
+    test_solver_parallel_all<double, double>(options);
+    options.num_threads = 1;
+  }
+}
+
+
+TEST(SolverParallelTest, alias_table) {
+  std::vector<double> weights = {1, 0, 2, 5, 0.5, 1.5};
+  sdca::alias_table table;
+  table.init(weights.begin(), weights.end());
+  ASSERT_EQ(weights.size(), table.size());
+
+  std::mt19937 gen(1);
+  std::size_t num_draws = 100000;
+  std::vector<double> freq(weights.size());
+  for (std::size_t k = 0; k < num_draws; ++k) {
+    freq[table(gen)] += 1;
+  }
+  double sum = std::accumulate(weights.begin(), weights.end(), 0.0);
+  for (std::size_t i = 0; i < weights.size(); ++i) {
+    EXPECT_NEAR(weights[i] / sum, freq[i] / num_draws, 5e-3);
+  }
+
+  // Uniform if all weights are zero
+  std::vector<double> zeros(4);
+  table.init(zeros.begin(), zeros.end());
+  std::fill(freq.begin(), freq.end(), 0);
+  for (std::size_t k = 0; k < num_draws; ++k) {
+    freq[table(gen)] += 1;
+  }
+  for (std::size_t i = 0; i < zeros.size(); ++i) {
+    EXPECT_NEAR(0.25, freq[i] / num_draws, 5e-3);
+  }
+}
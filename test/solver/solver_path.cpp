@@ -0,0 +1,131 @@
+#include "sdca/solver.h"
+#include "test_util.h"
+
+
+template <typename Data,
+          typename Result,
+          template <typename, typename> class Objective>
+inline void
+test_solver_path(
+    Objective<Data, Result> objective
+  ) {
+  sdca::size_type n = 200, m = 5, d = 20;
+  std::vector<Data> X;
+  std::vector<sdca::size_type> Y;
+
+  std::mt19937 gen(1);
+  test_populate_multiclass(n, d, m, gen, X, Y);
+  std::vector<Result> c_values = {static_cast<Result>(0.1),
+    static_cast<Result>(0.3), 1, 3, 10};
+
+  // Cold solve for the last c
+  std::vector<Data> W_ref(d * m), A_ref(m * n);
+  auto ctx_ref = sdca::make_context(
+    sdca::make_input_feature(d, n, &X[0]),
+    sdca::make_output_multiclass(Y.begin(), Y.end()),
+    sdca::scale_objective(objective, c_values.back() / objective.c),
+    &A_ref[0], &W_ref[0]);
+  ctx_ref.criteria.max_epoch = 10000;
+  sdca::make_solver(ctx_ref).solve();
+  ASSERT_TRUE(ctx_ref.status == sdca::solver_status::solved);
+
+  // Warm-started path, with the training data as a test set
+  std::vector<Data> W(d * m), A(m * n);
+  auto ctx = sdca::make_context(
+    sdca::make_input_feature(d, n, &X[0]),
+    sdca::make_output_multiclass(Y.begin(), Y.end()),
+    Objective<Data, Result>(objective), &A[0], &W[0]);
+  ctx.criteria.max_epoch = 10000;
+  ctx.add_test(sdca::make_input_feature(d, n, &X[0]),
+               sdca::make_output_multiclass(Y.begin(), Y.end()));
+  auto solver = sdca::make_path_solver(ctx);
+  solver.solve(c_values.begin(), c_values.end());
+
+  const auto& points = solver.points();
+  ASSERT_EQ(c_values.size(), points.size());
+  sdca::size_type num_epochs = 0;
+  for (sdca::size_type i = 0; i < points.size(); ++i) {
+    EXPECT_EQ(c_values[i], points[i].c);
+    EXPECT_TRUE(points[i].status == sdca::solver_status::solved);
+    EXPECT_FALSE(points[i].train_evals.empty());
+    ASSERT_EQ(1UL, points[i].test_evals.size());
+    EXPECT_EQ(points[i].train_evals.size(), points[i].test_evals[0].size());
+    num_epochs += points[i].epoch;
+  }
+  EXPECT_LE(num_epochs, 2 * ctx_ref.epoch);
+
+  // The last point is the solution for the last c
+  test_expect_same_primal(ctx_ref.train.evals.back(),
+                          points.back().train_evals.back(), 2e-3);
+  test_expect_primal_consistent(d, m, n, X, A, std::vector<Data>(), W, 1e-3);
+}
+
+
+TEST(SolverPathTest, c) {
+  sdca::logging::set_level(sdca::logging::level::warning);
+  sdca::logging::set_format(sdca::logging::format::short_e);
+  test_solver_path(sdca::make_objective_l2_entropy<double, double>());
+  test_solver_path(sdca::make_objective_l2_topk_hinge<double, double>(1, 2));
+  test_solver_path(
+    sdca::make_objective_l2_topk_hinge_smooth<float, double>(1, 1, 2));
+}
+
+
+template <typename Data,
+          typename Result,
+          template <typename, typename> class Objective>
+inline void
+test_solver_path_gamma(
+    Objective<Data, Result> objective
+  ) {
+  sdca::size_type n = 200, m = 5, d = 20;
+  std::vector<Data> X;
+  std::vector<sdca::size_type> Y;
+
+  std::mt19937 gen(1);
+  test_populate_multiclass(n, d, m, gen, X, Y);
+  std::vector<Result> gamma_values = {1, static_cast<Result>(0.3),
+    static_cast<Result>(0.1)};
+
+  // Cold solve for the last gamma
+  std::vector<Data> W_ref(d * m), A_ref(m * n);
+  auto ctx_ref = sdca::make_context(
+    sdca::make_input_feature(d, n, &X[0]),
+    sdca::make_output_multiclass(Y.begin(), Y.end()),
+    sdca::objective_with_gamma(objective, gamma_values.back()),
+    &A_ref[0], &W_ref[0]);
+  ctx_ref.criteria.max_epoch = 10000;
+  sdca::make_solver(ctx_ref).solve();
+  ASSERT_TRUE(ctx_ref.status == sdca::solver_status::solved);
+
+  // Warm-started path over gamma (the dual variables stay feasible)
+  std::vector<Data> W(d * m), A(m * n);
+  auto ctx = sdca::make_context(
+    sdca::make_input_feature(d, n, &X[0]),
+    sdca::make_output_multiclass(Y.begin(), Y.end()),
+    Objective<Data, Result>(objective), &A[0], &W[0]);
+  ctx.criteria.max_epoch = 10000;
+  auto solver = sdca::make_path_solver(ctx);
+  solver.solve_gamma(gamma_values.begin(), gamma_values.end());
+
+  const auto& points = solver.points();
+  ASSERT_EQ(gamma_values.size(), points.size());
+  for (sdca::size_type i = 0; i < points.size(); ++i) {
+    EXPECT_EQ(objective.c, points[i].c);
+    EXPECT_EQ(gamma_values[i], points[i].gamma);
+    EXPECT_TRUE(points[i].status == sdca::solver_status::solved);
+  }
+
+  test_expect_same_primal(ctx_ref.train.evals.back(),
+                          points.back().train_evals.back(), 2e-3);
+}
+
+
+TEST(SolverPathTest, gamma) {
+  sdca::logging::set_level(sdca::logging::level::warning);
+  sdca::logging::set_format(sdca::logging::format::short_e);
+  test_solver_path_gamma(
+    sdca::make_objective_l2_topk_hinge_smooth<double, double>(1, 1, 2));
+  test_solver_path_gamma(
+    sdca::make_objective_l2_hinge_topk_smooth<float, double>(1, 1, 1));
+}
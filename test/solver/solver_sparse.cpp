@@ -0,0 +1,93 @@
+#include "sdca/solver.h"
+#include "test_util.h"
+
+
+template <typename Data,
+          typename Result,
+          template <typename, typename> class Objective>
+inline void
+test_solver_sparse(
+    Objective<Data, Result> objective,
+    const sdca::solver_options& options
+  ) {
+  sdca::size_type n = 300, m = 5, d = 200, nnz = 10;
+  std::vector<Data> values;
+  std::vector<sdca::size_type> indices, offsets(1), Y;
+
+  // Every example has nnz random non-zeros in increasing dimensions
+  std::mt19937 gen(1);
+  test_populate_real(n * nnz, -1, 0, static_cast<Data>(1), gen, values);
+  test_populate_int<sdca::size_type>(n, 0, m - 1, gen, Y);
+  std::uniform_int_distribution<sdca::size_type> dim(0, d - 1);
+  for (sdca::size_type i = 0; i < n; ++i) {
+    std::vector<sdca::size_type> rows;
+    while (rows.size() < nnz) {
+      sdca::size_type r = dim(gen);
+      if (std::find(rows.begin(), rows.end(), r) == rows.end()) {
+        rows.push_back(r);
+      }
+    }
+    std::sort(rows.begin(), rows.end());
+    indices.insert(indices.end(), rows.begin(), rows.end());
+    offsets.push_back(indices.size());
+  }
+
+  // The same features as a dense matrix
+  std::vector<Data> X(d * n);
+  for (sdca::size_type i = 0; i < n; ++i) {
+    for (sdca::size_type k = offsets[i]; k < offsets[i + 1]; ++k) {
+      X[d * i + indices[k]] = values[k];
+    }
+  }
+
+  std::vector<Data> W_dense(d * m), A_dense(m * n);
+  auto ctx_dense = sdca::make_context(
+    sdca::make_input_feature(d, n, &X[0]),
+    sdca::make_output_multiclass(Y.begin(), Y.end()),
+    Objective<Data, Result>(objective), &A_dense[0], &W_dense[0]);
+  ctx_dense.add_test(sdca::make_input_feature(d, n, &X[0]),
+    sdca::make_output_multiclass(Y.begin(), Y.end()));
+  ctx_dense.options = options;
+  ctx_dense.criteria.epsilon = 1e-4;
+  sdca::make_accelerated_solver(ctx_dense).solve();
+
+  std::vector<Data> W(d * m), A(m * n);
+  auto ctx = sdca::make_context(
+    sdca::make_input_sparse_feature(d, n, &values[0], &indices[0],
+                                    &offsets[0]),
+    sdca::make_output_multiclass(Y.begin(), Y.end()),
+    Objective<Data, Result>(objective), &A[0], &W[0]);
+  ctx.add_test(sdca::make_input_sparse_feature(d, n, &values[0],
+                                               &indices[0], &offsets[0]),
+    sdca::make_output_multiclass(Y.begin(), Y.end()));
+  ctx.options = options;
+  ctx.criteria.epsilon = 1e-4;
+  sdca::make_accelerated_solver(ctx).solve();
+  EXPECT_TRUE(ctx.status == sdca::solver_status::solved);
+
+  test_expect_same_primal(ctx_dense.train.evals.back(),
+                          ctx.train.evals.back(), 2e-4);
+  test_expect_test_as_train(ctx, 1e-4);
+  test_expect_primal_consistent(d, m, n, X, A, std::vector<Data>(), W, 1e-3);
+}
+
+
+TEST(SolverSparseTest, sparse_feature_input) {
+  sdca::logging::set_level(sdca::logging::level::warning);
+  sdca::logging::set_format(sdca::logging::format::short_e);
+  sdca::solver_options options;
+  test_solver_sparse(
+    sdca::make_objective_l2_topk_hinge<float, double>(1, 1), options);
+  test_solver_sparse(
+    sdca::make_objective_l2_entropy<double, double>(1), options);
+
+  options.num_threads = 2;
+  test_solver_sparse(
+    sdca::make_objective_l2_entropy<double, double>(1), options);
+
+  options.num_threads = 1;
+  options.accelerate = true;
+  test_solver_sparse(
+    sdca::make_objective_l2_topk_hinge_smooth<double, double>(10, 1, 1),
+    options);
+}
@@ -0,0 +1,83 @@
+#include "sdca/solver.h"
+#include "sdca/solver/streaming.h"
+#include "test_util.h"
+
+
+template <typename Data,
+          typename Result,
+          template <typename, typename> class Objective>
+inline void
+test_solver_streaming(
+    Objective<Data, Result> objective,
+    const sdca::size_type chunk_size,
+    const sdca::solver_options& options
+  ) {
+  sdca::size_type n = 300, m = 5, d = 20;
+  std::vector<Data> X;
+  std::vector<sdca::size_type> Y;
+
+  std::mt19937 gen(1);
+  test_populate_multiclass(n, d, m, gen, X, Y);
+  const std::string path = "test_solver_streaming.bin";
+  sdca::write_dataset_file(path, sdca::make_input_feature(d, n, &X[0]),
+    sdca::make_output_multiclass(Y.begin(), Y.end()));
+
+  std::vector<Data> W_ref(d * m), A_ref(m * n);
+  auto ref = sdca::make_context(
+    sdca::make_input_feature(d, n, &X[0]),
+    sdca::make_output_multiclass(Y.begin(), Y.end()),
+    Objective<Data, Result>(objective), &A_ref[0], &W_ref[0]);
+  ref.options = options;
+  ref.criteria.epsilon = 1e-6;
+  sdca::make_solver(ref).solve();
+
+  // The features are only read from the file
+  std::vector<Data> W(d * m), A(m * n);
+  sdca::dataset_file file(path);
+  auto ctx = sdca::make_context(
+    sdca::make_input_feature(d, n, static_cast<const Data*>(nullptr)),
+    file.multiclass(), Objective<Data, Result>(objective), &A[0], &W[0]);
+  ctx.add_test(sdca::make_input_feature(d, n, &X[0]),
+    sdca::make_output_multiclass(Y.begin(), Y.end()));
+  ctx.options = options;
+  ctx.criteria.epsilon = 1e-6;
+  sdca::streaming_solver<Data, Result, sdca::multiclass_output, Objective>
+    solver(ctx, path, chunk_size);
+  solver.solve();
+  EXPECT_TRUE(ctx.status == sdca::solver_status::solved);
+
+  test_expect_same_primal(ref.train.evals.back(), ctx.train.evals.back(), 1e-5);
+  test_expect_test_as_train(ctx, 1e-5);
+  test_expect_primal_consistent(d, m, n, X, A, std::vector<Data>(), W, 1e-3);
+
+  // The file must match the training set
+  auto other = sdca::make_context(
+    sdca::make_input_feature(d + 1, n, static_cast<const Data*>(nullptr)),
+    file.multiclass(), Objective<Data, Result>(objective), &A[0], &W[0]);
+  typedef sdca::streaming_solver<Data, Result, sdca::multiclass_output,
+    Objective> solver_type;
+  EXPECT_THROW(solver_type(other, path, chunk_size), std::invalid_argument);
+  std::remove(path.c_str());
+}
+
+
+TEST(SolverStreamingTest, chunks) {
+  sdca::logging::set_level(sdca::logging::level::warning);
+  sdca::logging::set_format(sdca::logging::format::short_e);
+  sdca::solver_options options;
+  test_solver_streaming(
+    sdca::make_objective_l2_topk_hinge<float, double>(1, 1), 300, options);
+  test_solver_streaming(
+    sdca::make_objective_l2_topk_hinge<double, double>(1, 1), 64, options);
+  test_solver_streaming(
+    sdca::make_objective_l2_entropy<double, double>(1), 7, options);
+
+  options.num_threads = 2;
+  test_solver_streaming(
+    sdca::make_objective_l2_entropy<double, double>(1), 50, options);
+
+  options.num_threads = 1;
+  options.batch_size = 4;
+  test_solver_streaming(
+    sdca::make_objective_l2_topk_hinge<double, double>(1, 1), 64, options);
+}
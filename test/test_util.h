@@ -68,6 +68,91 @@ test_populate_int(
 }
 
 
+/*
+ * A random multiclass problem with n examples, d features in [0.1, 1]
+ * (stored column-wise in X) and m classes (the labels in Y).
+ */
+template <typename Data,
+          typename UIntType>
+inline void
+test_populate_multiclass(
+    const UIntType n,
+    const UIntType d,
+    const UIntType m,
+    std::mt19937& gen,
+    std::vector<Data>& X,
+    std::vector<UIntType>& Y
+  ) {
+  test_populate_real(n * d, -1, 0, static_cast<Data>(1), gen, X);
+  test_populate_int<UIntType>(n, 0, m - 1, gen, Y);
+}
+
+
+/*
+ * The primal variables W (d x m) are consistent with the dual variables
+ * A (m x n), i.e. W = W0 + X * A' (W0 is zero if it is empty).
+ */
+template <typename Data,
+          typename UIntType>
+inline void
+test_expect_primal_consistent(
+    const UIntType d,
+    const UIntType m,
+    const UIntType n,
+    const std::vector<Data>& X,
+    const std::vector<Data>& A,
+    const std::vector<Data>& W0,
+    const std::vector<Data>& W,
+    const double tolerance
+  ) {
+  for (UIntType c = 0; c < m; ++c) {
+    for (UIntType k = 0; k < d; ++k) {
+      double w_check = W0.empty() ? 0 : static_cast<double>(W0[d * c + k]);
+      for (UIntType i = 0; i < n; ++i) {
+        w_check += static_cast<double>(X[d * i + k])
+                 * static_cast<double>(A[m * i + c]);
+      }
+      double w = static_cast<double>(W[d * c + k]);
+      EXPECT_NEAR(w_check, w, tolerance * (1 + std::abs(w)));
+    }
+  }
+}
+
+
+/*
+ * Both evaluations are within the (relative) duality gap of each other.
+ */
+template <typename Evaluation,
+          typename ReferenceEvaluation>
+inline void
+test_expect_same_primal(
+    const ReferenceEvaluation& ref,
+    const Evaluation& eval,
+    const double tolerance
+  ) {
+  double primal_ref = static_cast<double>(ref.primal);
+  EXPECT_NEAR(primal_ref, static_cast<double>(eval.primal),
+              tolerance * std::abs(primal_ref));
+}
+
+
+/*
+ * The first test set of the context is its training set,
+ * so the (last evaluated) primal losses of both must agree.
+ */
+template <typename Context>
+inline void
+test_expect_test_as_train(
+    const Context& ctx,
+    const double tolerance
+  ) {
+  const auto& train = ctx.train.evals.back();
+  EXPECT_NEAR(static_cast<double>(train.primal_loss),
+              static_cast<double>(ctx.test[0].evals.back().primal_loss),
+              tolerance * std::abs(static_cast<double>(train.primal)));
+}
+
+
 template <typename Type>
 inline void
 test_add_0_1_eps_min(const Type coeff, std::vector<Type>& v) {